@@ -2,8 +2,11 @@
 #include <cmath>
 #include <vector>
 #include <deque>
+#include <memory>
+#include <string>
 #include <SDL3/SDL.h>
 #include "WaterEffect.h"
+#include "WaterTrace.h"
 
 
 const int GRID_SIZE = 200;
@@ -13,6 +16,16 @@ SDL_Texture* texture = nullptr;
 
 
 int main(int argc, char* argv[]) {
+    // --record trace.bin 把参数、点击和帧时间录制为轨迹，可用 WaterTraceReplay 无窗口重放
+    const char* recordPath = nullptr;
+    std::unique_ptr<WaterTraceRecorder> recorder;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--record") {
+            recordPath = argv[i + 1];
+            recorder = std::make_unique<WaterTraceRecorder>();
+        }
+    }
+
     if (!SDL_Init(SDL_INIT_VIDEO)) {
         SDL_Log("SDL Initialization Failed: %s", SDL_GetError());
         return -1;
@@ -26,17 +39,30 @@ int main(int argc, char* argv[]) {
     }
 
     SDL_SetRenderVSync(renderer, 1);
+    // 按固定的逻辑尺寸拉伸到窗口，不再需要额外的全窗口渲染纹理
+    SDL_SetRenderLogicalPresentation(renderer, windowWidth, windowHeight, SDL_LOGICAL_PRESENTATION_STRETCH);
 
     SDL_Surface* surface = SDL_LoadBMP("water_effect.bmp");
     texture = SDL_CreateTextureFromSurface(renderer, surface);
     SDL_DestroySurface(surface);
 
-    auto waterTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_TARGET, windowWidth, windowHeight);
-
     WaterEffect waterEffect(window, renderer);
 
     waterEffect.applyPresetParams();
-    waterEffect.initGrid(200, windowWidth, windowHeight);
+    waterEffect.initGrid(GRID_SIZE, windowWidth, windowHeight);
+    if (recorder) {
+        // 自动调整网格尺寸取决于运行时的耗时，录制时关闭以保证重放结果一致
+        recorder->recordInitGrid(GRID_SIZE, static_cast<float>(windowWidth), static_cast<float>(windowHeight));
+        recorder->recordParams(waterEffect);
+    }
+    else {
+        // 按每帧2毫秒的更新预算在 50~400 之间自动调整网格尺寸
+        waterEffect.setAdaptiveGridSize(2.0f, 50, 400);
+    }
+
+    // 默认直接扭曲背景纹理；C 键切换为半分辨率画布，演示先把任意内容绘制到画布再扭曲的用法
+    bool useCanvas = false;
+    waterEffect.setCanvasScale(0.5f);
 
     bool is_active = true;
     while (is_active) {
@@ -50,26 +76,82 @@ int main(int argc, char* argv[]) {
                 int w, h;
                 SDL_GetWindowSizeInPixels(window, &w, &h);
 
-                waterEffect.addDefaultClickRipple(event.button.x * windowWidth / w, event.button.y * windowHeight / h, static_cast<float>(SDL_GetTicks()) / 1000.0f);
+                float x = event.button.x * windowWidth / w;
+                float y = event.button.y * windowHeight / h;
+                float time = static_cast<float>(SDL_GetTicks()) / 1000.0f;
+                waterEffect.addDefaultClickRipple(x, y, time);
+                if (recorder) {
+                    recorder->recordClick(x, y, time);
+                }
+            }
+            // 高度场模式下按住鼠标拖动时沿轨迹持续注入冲击
+            if (event.type == SDL_EVENT_MOUSE_MOTION && event.motion.state != 0 && waterEffect.getClickRippleEngine() == WaterClickRippleEngine::HeightField)
+            {
+                int w, h;
+                SDL_GetWindowSizeInPixels(window, &w, &h);
+
+                float x = event.motion.x * windowWidth / w;
+                float y = event.motion.y * windowHeight / h;
+                waterEffect.addImpulse(x, y, 3.0f, 16.0f);
+                if (recorder) {
+                    recorder->recordImpulse(x, y, 3.0f, 16.0f);
+                }
+            }
+            // H 键在解析点击波纹和高度场之间切换
+            if (event.type == SDL_EVENT_KEY_DOWN && event.key.key == SDLK_H)
+            {
+                bool heightField = waterEffect.getClickRippleEngine() == WaterClickRippleEngine::HeightField;
+                waterEffect.setClickRippleEngine(heightField ? WaterClickRippleEngine::Analytic : WaterClickRippleEngine::HeightField);
+                if (recorder) {
+                    recorder->recordSettings(waterEffect);
+                }
+            }
+            if (event.type == SDL_EVENT_KEY_DOWN && event.key.key == SDLK_C)
+            {
+                useCanvas = !useCanvas;
+            }
+            // P 键切换流水线模式：后台线程计算下一帧顶点的同时提交本帧几何体
+            if (event.type == SDL_EVENT_KEY_DOWN && event.key.key == SDLK_P)
+            {
+                waterEffect.setPipelined(!waterEffect.getPipelined());
+                if (recorder) {
+                    recorder->recordPipelined(waterEffect.getPipelined());
+                }
+            }
+            // M 键切换自适应网格：只在波纹变化剧烈的地方细分，平静水面的顶点数随之减少
+            if (event.type == SDL_EVENT_KEY_DOWN && event.key.key == SDLK_M)
+            {
+                WaterQuadtreeMeshParams quadtree = waterEffect.getQuadtreeMeshParams();
+                quadtree.enabled = !quadtree.enabled;
+                waterEffect.setQuadtreeMeshParams(quadtree);
+                if (recorder) {
+                    recorder->recordQuadtree(quadtree);
+                }
             }
         }
-        SDL_SetRenderTarget(renderer, waterTexture);
         SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
         SDL_RenderClear(renderer);
 
-        waterEffect.setupEffectCanvas();
-
-        SDL_RenderTexture(renderer, texture, nullptr, nullptr);
-
-        waterEffect.renderEffect(static_cast<float>(SDL_GetTicks()) / 1000.0f);
-
-        SDL_SetRenderTarget(renderer, nullptr);
-
-        SDL_RenderTexture(renderer, waterTexture, nullptr, nullptr);
+        float time = static_cast<float>(SDL_GetTicks()) / 1000.0f;
+        if (useCanvas) {
+            waterEffect.setupEffectCanvas();
+            SDL_RenderTexture(renderer, texture, nullptr, nullptr);
+            waterEffect.renderEffect(time);
+        }
+        else {
+            waterEffect.renderTexture(texture, time);
+        }
+        if (recorder) {
+            recorder->recordFrame(time);
+        }
 
         SDL_RenderPresent(renderer);
     }
 
+    if (recorder && !recorder->save(recordPath)) {
+        SDL_Log("Saving trace %s failed", recordPath);
+    }
+
     SDL_DestroyTexture(texture);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
@@ -1,5 +1,6 @@
-﻿#define _USE_MATH_DEFINES 
+﻿#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include "WaterEffect.h"
 
 
@@ -14,16 +15,33 @@ WaterEffect::WaterEffect(SDL_Window* window, SDL_Renderer* renderer)
 	_renderer = renderer;
 }
 
+/**
+ * @brief 析构函数实现
+ * @details 等待进行中的后台更新完成（它可能正在写入本对象的顶点缓冲区），再释放画布纹理
+ */
+WaterEffect::~WaterEffect()
+{
+	finishUpdate();
+	if (_waterEffectCanvas != nullptr)
+	{
+		SDL_DestroyTexture(_waterEffectCanvas);
+	}
+}
+
 /**
  * @brief 准备特效渲染画布
- * @details 保存当前渲染目标，设置水波纹纹理为渲染目标并清空画布
+ * @details 保存当前渲染目标，设置水波纹纹理为渲染目标并清空画布。
+ * 画布在第一次调用时按绘制区域尺寸和 setCanvasScale 的比例创建，缩小时设置相同比例的渲染缩放，
+ * 调用方仍按绘制区域坐标绘制。initGrid 之前或绘制区域为空时没有画布，绘制到原始渲染目标
  */
 void WaterEffect::setupEffectCanvas()
 {
 	_originalRenderTarget = SDL_GetRenderTarget(_renderer);
-	if (_waterEffectCanvas != nullptr)
+	_prepareCanvas();
+	if (_waterEffectCanvas != nullptr && _areaWidth > 0 && _areaHeight > 0)
 	{
 		SDL_SetRenderTarget(_renderer, _waterEffectCanvas);
+		SDL_SetRenderScale(_renderer, static_cast<float>(_canvasWidth) / _areaWidth, static_cast<float>(_canvasHeight) / _areaHeight);
 	}
 	SDL_SetRenderDrawColor(_renderer, 0, 0, 0, 0);
 	SDL_RenderClear(_renderer);
@@ -32,267 +50,223 @@ void WaterEffect::setupEffectCanvas()
 /**
  * @brief 渲染水波纹效果
  * @param time 当前时间（秒）
- * @details 1. 恢复原始渲染目标 2. 更新顶点位置 3. 渲染波纹几何体
+ * @details 1. 恢复原始渲染目标 2. 推进后台网格切换并调整自适应网格 3. 更新顶点位置 4. 以画布为纹理渲染波纹几何体。
+ * 流水线模式下第3步换入上一帧在后台计算好的顶点，并在提交几何体之前开始后台计算下一帧
  */
 void WaterEffect::renderEffect(float time)
 {
 	SDL_SetRenderTarget(_renderer, _originalRenderTarget);
-	_update(time);
-	SDL_RenderGeometry(_renderer, _waterEffectCanvas, _vertices.data(), _vertices.size(), _indices.data(), _indices.size());
+	_renderMesh(_waterEffectCanvas, time);
 }
 
 /**
- * @brief 应用预设参数配置
- * @details 配置包含两组直线波纹+一组固定波纹的默认效果
+ * @brief 直接以指定纹理渲染水波纹效果
+ * @param texture 被扭曲的纹理，按网格纹理坐标 [0, 1] 采样其全部内容
+ * @param time 当前时间（秒）
+ * @details 不经过中间画布，也不需要调用 setupEffectCanvas：在当前渲染目标上推进后台网格切换、
+ * 更新顶点位置并以 texture 为纹理提交波纹几何体。适合只扭曲一张背景纹理的场合，
+ * 省去把背景绘制到画布以及画布本身占用的显存；纹理尺寸不必与绘制区域相同
  */
-void WaterEffect::applyPresetParams()
+void WaterEffect::renderTexture(SDL_Texture* texture, float time)
 {
-	clearParams();
-
-	setMaxClickRipple(5);
-	WaterRippleParams fixedRippleParams;
-	fixedRippleParams.amplitude = 15.0f;
-	fixedRippleParams.density = 0.015f;
-	fixedRippleParams.frequency = 5.0f;
-	fixedRippleParams.pos = { -100.0f, 600.0f };
-	addFixedRipple(fixedRippleParams);
-
-	WaterWaveParams waveParams;
-	waveParams.amplitude = 5.0f;
-	waveParams.angle = 5 * M_PI / 6;
-	waveParams.density = 0.02f;
-	waveParams.frequency = 8.0f;
-	waveParams.phi = 1.0f;
-	addWave(waveParams);
-
-	waveParams.amplitude = 8.0f;
-	waveParams.angle = 7 * M_PI / 6;
-	waveParams.density = 0.01f;
-	waveParams.frequency = 3.0f;
-	waveParams.phi = 0.0f;
-	addWave(waveParams);
-
-	WaterLightParams lightParams;
-	lightParams.decay = 10.0f;
-	lightParams.defaultAlpha = 0.9f;
-	lightParams.angle = 5 * M_PI / 4;
-	lightParams.minAlpha = 0.85f;
-	lightParams.minDistance = 0.0f;
-	setLightParams(lightParams);
+	_renderMesh(texture, time);
+}
 
-	WaterClickRippleParams waterClickRippleParams;
-	waterClickRippleParams.lifeTime = 5.0f;
-	waterClickRippleParams.rippleParams.amplitude = 30.0f;
-	waterClickRippleParams.rippleParams.density = 0.02f;
-	waterClickRippleParams.rippleParams.frequency = 10.0f;
-	setDefaultClickRippleParams(waterClickRippleParams);
+/**
+ * @brief 设置画布相对绘制区域的比例
+ * @param scale 比例，限制在 (0, 1]（默认1）
+ * @details 画布按 绘制区域尺寸×scale（向上取整）创建，渲染时再拉伸到绘制区域，
+ * 以较低的画面清晰度换取更少的填充像素和显存，适合大窗口和高DPI显示。下次 setupEffectCanvas 时生效
+ */
+void WaterEffect::setCanvasScale(float scale)
+{
+	_canvasScale = scale > 0.0f ? std::min(scale, 1.0f) : 1.0f;
 }
 
 /**
- * @brief 重置所有水波纹参数为默认值
- * @details 清除所有自定义波纹配置（包括直线波纹、固定波纹和点击波纹），恢复为初始状态
+ * @brief 获取画布相对绘制区域的比例
+ * @return 比例
  */
-void WaterEffect::clearParams()
+float WaterEffect::getCanvasScale() const
 {
-	WaterEffectParams defaultParams;
-	_params = defaultParams;
+	return _canvasScale;
 }
 
 /**
- * @brief 添加直线传播的波纹效果
- * @param params 直线波纹参数配置
- * @details 根据角度参数计算法向量并存储预计算数据
+ * @brief 更新顶点并以指定纹理提交波纹几何体
+ * @param texture 纹理
+ * @param time 当前时间（秒）
  */
-void WaterEffect::addWave(WaterWaveParams params)
+void WaterEffect::_renderMesh(SDL_Texture* texture, float time)
 {
-	WaterWaveCalculatedParams cParams;
-	cParams.basicParams = params;
-	cParams.A = std::cos(params.angle);
-	cParams.B = -std::sin(params.angle);
+	finishUpdate();
+	_stepGridRebuild();
+	refineMesh(time);
+	if (getMeshRevision() != _meshRevision)
+	{
+		_syncMesh();
+	}
+	if (_mesh.positions.empty())
+	{
+		return;
+	}
+	if (_pipelined)
+	{
+		_updatePipelined(time);
+	}
+	else
+	{
+		update(time, _meshOutput(_mesh.positions, _mesh.colors));
+	}
 
-	_params.waves.push_back(cParams);
+	int vertexCount = static_cast<int>(_mesh.positions.size());
+	const float* xy = &_mesh.positions[0].x;
+	const float* uv = &_mesh.texCoords[0].x;
+#if WATER_EFFECT_STATS
+	Uint64 submitStart = SDL_GetPerformanceCounter();
+#endif
+	if (!_mesh.indices16.empty())
+	{
+		SDL_RenderGeometryRaw(_renderer, texture, xy, sizeof(SDL_FPoint), _mesh.colors.data(), sizeof(SDL_FColor), uv, sizeof(SDL_FPoint),
+			vertexCount, _mesh.indices16.data(), static_cast<int>(_mesh.indices16.size()), sizeof(Uint16));
+	}
+	else
+	{
+		SDL_RenderGeometryRaw(_renderer, texture, xy, sizeof(SDL_FPoint), _mesh.colors.data(), sizeof(SDL_FColor), uv, sizeof(SDL_FPoint),
+			vertexCount, _mesh.indices32.data(), static_cast<int>(_mesh.indices32.size()), sizeof(int));
+	}
+#if WATER_EFFECT_STATS
+	float submitMs = static_cast<float>(static_cast<double>(SDL_GetPerformanceCounter() - submitStart) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency()));
+	// 每次提交都会上传全部顶点属性和索引
+	size_t indexCount = !_mesh.indices16.empty() ? _mesh.indices16.size() : _mesh.indices32.size();
+	size_t indexBytes = !_mesh.indices16.empty() ? indexCount * sizeof(Uint16) : indexCount * sizeof(int);
+	size_t vertexBytes = _mesh.positions.size() * (sizeof(SDL_FPoint) + sizeof(SDL_FColor) + sizeof(SDL_FPoint));
+	_recordSubmission(submitMs, indexCount, vertexBytes + indexBytes);
+	_logStats(time);
+#endif
 }
 
 /**
- * @brief 添加固定位置的波纹源
- * @param params 固定波纹参数配置
- * @details 固定波纹会持续产生环形波纹效果
+ * @brief 设置流水线模式
+ * @param enabled 是否启用（默认关闭）
+ * @details 启用后顶点位置和颜色使用两组缓冲区：renderEffect 提交上一帧在后台线程计算好的一组，
+ * 同时由后台线程按预测的下一帧时间（本帧时间加上一帧间隔）计算另一组，渲染线程只交换两组缓冲区。
+ * 顶点计算不再增加渲染线程的耗时，代价是画面和点击响应晚一帧、占用一个额外的线程和一组顶点缓冲区；
+ * 两组缓冲区交替写出，每帧都完整写出全部顶点。initGrid、resize、网格切换后的第一帧同步计算
  */
-void WaterEffect::addFixedRipple(WaterRippleParams params)
+void WaterEffect::setPipelined(bool enabled)
 {
-	_params.fixedRipples.push_back(params);
+	finishUpdate();
+	_pipelined = enabled;
+	_backReady = false;
+	_lastFrameTimeValid = false;
+	if (!enabled)
+	{
+		std::vector<SDL_FPoint>().swap(_backPositions);
+		std::vector<SDL_FColor>().swap(_backColors);
+	}
 }
 
 /**
- * @brief 设置默认的点击波纹参数模板
- * @param params 点击波纹默认配置
- * @details 此配置将用于后续通过 addDefaultClickRipple 添加的波纹
+ * @brief 获取是否启用流水线模式
+ * @return 启用时返回true
  */
-void WaterEffect::setDefaultClickRippleParams(WaterClickRippleParams params)
+bool WaterEffect::getPipelined() const
 {
-	_params.defaultClickRipple = params;
+	return _pipelined;
 }
 
 /**
- * @brief 添加自定义点击波纹效果
- * @param params 点击波纹完整参数配置
- * @details 直接使用传入参数创建点击波纹，不受默认参数影响
+ * @brief 设置性能统计的日志间隔
+ * @param seconds 间隔（秒），小于等于0时不输出（默认）
+ * @details 启用后 renderEffect 每隔指定时间通过 SDL_Log 输出一行 getStats 的汇总；
+ * WATER_EFFECT_STATS 为0时不做任何事
  */
-void WaterEffect::addClickRipple(WaterClickRippleParams params)
+void WaterEffect::setStatsLogInterval(float seconds)
 {
-	if (_params.clickRipples.size() >= _params.maxClickRipple)
-	{
-		return;
-	}
-	_params.clickRipples.push_back(params);
+	_statsLogInterval = seconds > 0.0f ? seconds : 0.0f;
+	_statsLogTime = 0.0f;
 }
 
 /**
- * @brief 使用默认参数添加点击波纹
- * @param x 点击位置的X坐标
- * @param y 点击位置的Y坐标
- * @param startTime 波纹起始时间（秒）
- * @details 基于预设的默认参数在指定位置生成点击波纹
+ * @brief 获取当前绘制的顶点位置
+ * @return 最近一次 renderEffect 写出的顶点位置，后台网格切换完成前为当前网格的顶点
  */
-void WaterEffect::addDefaultClickRipple(float x, float y, float startTime)
+const std::vector<SDL_FPoint>& WaterEffect::getMeshPositions() const
 {
-	WaterClickRippleParams params;
-	params = _params.defaultClickRipple;
-	params.startTime = startTime;
-	params.rippleParams.pos = { x, y };
-	addClickRipple(params);
+	return _mesh.positions;
 }
 
 /**
- * @brief 设置光线效果参数
- * @param params 光线配置参数
- * @details 控制波纹的透明度变化效果（光照模拟）
+ * @brief 获取当前绘制的顶点颜色
+ * @return 最近一次 renderEffect 写出的顶点颜色（RGB固定为白色）
  */
-void WaterEffect::setLightParams(WaterLightParams params)
+const std::vector<SDL_FColor>& WaterEffect::getMeshColors() const
 {
-	_params.light = params;
+	return _mesh.colors;
 }
 
 /**
- * @brief 设置最大点击波纹数量
- * @param count 允许同时存在的最大点击波纹数
- * @details 当超过此数量时，新的点击波纹将被忽略
+ * @brief 生成指向一组顶点缓冲区的输出描述
+ * @param positions 顶点位置
+ * @param colors 顶点颜色，只写入透明度
+ * @return 输出缓冲区
  */
-void WaterEffect::setMaxClickRipple(int count)
+WaterVertexSpan WaterEffect::_meshOutput(std::vector<SDL_FPoint>& positions, std::vector<SDL_FColor>& colors)
 {
-	_params.maxClickRipple = count;
+	WaterVertexSpan output;
+	output.x = &positions[0].x;
+	output.y = &positions[0].y;
+	output.alpha = &colors[0].a;
+	output.stride = sizeof(SDL_FPoint);
+	output.alphaStride = sizeof(SDL_FColor);
+	return output;
 }
 
 /**
- * @brief 更新波纹效果（每帧调用）
+ * @brief 流水线模式下更新顶点
  * @param time 当前时间（秒）
- * @details 计算所有波纹的叠加效果并更新顶点位置：
- * 1. 计算直线波纹偏移
- * 2. 计算固定波纹偏移
- * 3. 更新点击波纹（含生命周期管理）
- * 4. 应用边界约束
- * 5. 计算顶点透明度变化
+ * @details 后台缓冲区已按当前网格计算好时与当前缓冲区交换，否则本帧同步计算并初始化后台缓冲区；
+ * 随后按预测的下一帧时间开始后台计算
  */
-void WaterEffect::_update(float time)
+void WaterEffect::_updatePipelined(float time)
 {
-	for (size_t i = 0; i < _vertices.size(); i++)
+	if (_backReady && _backPositions.size() == _mesh.positions.size())
 	{
-		float offset_x = 0.0f, offset_y = 0.0f;
-
-		for (auto& iter : _params.waves)
-		{
-			float x = _verticesOrigin[i].position.x;
-			float y = _verticesOrigin[i].position.y;
-			float distance_to_line = (iter.A * x + iter.B * y + iter.basicParams.phi);
-
-			float line_offset = iter.basicParams.amplitude * std::sin(iter.basicParams.frequency * time -	iter.basicParams.density * distance_to_line);
-			offset_x += line_offset * iter.A;
-			offset_y += line_offset * iter.B;
-		}
-		for (auto& iter : _params.fixedRipples)
-		{
-			float nx = iter.pos.x, ny = iter.pos.y;
-			float dx = _verticesOrigin[i].position.x - nx;
-			float dy = _verticesOrigin[i].position.y - ny;
-			float angle = atan2(-dy, dx);
-			float distance = std::sqrt(dx * dx + dy * dy);
-			offset_x += iter.amplitude * std::cos(iter.frequency * time - iter.density * distance) * cos(angle);
-			offset_y += iter.amplitude * std::cos(iter.frequency * time - iter.density * distance) * -sin(angle);
-		}
-
-		auto clickRippleParamsIter = _params.clickRipples.begin();
-		while (clickRippleParamsIter != _params.clickRipples.end())
-		{
-			auto iter = clickRippleParamsIter++;
-			if (time - iter->startTime > iter->lifeTime)
-			{
-				clickRippleParamsIter = _params.clickRipples.erase(iter);
-				continue;
-			}
-			float dx = _verticesOrigin[i].position.x - iter->rippleParams.pos.x;
-			float dy = _verticesOrigin[i].position.y - iter->rippleParams.pos.y;
-			float angle = atan2(dy, dx);
-			float distance = std::sqrt(dx * dx + dy * dy);
-			float distance_to_ripple = abs((time - iter->startTime) * iter->rippleParams.frequency - distance * iter->rippleParams.density);
-
-			offset_x += iter->rippleParams.amplitude * std::cos(distance_to_ripple) * cos(angle) * exp(-distance_to_ripple) / (time - iter->startTime + 1.0f);
-			offset_y += iter->rippleParams.amplitude * std::cos(distance_to_ripple) * sin(angle) * exp(-distance_to_ripple) / (time - iter->startTime + 1.0f);
-		}
-
-		_vertices[i].position.y = _verticesOrigin[i].position.y + offset_y;
-		_vertices[i].position.x = _verticesOrigin[i].position.x + offset_x;
-
-		int gridSize = _params.gridSize;
-		if (i % (gridSize + 1) == 0)
-		{
-			if (_vertices[i].position.x > 0.0f)
-			{
-				_vertices[i].position.x = 0.0f;
-			}
-
-		}
-		else if (i % (gridSize + 1) == gridSize)
-		{
-			if (_vertices[i].position.x < _verticesOrigin[i].position.x)
-			{
-				_vertices[i].position.x = _verticesOrigin[i].position.x;
-			}
-		}
-
-		if (i <= (gridSize + 1))
-		{
-			if (_vertices[i].position.y > 0.0f)
-			{
-				_vertices[i].position.y = 0;
-			}
-		}
-		else if (i >= (gridSize + 1) * gridSize)
-		{
-			if (_vertices[i].position.y < _verticesOrigin[i].position.y)
-			{
-				_vertices[i].position.y = _verticesOrigin[i].position.y;
-			}
-		}
-
-		float dx = _vertices[i].position.x - _verticesLast[i].position.x;
-		float dy = _vertices[i].position.y - _verticesLast[i].position.y;
-
-		float distance = std::sqrt(dx * dx + dy * dy);
-
-		if (distance > _params.light.minDistance)
-		{
-			_vertices[i].color.a = (distance - _params.light.minDistance) * cos(atan2(-dy, dx) - _params.light.angle) / _params.light.decay + _params.light.defaultAlpha;
-		}
-		else
-		{
-			_vertices[i].color.a = _params.light.defaultAlpha;
-		}
-
-		_vertices[i].color.a = SDL_clamp(_vertices[i].color.a, _verticesLast[i].color.a - 0.1f, _verticesLast[i].color.a + 0.1f);
-		_vertices[i].color.a = SDL_clamp(_vertices[i].color.a, _params.light.minAlpha, 1.0f);
+		_mesh.positions.swap(_backPositions);
+		_mesh.colors.swap(_backColors);
+	}
+	else
+	{
+		update(time, _meshOutput(_mesh.positions, _mesh.colors));
+		_backPositions = _mesh.positions;
+		_backColors = _mesh.colors;
+	}
+	float interval = _lastFrameTimeValid && time > _lastFrameTime ? time - _lastFrameTime : 1.0f / 60.0f;
+	_lastFrameTime = time;
+	_lastFrameTimeValid = true;
+	beginUpdate(time + interval, _meshOutput(_backPositions, _backColors));
+	_backReady = true;
+}
 
-		_verticesLast[i] = _vertices[i];
+/**
+ * @brief 按日志间隔输出性能统计
+ * @param time 当前时间（秒）
+ */
+void WaterEffect::_logStats(float time)
+{
+	if (_statsLogInterval <= 0.0f || (time >= _statsLogTime && time < _statsLogTime + _statsLogInterval))
+	{
+		return;
 	}
+	_statsLogTime = time;
+	WaterStats stats = getStats();
+	SDL_Log("WaterEffect: update %.3f/%.3f/%.3f ms (min/avg/p99), waves %.3f, fixed %.3f, click %.3f, boundary %.3f, lighting %.3f ms avg, "
+		"submit %.3f/%.3f/%.3f ms, %zu vertices, %zu indices, %zu click ripples (%llu dropped), %zu bytes/frame",
+		stats.update.minMs, stats.update.avgMs, stats.update.p99Ms,
+		stats.waves.avgMs, stats.fixedRipples.avgMs, stats.clickRipples.avgMs, stats.boundary.avgMs, stats.lighting.avgMs,
+		stats.submit.minMs, stats.submit.avgMs, stats.submit.p99Ms,
+		stats.vertexCount, stats.indexCount, stats.activeClickRipples, stats.droppedClickRipples, stats.uploadedBytes);
 }
 
 /**
@@ -301,10 +275,11 @@ void WaterEffect::_update(float time)
  * @param width 绘制区域宽度
  * @param height 绘制区域高度
  * @details 根据给定大小和网格分辨率创建顶点数据：
- * 1. 创建渲染纹理
- * 2. 计算网格顶点位置
- * 3. 生成三角面索引
- * @note 绘制区域尺寸变化后需要重新调用此函数
+ * 1. 记录绘制区域尺寸，渲染纹理在 setupEffectCanvas 时按需创建（尺寸不变时复用）
+ * 2. 由 WaterField 计算网格顶点位置
+ * 3. 生成纹理坐标和三角面索引（网格拓扑不变时保留原有数据）
+ * 会取消进行中的后台网格切换
+ * @note 只有绘制区域尺寸变化时应调用 resize，它复用现有纹理以外的全部缓冲区
  */
 void WaterEffect::initGrid(int gridSize, int width, int height)
 {
@@ -313,65 +288,236 @@ void WaterEffect::initGrid(int gridSize, int width, int height)
 	{
 		return;
 	}
-	_params.gridSize = gridSize;
+	finishUpdate();
+	_backReady = false;
+	_areaWidth = width;
+	_areaHeight = height;
+	WaterField::initGrid(gridSize, static_cast<float>(width), static_cast<float>(height));
+
+	_pendingMesh = PendingMesh();
+	if (getMeshRevision() != _meshRevision)
+	{
+		_syncMesh();
+	}
+}
+
+/**
+ * @brief 调整绘制区域尺寸
+ * @param width 新的绘制区域宽度
+ * @param height 新的绘制区域高度
+ * @details 网格尺寸不变，纹理坐标和索引保持不变，顶点位置由 WaterField 在原有缓冲区中重新计算；
+ * 只有尺寸确实变化时，下次 setupEffectCanvas 才重新创建渲染纹理。适合窗口拖动缩放时每帧调用
+ */
+void WaterEffect::resize(int width, int height)
+{
+	finishUpdate();
+	_backReady = false;
+	_areaWidth = width;
+	_areaHeight = height;
+	WaterField::resize(static_cast<float>(width), static_cast<float>(height));
+}
+
+/**
+ * @brief 按绘制区域尺寸和画布比例准备渲染纹理
+ * @details 尺寸与现有纹理相同时直接复用；绘制区域为空时（initGrid 之前）不创建
+ */
+void WaterEffect::_prepareCanvas()
+{
+	if (_areaWidth <= 0 || _areaHeight <= 0)
+	{
+		return;
+	}
+	int width = std::max(1, static_cast<int>(std::ceil(_areaWidth * _canvasScale)));
+	int height = std::max(1, static_cast<int>(std::ceil(_areaHeight * _canvasScale)));
+	if (_waterEffectCanvas != nullptr && width == _canvasWidth && height == _canvasHeight)
+	{
+		return;
+	}
 	if (_waterEffectCanvas != nullptr)
 	{
 		SDL_DestroyTexture(_waterEffectCanvas);
 		_waterEffectCanvas = nullptr;
 	}
-	_verticesOrigin.clear();
-	_vertices.clear();
-	_indices.clear();
-
 	_waterEffectCanvas = SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
-	float cellW = static_cast<float>(width) / gridSize;
-	float cellH = static_cast<float>(height) / gridSize;
-	float rowY = 0.0f;
-	float coordY = 0.0f;
-	for (int y = 0; y <= gridSize; ++y)
+	_canvasWidth = width;
+	_canvasHeight = height;
+}
+
+/**
+ * @brief 推进后台网格切换
+ * @details WaterField 有进行中的网格重建时，同步分帧生成对应的顶点数据和索引，
+ * 两者都完成后一起换入，切换前继续绘制当前网格。使用自适应网格时不需要预先生成，提交后按新网格生成
+ */
+void WaterEffect::_stepGridRebuild()
+{
+	int gridSize = getPendingGridSize();
+	if (gridSize != _pendingMesh.gridSize)
+	{
+		_pendingMesh = PendingMesh();
+		_pendingMesh.gridSize = gridSize;
+	}
+	if (gridSize == 0)
+	{
+		return;
+	}
+	bool meshReady = isQuadtreeMeshActive() || _stepPendingMesh(getGridRebuildBudget());
+	bool fieldReady = stepGridRebuild();
+	if (meshReady && fieldReady)
+	{
+		commitGridRebuild();
+		if (isQuadtreeMeshActive())
+		{
+			_syncMesh();
+		}
+		else
+		{
+			_mesh.swap(_pendingMesh.mesh);
+			_meshRevision = getMeshRevision();
+		}
+		_pendingMesh = PendingMesh();
+		_backReady = false;
+	}
+}
+
+/**
+ * @brief 按 WaterField 当前的网格拓扑重新生成顶点数据和索引
+ * @details 均匀网格一次生成全部行；自适应网格的纹理坐标由顶点原始坐标换算，索引取自 getMeshIndices。
+ * 顶点数量变化后后台缓冲区需要按新网格重新计算
+ */
+void WaterEffect::_syncMesh()
+{
+	_meshRevision = getMeshRevision();
+	_backReady = false;
+	if (!isQuadtreeMeshActive())
 	{
+		_pendingMesh = PendingMesh();
+		_pendingMesh.gridSize = getGridSize();
+		_stepPendingMesh(SIZE_MAX);
+		_mesh.swap(_pendingMesh.mesh);
+		_pendingMesh = PendingMesh();
+		return;
+	}
+
+	size_t count = getVertexCount();
+	const float* originX = getOriginX();
+	const float* originY = getOriginY();
+	_mesh.positions.assign(count, SDL_FPoint{ 0.0f, 0.0f });
+	_mesh.colors.assign(count, SDL_FColor{ 1.0f, 1.0f, 1.0f, 1.0f });
+	_mesh.texCoords.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		_mesh.texCoords[i] = { originX[i] / _areaWidth, originY[i] / _areaHeight };
+	}
+	const std::vector<unsigned int>& indices = getMeshIndices();
+	_mesh.indices16.clear();
+	_mesh.indices32.clear();
+	if (count <= 65536)
+	{
+		_mesh.indices16.assign(indices.begin(), indices.end());
+	}
+	else
+	{
+		_mesh.indices32.assign(indices.begin(), indices.end());
+	}
+}
+
+/**
+ * @brief 交换两个网格的全部数据
+ * @param other 另一个网格
+ */
+void WaterEffect::Mesh::swap(Mesh& other)
+{
+	positions.swap(other.positions);
+	colors.swap(other.colors);
+	texCoords.swap(other.texCoords);
+	indices16.swap(other.indices16);
+	indices32.swap(other.indices32);
+}
+
+/**
+ * @brief 追加一行格子的三角面索引
+ * @param indices 索引数组
+ * @param y 格子行号
+ * @param gridSize 网格尺寸
+ */
+template <typename Index>
+static void appendRowIndices(std::vector<Index>& indices, int y, int gridSize)
+{
+	for (int x = 0; x < gridSize; ++x) {
+		int topLeft = y * (gridSize + 1) + x;
+		int topRight = topLeft + 1;
+		int bottomLeft = (y + 1) * (gridSize + 1) + x;
+		int bottomRight = bottomLeft + 1;
+
+		indices.push_back(static_cast<Index>(topLeft));
+		indices.push_back(static_cast<Index>(topRight));
+		indices.push_back(static_cast<Index>(bottomLeft));
+
+		indices.push_back(static_cast<Index>(topRight));
+		indices.push_back(static_cast<Index>(bottomRight));
+		indices.push_back(static_cast<Index>(bottomLeft));
+	}
+}
+
+/**
+ * @brief 生成后台网格的顶点数据和索引
+ * @param budget 本次最多生成的顶点数量
+ * @return 全部生成完时返回true
+ * @details 只生成纹理坐标、颜色和三角面索引，顶点位置和透明度在每帧 update 时写入
+ */
+bool WaterEffect::_stepPendingMesh(size_t budget)
+{
+	PendingMesh& pending = _pendingMesh;
+	Mesh& mesh = pending.mesh;
+	int gridSize = pending.gridSize;
+	size_t columns = static_cast<size_t>(gridSize) + 1;
+	bool shortIndices = columns * columns <= 65536;
+	if (pending.nextRow == 0)
+	{
+		mesh.positions.assign(columns * columns, SDL_FPoint{ 0.0f, 0.0f });
+		mesh.colors.assign(columns * columns, SDL_FColor{ 1.0f, 1.0f, 1.0f, 1.0f });
+		mesh.texCoords.reserve(columns * columns);
+		if (shortIndices)
+		{
+			mesh.indices16.reserve(static_cast<size_t>(gridSize) * gridSize * 6);
+		}
+		else
+		{
+			mesh.indices32.reserve(static_cast<size_t>(gridSize) * gridSize * 6);
+		}
+	}
+	size_t work = 0;
+	for (; pending.nextRow <= gridSize && work < budget; pending.nextRow++)
+	{
+		int y = pending.nextRow;
 		if (y == gridSize)
 		{
-			rowY = static_cast<float>(height);
-			coordY = 1.0f;
+			pending.coordY = 1.0f;
 		}
-		float columnX = 0.0f;
 		float coordX = 0.0f;
 		for (int x = 0; x <= gridSize; ++x) {
 			if (x == gridSize)
 			{
-				columnX = static_cast<float>(width);
 				coordX = 1.0f;
 			}
-			SDL_Vertex v;
-			v.position = { columnX, rowY };
-			v.tex_coord = { coordX, coordY };
-			v.color = { 1.0f, 1.0f, 1.0f, _params.light.defaultAlpha };
-			_vertices.push_back(v);
-			_verticesOrigin.push_back(v);
-			_verticesLast.push_back(v);
-			columnX += cellW;
+			mesh.texCoords.push_back({ coordX, pending.coordY });
 			coordX += 1.0f / gridSize;
 		}
-		rowY += cellH;
-		coordY += 1.0f / gridSize;
-	}
+		pending.coordY += 1.0f / gridSize;
+		work += gridSize + 1;
 
-	for (int y = 0; y < gridSize; ++y) {
-		for (int x = 0; x < gridSize; ++x) {
-			int topLeft = y * (gridSize + 1) + x;
-			int topRight = topLeft + 1;
-			int bottomLeft = (y + 1) * (gridSize + 1) + x;
-			int bottomRight = bottomLeft + 1;
-
-			_indices.push_back(topLeft);
-			_indices.push_back(topRight);
-			_indices.push_back(bottomLeft);
-
-			_indices.push_back(topRight);
-			_indices.push_back(bottomRight);
-			_indices.push_back(bottomLeft);
+		if (y == gridSize)
+		{
+			continue;
+		}
+		if (shortIndices)
+		{
+			appendRowIndices(mesh.indices16, y, gridSize);
+		}
+		else
+		{
+			appendRowIndices(mesh.indices32, y, gridSize);
 		}
 	}
+	return pending.nextRow > gridSize;
 }
-
@@ -1,91 +1,17 @@
 ﻿#pragma once
-#include <list>
 #include <vector>
 #include <SDL3/SDL.h>
+#include "WaterField.h"
 
 
 /**
- * @struct WaterRippleParams
- * @brief 基础波纹效果参数
- * @details 定义单个波纹的物理属性和位置信息
+ * @class WaterEffect
+ * @brief 水波纹效果的SDL渲染适配层
+ * @details 波纹参数和顶点计算由 WaterField 完成，本类负责渲染纹理、顶点数据和三角面索引。
+ * 顶点数据按属性分开存储：每帧由 WaterField 写入的位置数组和颜色数组（RGB固定为白色，只写透明度），
+ * 以及网格不变时不再修改的纹理坐标数组；顶点数不超过65536时使用16位索引，通过 SDL_RenderGeometryRaw 提交绘制
  */
-struct WaterRippleParams
-{
-	float amplitude = 0.0f;				///< 波纹振幅（影响波动强度）
-	float frequency = 0.0f;				///< 波纹频率（控制波动速度）
-	float density = 0.0f;				///< 波纹密度（影响传播衰减）
-	SDL_FPoint pos = { 0.0f, 0.0f };		///< 波纹中心位置坐标
-};
-
-/**
- * @struct WaterClickRippleParams
- * @brief 点击触发的波纹参数
- * @details 包含动态波纹的时间属性和基础物理参数
- */
-struct WaterClickRippleParams
-{
-	WaterRippleParams rippleParams;		///< 基础波纹物理参数
-	float startTime = 0.0f;				///< 波纹起始时间（单位：秒）
-	float lifeTime = 0.0f;				///< 波纹生命周期（单位：秒）
-};
-
-/**
- * @struct WaterWaveParams
- * @brief 直线传播波纹参数
- * @details 定义沿特定方向传播的波纹属性
- */
-struct WaterWaveParams
-{
-	float amplitude = 0.0f;				///< 波动强度
-	float frequency = 0.0f;				///< 波动频率
-	float density = 0.0f;				///< 波纹密度系数（值越大波纹越密集）
-	float angle = 0.0f;					///< 传播方向角度（弧度制）
-	float phi = 0.0f;					///< 相位偏移量
-};
-
-/**
- * @struct WaterWaveCalculatedParams
- * @brief 预计算的波纹参数
- * @details 存储直线波纹的法向量等预计算结果
- */
-struct WaterWaveCalculatedParams
-{
-	float A = 0.0f;						///< 法向量的X分量（cos(angle)）
-	float B = 0.0f;						///< 法向量的Y分量（-sin(angle)）
-	WaterWaveParams basicParams;			///< 基础波纹参数
-};
-
-/**
- * @struct WaterLightParams
- * @brief 光照效果参数
- * @details 控制波纹的透明度变化和光照模拟效果
- */
-struct WaterLightParams
-{
-	float minDistance = 0.0f;			///< 最小位移阈值（低于此值不计算透明度变化）
-	float defaultAlpha = 1.0f;			///< 默认透明度值
-	float minAlpha = 0.0f;				///< 最小透明度值
-	float decay = 10.0f;					///< 透明度衰减系数（值越大衰减越慢）
-	float angle = 0.0f;					///< 光照角度（弧度制）
-};
-
-/**
- * @struct WaterEffectParams
- * @brief 水波纹效果全局参数容器
- * @details 整合所有波纹效果的配置参数和渲染设置
- */
-struct WaterEffectParams
-{
-	int gridSize = 30;								///< 网格分辨率（值越大波纹越精细，性能开销越大）
-	std::list<WaterWaveCalculatedParams> waves;		///< 直线波纹参数列表
-	std::list<WaterRippleParams> fixedRipples;		///< 固定位置波纹列表
-	int maxClickRipple = 5;							///< 最大同时存在的点击波纹数量
-	std::list<WaterClickRippleParams> clickRipples;	///< 活跃的点击波纹列表
-	WaterClickRippleParams defaultClickRipple;		///< 默认点击波纹参数模板
-	WaterLightParams light;							///< 光照效果参数
-};
-
-class WaterEffect
+class WaterEffect : public WaterField
 {
 public:
 
@@ -96,25 +22,51 @@ public:
 	 */
 	WaterEffect(SDL_Window* window, SDL_Renderer* renderer);
 
+	/**
+	 * @brief 析构函数实现
+	 * @details 等待进行中的后台更新完成（它可能正在写入本对象的顶点缓冲区），再释放画布纹理
+	 */
+	~WaterEffect();
+
 	/**
 	 * @brief 准备特效渲染画布
-	 * @details 保存当前渲染目标，设置水波纹纹理为渲染目标并清空画布
+	 * @details 保存当前渲染目标，设置水波纹纹理为渲染目标并清空画布。
+	 * 画布在第一次调用时按绘制区域尺寸和 setCanvasScale 的比例创建，缩小时设置相同比例的渲染缩放，
+	 * 调用方仍按绘制区域坐标绘制。initGrid 之前或绘制区域为空时没有画布，绘制到原始渲染目标
 	 */
 	void setupEffectCanvas();
 
 	/**
 	 * @brief 渲染水波纹效果
 	 * @param time 当前时间（秒）
-	 * @details 1. 恢复原始渲染目标 2. 更新顶点位置 3. 渲染波纹几何体
+	 * @details 1. 恢复原始渲染目标 2. 推进后台网格切换并调整自适应网格 3. 更新顶点位置 4. 以画布为纹理渲染波纹几何体。
+	 * 流水线模式下第3步换入上一帧在后台计算好的顶点，并在提交几何体之前开始后台计算下一帧
 	 */
 	void renderEffect(float time);
 
 	/**
-	 * @brief 应用预设参数配置
-	 * @details 配置包含两组直线波纹+一组固定波纹的默认效果
+	 * @brief 直接以指定纹理渲染水波纹效果
+	 * @param texture 被扭曲的纹理，按网格纹理坐标 [0, 1] 采样其全部内容
+	 * @param time 当前时间（秒）
+	 * @details 不经过中间画布，也不需要调用 setupEffectCanvas：在当前渲染目标上推进后台网格切换、
+	 * 更新顶点位置并以 texture 为纹理提交波纹几何体。适合只扭曲一张背景纹理的场合，
+	 * 省去把背景绘制到画布以及画布本身占用的显存；纹理尺寸不必与绘制区域相同
+	 */
+	void renderTexture(SDL_Texture* texture, float time);
+
+	/**
+	 * @brief 设置画布相对绘制区域的比例
+	 * @param scale 比例，限制在 (0, 1]（默认1）
+	 * @details 画布按 绘制区域尺寸×scale（向上取整）创建，渲染时再拉伸到绘制区域，
+	 * 以较低的画面清晰度换取更少的填充像素和显存，适合大窗口和高DPI显示。下次 setupEffectCanvas 时生效
 	 */
-	void applyPresetParams();
+	void setCanvasScale(float scale);
 
+	/**
+	 * @brief 获取画布相对绘制区域的比例
+	 * @return 比例
+	 */
+	float getCanvasScale() const;
 
 	/**
 	 * @brief 初始化水波纹网格
@@ -122,94 +74,169 @@ public:
 	 * @param width 绘制区域宽度
 	 * @param height 绘制区域高度
 	 * @details 根据给定大小和网格分辨率创建顶点数据：
-	 * 1. 创建渲染纹理
-	 * 2. 计算网格顶点位置
-	 * 3. 生成三角面索引
-	 * @note 绘制区域尺寸变化后需要重新调用此函数
+	 * 1. 记录绘制区域尺寸，渲染纹理在 setupEffectCanvas 时按需创建（尺寸不变时复用）
+	 * 2. 由 WaterField 计算网格顶点位置
+	 * 3. 生成纹理坐标和三角面索引（网格拓扑不变时保留原有数据）
+	 * 会取消进行中的后台网格切换
+	 * @note 只有绘制区域尺寸变化时应调用 resize，它复用现有纹理以外的全部缓冲区
 	 */
 	void initGrid(int gridSize, int width, int height);
 
 	/**
-	 * @brief 重置所有水波纹参数为默认值
-	 * @details 清除所有自定义波纹配置（包括直线波纹、固定波纹和点击波纹），恢复为初始状态
+	 * @brief 调整绘制区域尺寸
+	 * @param width 新的绘制区域宽度
+	 * @param height 新的绘制区域高度
+	 * @details 网格尺寸不变，纹理坐标和索引保持不变，顶点位置由 WaterField 在原有缓冲区中重新计算；
+	 * 只有尺寸确实变化时，下次 setupEffectCanvas 才重新创建渲染纹理。适合窗口拖动缩放时每帧调用
 	 */
-	void clearParams();
+	void resize(int width, int height);
 
 	/**
-	 * @brief 添加直线传播的波纹效果
-	 * @param params 直线波纹参数配置
-	 * @details 根据角度参数计算法向量并存储预计算数据
+	 * @brief 设置流水线模式
+	 * @param enabled 是否启用（默认关闭）
+	 * @details 启用后顶点位置和颜色使用两组缓冲区：renderEffect 提交上一帧在后台线程计算好的一组，
+	 * 同时由后台线程按预测的下一帧时间（本帧时间加上一帧间隔）计算另一组，渲染线程只交换两组缓冲区。
+	 * 顶点计算不再增加渲染线程的耗时，代价是画面和点击响应晚一帧、占用一个额外的线程和一组顶点缓冲区；
+	 * 两组缓冲区交替写出，每帧都完整写出全部顶点。initGrid、resize、网格切换后的第一帧同步计算
 	 */
-	void addWave(WaterWaveParams params);
+	void setPipelined(bool enabled);
 
 	/**
-	 * @brief 添加固定位置的波纹源
-	 * @param params 固定波纹参数配置
-	 * @details 固定波纹会持续产生环形波纹效果
+	 * @brief 获取是否启用流水线模式
+	 * @return 启用时返回true
 	 */
-	void addFixedRipple(WaterRippleParams params);
+	bool getPipelined() const;
 
 	/**
-	 * @brief 设置默认的点击波纹参数模板
-	 * @param params 点击波纹默认配置
-	 * @details 此配置将用于后续通过 addDefaultClickRipple 添加的波纹
+	 * @brief 设置性能统计的日志间隔
+	 * @param seconds 间隔（秒），小于等于0时不输出（默认）
+	 * @details 启用后 renderEffect 每隔指定时间通过 SDL_Log 输出一行 getStats 的汇总；
+	 * WATER_EFFECT_STATS 为0时不做任何事
 	 */
-	void setDefaultClickRippleParams(WaterClickRippleParams params);
+	void setStatsLogInterval(float seconds);
 
 	/**
-	 * @brief 添加自定义点击波纹效果
-	 * @param params 点击波纹完整参数配置
-	 * @details 直接使用传入参数创建点击波纹，不受默认参数影响
+	 * @brief 获取当前绘制的顶点位置
+	 * @return 最近一次 renderEffect 写出的顶点位置，后台网格切换完成前为当前网格的顶点
 	 */
-	void addClickRipple(WaterClickRippleParams params);
+	const std::vector<SDL_FPoint>& getMeshPositions() const;
 
 	/**
-	 * @brief 使用默认参数添加点击波纹
-	 * @param x 点击位置的X坐标
-	 * @param y 点击位置的Y坐标
-	 * @param startTime 波纹起始时间（秒）
-	 * @details 基于预设的默认参数在指定位置生成点击波纹
+	 * @brief 获取当前绘制的顶点颜色
+	 * @return 最近一次 renderEffect 写出的顶点颜色（RGB固定为白色）
 	 */
-	void addDefaultClickRipple(float x, float y, float startTime);
+	const std::vector<SDL_FColor>& getMeshColors() const;
+
+private:
+	SDL_Window* _window = nullptr;
+	SDL_Renderer* _renderer = nullptr;
+
+	SDL_Texture* _originalRenderTarget = nullptr;
+	SDL_Texture* _waterEffectCanvas = nullptr;
+	int _canvasWidth = 0;						///< 画布纹理的实际宽度
+	int _canvasHeight = 0;						///< 画布纹理的实际高度
+	int _areaWidth = 0;							///< 绘制区域宽度
+	int _areaHeight = 0;						///< 绘制区域高度
+	float _canvasScale = 1.0f;					///< 画布相对绘制区域的比例
+
+	bool _pipelined = false;						///< 是否启用流水线模式
+	std::vector<SDL_FPoint> _backPositions;		///< 流水线模式下由后台线程写入的顶点位置
+	std::vector<SDL_FColor> _backColors;		///< 流水线模式下由后台线程写入的顶点颜色
+	bool _backReady = false;					///< 后台缓冲区是否正在或已经按当前网格计算
+	float _lastFrameTime = 0.0f;				///< 上一帧的时间，用于预测下一帧的时间
+	bool _lastFrameTimeValid = false;
 
 	/**
-	 * @brief 设置颜色效果参数
-	 * @param params 颜色配置参数
-	 * @details 控制波纹的透明度变化效果（光照模拟）
+	 * @brief 生成指向一组顶点缓冲区的输出描述
+	 * @param positions 顶点位置
+	 * @param colors 顶点颜色，只写入透明度
+	 * @return 输出缓冲区
 	 */
-	void setLightParams(WaterLightParams params);
+	static WaterVertexSpan _meshOutput(std::vector<SDL_FPoint>& positions, std::vector<SDL_FColor>& colors);
 
 	/**
-	 * @brief 设置最大点击波纹数量
-	 * @param count 允许同时存在的最大点击波纹数
-	 * @details 当超过此数量时，新的点击波纹将被忽略
+	 * @brief 流水线模式下更新顶点
+	 * @param time 当前时间（秒）
+	 * @details 后台缓冲区已按当前网格计算好时与当前缓冲区交换，否则本帧同步计算并初始化后台缓冲区；
+	 * 随后按预测的下一帧时间开始后台计算
 	 */
-	void setMaxClickRipple(int count);
+	void _updatePipelined(float time);
 
-private:
-	SDL_Window* _window = nullptr;
-	SDL_Renderer* _renderer = nullptr;
+	float _statsLogInterval = 0.0f;				///< 性能统计的日志间隔（秒），0表示不输出
+	float _statsLogTime = 0.0f;					///< 上次输出日志的时间（秒）
 
-	WaterEffectParams _params;
+	/**
+	 * @brief 按日志间隔输出性能统计
+	 * @param time 当前时间（秒）
+	 */
+	void _logStats(float time);
 
-	SDL_Texture* _originalRenderTarget = nullptr;
-	SDL_Texture* _waterEffectCanvas = nullptr;
-	std::vector<SDL_Vertex> _vertices;
-	std::vector<SDL_Vertex> _verticesOrigin;
-	std::vector<SDL_Vertex> _verticesLast;
-	std::vector<int> _indices;
+	/**
+	 * @brief 按绘制区域尺寸和画布比例准备渲染纹理
+	 * @details 尺寸与现有纹理相同时直接复用；绘制区域为空时（initGrid 之前）不创建
+	 */
+	void _prepareCanvas();
 
 	/**
-	 * @brief 更新波纹效果（每帧调用）
+	 * @brief 更新顶点并以指定纹理提交波纹几何体
+	 * @param texture 纹理
 	 * @param time 当前时间（秒）
-	 * @details 计算所有波纹的叠加效果并更新顶点位置：
-	 * 1. 计算直线波纹偏移
-	 * 2. 计算固定波纹偏移
-	 * 3. 更新点击波纹（含生命周期管理）
-	 * 4. 应用边界约束
-	 * 5. 计算顶点透明度变化
 	 */
-	void _update(float time);
+	void _renderMesh(SDL_Texture* texture, float time);
 
-};
+	/**
+	 * @struct Mesh
+	 * @brief 按属性分开存储的网格顶点和索引
+	 */
+	struct Mesh
+	{
+		std::vector<SDL_FPoint> positions;		///< 顶点位置，每帧由 WaterField 写入
+		std::vector<SDL_FColor> colors;			///< 顶点颜色，RGB固定为白色，每帧只写入透明度
+		std::vector<SDL_FPoint> texCoords;		///< 纹理坐标，网格不变时不再修改
+		std::vector<Uint16> indices16;			///< 顶点数不超过65536时使用的16位索引
+		std::vector<int> indices32;				///< 顶点数更多时使用的32位索引
+
+		/**
+		 * @brief 交换两个网格的全部数据
+		 * @param other 另一个网格
+		 */
+		void swap(Mesh& other);
+	};
+	Mesh _mesh;
 
+	/**
+	 * @struct PendingMesh
+	 * @brief 分帧生成中的网格
+	 */
+	struct PendingMesh
+	{
+		int gridSize = 0;						///< 目标网格尺寸，0表示没有进行中的重建
+		int nextRow = 0;						///< 下一个要生成的顶点行
+		float coordY = 0.0f;					///< 下一行的纹理V坐标
+		Mesh mesh;
+	};
+	PendingMesh _pendingMesh;
+	unsigned long long _meshRevision = 0;		///< _mesh 对应的 WaterField 网格版本号
+
+	/**
+	 * @brief 推进后台网格切换
+	 * @details WaterField 有进行中的网格重建时，同步分帧生成对应的顶点数据和索引，
+	 * 两者都完成后一起换入，切换前继续绘制当前网格。使用自适应网格时不需要预先生成，提交后按新网格生成
+	 */
+	void _stepGridRebuild();
+
+	/**
+	 * @brief 按 WaterField 当前的网格拓扑重新生成顶点数据和索引
+	 * @details 均匀网格一次生成全部行；自适应网格的纹理坐标由顶点原始坐标换算，索引取自 getMeshIndices。
+	 * 顶点数量变化后后台缓冲区需要按新网格重新计算
+	 */
+	void _syncMesh();
+
+	/**
+	 * @brief 生成后台网格的顶点数据和索引
+	 * @param budget 本次最多生成的顶点数量
+	 * @return 全部生成完时返回true
+	 * @details 只生成纹理坐标、颜色和三角面索引，顶点位置和透明度在每帧 update 时写入
+	 */
+	bool _stepPendingMesh(size_t budget);
+};
@@ -0,0 +1,444 @@
+﻿#include <algorithm>
+#include <cmath>
+#include "WaterEffectBatch.h"
+
+
+/**
+ * @brief 构造函数实现
+ * @param window SDL窗口对象
+ * @param renderer SDL渲染器对象
+ * @param atlasWidth 图集纹理宽度
+ * @param atlasHeight 图集纹理高度
+ */
+WaterEffectBatch::WaterEffectBatch(SDL_Window* window, SDL_Renderer* renderer, int atlasWidth, int atlasHeight)
+{
+	_window = window;
+	_renderer = renderer;
+	_atlasWidth = atlasWidth;
+	_atlasHeight = atlasHeight;
+	_atlas = SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, atlasWidth, atlasHeight);
+}
+
+/**
+ * @brief 析构函数实现
+ * @details 释放图集纹理
+ */
+WaterEffectBatch::~WaterEffectBatch()
+{
+	if (_atlas != nullptr)
+	{
+		SDL_DestroyTexture(_atlas);
+	}
+}
+
+/**
+ * @brief 添加水面
+ * @param destination 水面在渲染目标上的位置和尺寸
+ * @param gridSize 网格尺寸（必须大于0）
+ * @return 水面编号，图集剩余空间不足时返回-1
+ * @details 在图集中分配与 destination 尺寸相同的区域（向上取整），水面的波纹参数通过 getSurface 设置
+ */
+int WaterEffectBatch::addSurface(const SDL_FRect& destination, int gridSize)
+{
+	SDL_assert(gridSize > 0);
+	if (gridSize <= 0)
+	{
+		return -1;
+	}
+	Surface surface;
+	if (!_allocateAtlasRect(static_cast<int>(std::ceil(destination.w)), static_cast<int>(std::ceil(destination.h)), surface.atlasRect))
+	{
+		return -1;
+	}
+	surface.field.reset(new WaterField());
+	surface.field->initGrid(gridSize, destination.w, destination.h);
+	surface.destination = destination;
+	_surfaces.push_back(std::move(surface));
+	_meshDirty = true;
+	return static_cast<int>(_surfaces.size()) - 1;
+}
+
+/**
+ * @brief 移除全部水面
+ * @details 图集空间全部回收，已有的水面编号失效
+ */
+void WaterEffectBatch::clearSurfaces()
+{
+	_surfaces.clear();
+	_shelfX = 0;
+	_shelfY = 0;
+	_shelfHeight = 0;
+	_meshDirty = true;
+}
+
+/**
+ * @brief 获取水面数量
+ * @return 水面数量
+ */
+int WaterEffectBatch::getSurfaceCount() const
+{
+	return static_cast<int>(_surfaces.size());
+}
+
+/**
+ * @brief 获取水面的模拟对象
+ * @param index 水面编号
+ * @return 水面的 WaterField，坐标以水面左上角为原点
+ * @details 可以设置波纹参数、模拟频率或请求后台切换网格尺寸；绘制区域尺寸请通过 setSurfaceDestination 修改
+ */
+WaterField& WaterEffectBatch::getSurface(int index)
+{
+	SDL_assert(index >= 0 && index < getSurfaceCount());
+	return *_surfaces[index].field;
+}
+
+/**
+ * @brief 获取水面在图集中的区域
+ * @param index 水面编号
+ * @return 图集中的区域，setupCanvas 之后把水面内容绘制到这里
+ */
+SDL_FRect WaterEffectBatch::getAtlasRect(int index) const
+{
+	SDL_assert(index >= 0 && index < getSurfaceCount());
+	const SDL_Rect& rect = _surfaces[index].atlasRect;
+	return SDL_FRect{ static_cast<float>(rect.x), static_cast<float>(rect.y), static_cast<float>(rect.w), static_cast<float>(rect.h) };
+}
+
+/**
+ * @brief 修改水面在渲染目标上的位置和尺寸
+ * @param index 水面编号
+ * @param destination 新的位置和尺寸
+ * @details 只移动时不做任何重新计算；尺寸变化时由 WaterField::resize 在原有缓冲区中重新计算顶点位置，
+ * 图集区域不变，内容按新尺寸缩放显示
+ */
+void WaterEffectBatch::setSurfaceDestination(int index, const SDL_FRect& destination)
+{
+	SDL_assert(index >= 0 && index < getSurfaceCount());
+	Surface& surface = _surfaces[index];
+	surface.destination = destination;
+	surface.field->resize(destination.w, destination.h);
+}
+
+/**
+ * @brief 在指定位置添加默认点击波纹
+ * @param x 渲染目标上的X坐标
+ * @param y 渲染目标上的Y坐标
+ * @param startTime 开始时间（秒）
+ * @details 添加到所有包含该点的水面，坐标换算到各水面自身的坐标系
+ */
+void WaterEffectBatch::addDefaultClickRipple(float x, float y, float startTime)
+{
+	for (Surface& surface : _surfaces)
+	{
+		const SDL_FRect& rect = surface.destination;
+		if (x >= rect.x && x < rect.x + rect.w && y >= rect.y && y < rect.y + rect.h)
+		{
+			surface.field->addDefaultClickRipple(x - rect.x, y - rect.y, startTime);
+		}
+	}
+}
+
+/**
+ * @brief 设置并行更新的线程数
+ * @param count 线程数，小于等于1时在调用线程中依次更新
+ * @details 以水面为单位分配任务，各水面自身保持单线程更新
+ */
+void WaterEffectBatch::setThreadCount(int count)
+{
+	if (count <= 1)
+	{
+		_threadPool.reset();
+		return;
+	}
+	if (_threadPool != nullptr && _threadPool->getThreadCount() == count)
+	{
+		return;
+	}
+	_threadPool.reset(new WaterThreadPool(count));
+}
+
+/**
+ * @brief 获取并行更新的线程数
+ * @return 线程数，1表示在调用线程中更新
+ */
+int WaterEffectBatch::getThreadCount() const
+{
+	return _threadPool != nullptr ? _threadPool->getThreadCount() : 1;
+}
+
+/**
+ * @brief 准备图集画布
+ * @details 保存当前渲染目标，设置图集纹理为渲染目标并清空画布
+ */
+void WaterEffectBatch::setupCanvas()
+{
+	_originalRenderTarget = SDL_GetRenderTarget(_renderer);
+	if (_atlas != nullptr)
+	{
+		SDL_SetRenderTarget(_renderer, _atlas);
+	}
+	SDL_SetRenderDrawColor(_renderer, 0, 0, 0, 0);
+	SDL_RenderClear(_renderer);
+}
+
+/**
+ * @brief 渲染全部水面
+ * @param time 当前时间（秒）
+ * @details 1. 恢复原始渲染目标 2. 推进各水面的后台网格切换并调整自适应网格 3. 网格变化时重新生成合并网格
+ * 4. 并行更新全部水面 5. 一次绘制调用渲染全部水面
+ */
+void WaterEffectBatch::renderEffects(float time)
+{
+	SDL_SetRenderTarget(_renderer, _originalRenderTarget);
+	_stepGridRebuilds(time);
+	if (_meshDirty)
+	{
+		_rebuildMesh();
+	}
+	if (_positions.empty())
+	{
+		return;
+	}
+
+	_updateTime = time;
+	if (_threadPool != nullptr && _surfaces.size() > 1)
+	{
+		_threadPool->run(_surfaces.size(), [this](size_t index)
+			{
+				_updateSurface(index);
+			});
+	}
+	else
+	{
+		for (size_t i = 0; i < _surfaces.size(); i++)
+		{
+			_updateSurface(i);
+		}
+	}
+
+	int vertexCount = static_cast<int>(_positions.size());
+	const float* xy = &_positions[0].x;
+	const float* uv = &_texCoords[0].x;
+	if (!_indices16.empty())
+	{
+		SDL_RenderGeometryRaw(_renderer, _atlas, xy, sizeof(SDL_FPoint), _colors.data(), sizeof(SDL_FColor), uv, sizeof(SDL_FPoint),
+			vertexCount, _indices16.data(), static_cast<int>(_indices16.size()), sizeof(Uint16));
+	}
+	else
+	{
+		SDL_RenderGeometryRaw(_renderer, _atlas, xy, sizeof(SDL_FPoint), _colors.data(), sizeof(SDL_FColor), uv, sizeof(SDL_FPoint),
+			vertexCount, _indices32.data(), static_cast<int>(_indices32.size()), sizeof(int));
+	}
+}
+
+/**
+ * @brief 在图集中分配区域
+ * @param width 宽度
+ * @param height 高度
+ * @param rect 分配到的区域
+ * @return 空间不足时返回false
+ */
+bool WaterEffectBatch::_allocateAtlasRect(int width, int height, SDL_Rect& rect)
+{
+	if (width <= 0 || height <= 0 || width > _atlasWidth)
+	{
+		return false;
+	}
+	if (_shelfX + width > _atlasWidth)
+	{
+		// 当前货架放不下，另起一层
+		_shelfY += _shelfHeight + kAtlasPadding;
+		_shelfX = 0;
+		_shelfHeight = 0;
+	}
+	if (_shelfY + height > _atlasHeight)
+	{
+		return false;
+	}
+	rect = SDL_Rect{ _shelfX, _shelfY, width, height };
+	_shelfX += width + kAtlasPadding;
+	_shelfHeight = std::max(_shelfHeight, height);
+	return true;
+}
+
+/**
+ * @brief 推进各水面的后台网格切换并调整自适应网格
+ * @param time 当前时间（秒）
+ * @details 网格切换完成或自适应网格拓扑变化的水面标记合并网格需要重新生成
+ */
+void WaterEffectBatch::_stepGridRebuilds(float time)
+{
+	for (Surface& surface : _surfaces)
+	{
+		WaterField& field = *surface.field;
+		if (field.getPendingGridSize() != 0 && field.stepGridRebuild())
+		{
+			field.commitGridRebuild();
+		}
+		field.refineMesh(time);
+		if (field.getMeshRevision() != surface.meshRevision)
+		{
+			_meshDirty = true;
+		}
+	}
+}
+
+/**
+ * @brief 追加一个水面的三角面索引
+ * @param indices 合并索引数组
+ * @param firstVertex 水面在合并顶点数组中的起始下标
+ * @param gridSize 网格尺寸
+ */
+template <typename Index>
+static void appendSurfaceIndices(std::vector<Index>& indices, size_t firstVertex, int gridSize)
+{
+	size_t columns = static_cast<size_t>(gridSize) + 1;
+	for (int y = 0; y < gridSize; ++y) {
+		for (int x = 0; x < gridSize; ++x) {
+			size_t topLeft = firstVertex + y * columns + x;
+			size_t topRight = topLeft + 1;
+			size_t bottomLeft = topLeft + columns;
+			size_t bottomRight = bottomLeft + 1;
+
+			indices.push_back(static_cast<Index>(topLeft));
+			indices.push_back(static_cast<Index>(topRight));
+			indices.push_back(static_cast<Index>(bottomLeft));
+
+			indices.push_back(static_cast<Index>(topRight));
+			indices.push_back(static_cast<Index>(bottomRight));
+			indices.push_back(static_cast<Index>(bottomLeft));
+		}
+	}
+}
+
+/**
+ * @brief 追加一个自适应网格水面的三角面索引
+ * @param indices 合并索引数组
+ * @param firstVertex 水面在合并顶点数组中的起始下标
+ * @param meshIndices 水面自身的三角面索引
+ */
+template <typename Index>
+static void appendMeshIndices(std::vector<Index>& indices, size_t firstVertex, const std::vector<unsigned int>& meshIndices)
+{
+	for (unsigned int index : meshIndices) {
+		indices.push_back(static_cast<Index>(firstVertex + index));
+	}
+}
+
+/**
+ * @brief 重新生成合并网格
+ * @details 按各水面当前的网格拓扑分配顶点区间，生成图集纹理坐标和偏移后的三角面索引；
+ * 自适应网格水面的纹理坐标由顶点原始坐标换算
+ */
+void WaterEffectBatch::_rebuildMesh()
+{
+	_meshDirty = false;
+	size_t vertexCount = 0;
+	size_t indexCount = 0;
+	for (Surface& surface : _surfaces)
+	{
+		WaterField& field = *surface.field;
+		surface.meshRevision = field.getMeshRevision();
+		surface.firstVertex = vertexCount;
+		vertexCount += field.getVertexCount();
+		if (field.isQuadtreeMeshActive())
+		{
+			indexCount += field.getMeshIndices().size();
+		}
+		else
+		{
+			indexCount += static_cast<size_t>(field.getGridSize()) * field.getGridSize() * 6;
+		}
+	}
+	bool shortIndices = vertexCount <= 65536;
+
+	_positions.assign(vertexCount, SDL_FPoint{ 0.0f, 0.0f });
+	_colors.assign(vertexCount, SDL_FColor{ 1.0f, 1.0f, 1.0f, 1.0f });
+	_texCoords.clear();
+	_texCoords.reserve(vertexCount);
+	_indices16.clear();
+	_indices32.clear();
+	if (shortIndices)
+	{
+		_indices16.reserve(indexCount);
+	}
+	else
+	{
+		_indices32.reserve(indexCount);
+	}
+
+	for (Surface& surface : _surfaces)
+	{
+		WaterField& field = *surface.field;
+		const SDL_Rect& rect = surface.atlasRect;
+		if (field.isQuadtreeMeshActive())
+		{
+			// 最后一个顶点位于绘制区域的右下角
+			size_t count = field.getVertexCount();
+			const float* originX = field.getOriginX();
+			const float* originY = field.getOriginY();
+			float width = originX[count - 1];
+			float height = originY[count - 1];
+			for (size_t i = 0; i < count; i++)
+			{
+				_texCoords.push_back({ (rect.x + originX[i] / width * rect.w) / _atlasWidth, (rect.y + originY[i] / height * rect.h) / _atlasHeight });
+			}
+			if (shortIndices)
+			{
+				appendMeshIndices(_indices16, surface.firstVertex, field.getMeshIndices());
+			}
+			else
+			{
+				appendMeshIndices(_indices32, surface.firstVertex, field.getMeshIndices());
+			}
+			field.invalidateOutput();
+			continue;
+		}
+		int gridSize = field.getGridSize();
+		float coordY = 0.0f;
+		for (int y = 0; y <= gridSize; ++y) {
+			if (y == gridSize)
+			{
+				coordY = 1.0f;
+			}
+			float coordX = 0.0f;
+			for (int x = 0; x <= gridSize; ++x) {
+				if (x == gridSize)
+				{
+					coordX = 1.0f;
+				}
+				_texCoords.push_back({ (rect.x + coordX * rect.w) / _atlasWidth, (rect.y + coordY * rect.h) / _atlasHeight });
+				coordX += 1.0f / gridSize;
+			}
+			coordY += 1.0f / gridSize;
+		}
+		if (shortIndices)
+		{
+			appendSurfaceIndices(_indices16, surface.firstVertex, gridSize);
+		}
+		else
+		{
+			appendSurfaceIndices(_indices32, surface.firstVertex, gridSize);
+		}
+		// 合并数组已重新填充，下一次更新需要完整写出
+		field.invalidateOutput();
+	}
+}
+
+/**
+ * @brief 更新一个水面并写出到合并数组
+ * @param index 水面编号
+ */
+void WaterEffectBatch::_updateSurface(size_t index)
+{
+	Surface& surface = _surfaces[index];
+	WaterVertexSpan output;
+	output.x = &_positions[surface.firstVertex].x;
+	output.y = &_positions[surface.firstVertex].y;
+	output.alpha = &_colors[surface.firstVertex].a;
+	output.stride = sizeof(SDL_FPoint);
+	output.alphaStride = sizeof(SDL_FColor);
+	output.offsetX = surface.destination.x;
+	output.offsetY = surface.destination.y;
+	surface.field->update(_updateTime, output);
+}
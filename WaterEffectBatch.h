@@ -0,0 +1,186 @@
+﻿#pragma once
+#include <memory>
+#include <vector>
+#include <SDL3/SDL.h>
+#include "WaterField.h"
+#include "WaterThreadPool.h"
+
+
+/**
+ * @class WaterEffectBatch
+ * @brief 多个水面合批渲染的SDL适配层
+ * @details 每个水面由独立的 WaterField 模拟，内容绘制在共享图集纹理中按货架方式分配的区域内。
+ * 所有水面的顶点写入同一组合并数组，索引按各水面的起始顶点偏移后合并，每帧只提交一次 SDL_RenderGeometryRaw；
+ * 水面更新以水面为单位分配给线程池并行执行。水面数量增加时绘制调用次数不变，每个水面只增加自身网格的计算量
+ */
+class WaterEffectBatch
+{
+public:
+
+	/**
+	 * @brief 构造函数实现
+	 * @param window SDL窗口对象
+	 * @param renderer SDL渲染器对象
+	 * @param atlasWidth 图集纹理宽度
+	 * @param atlasHeight 图集纹理高度
+	 */
+	WaterEffectBatch(SDL_Window* window, SDL_Renderer* renderer, int atlasWidth, int atlasHeight);
+
+	/**
+	 * @brief 析构函数实现
+	 * @details 释放图集纹理
+	 */
+	~WaterEffectBatch();
+
+	WaterEffectBatch(const WaterEffectBatch&) = delete;
+	WaterEffectBatch& operator=(const WaterEffectBatch&) = delete;
+
+	/**
+	 * @brief 添加水面
+	 * @param destination 水面在渲染目标上的位置和尺寸
+	 * @param gridSize 网格尺寸（必须大于0）
+	 * @return 水面编号，图集剩余空间不足时返回-1
+	 * @details 在图集中分配与 destination 尺寸相同的区域（向上取整），水面的波纹参数通过 getSurface 设置
+	 */
+	int addSurface(const SDL_FRect& destination, int gridSize);
+
+	/**
+	 * @brief 移除全部水面
+	 * @details 图集空间全部回收，已有的水面编号失效
+	 */
+	void clearSurfaces();
+
+	/**
+	 * @brief 获取水面数量
+	 * @return 水面数量
+	 */
+	int getSurfaceCount() const;
+
+	/**
+	 * @brief 获取水面的模拟对象
+	 * @param index 水面编号
+	 * @return 水面的 WaterField，坐标以水面左上角为原点
+	 * @details 可以设置波纹参数、模拟频率或请求后台切换网格尺寸；绘制区域尺寸请通过 setSurfaceDestination 修改
+	 */
+	WaterField& getSurface(int index);
+
+	/**
+	 * @brief 获取水面在图集中的区域
+	 * @param index 水面编号
+	 * @return 图集中的区域，setupCanvas 之后把水面内容绘制到这里
+	 */
+	SDL_FRect getAtlasRect(int index) const;
+
+	/**
+	 * @brief 修改水面在渲染目标上的位置和尺寸
+	 * @param index 水面编号
+	 * @param destination 新的位置和尺寸
+	 * @details 只移动时不做任何重新计算；尺寸变化时由 WaterField::resize 在原有缓冲区中重新计算顶点位置，
+	 * 图集区域不变，内容按新尺寸缩放显示
+	 */
+	void setSurfaceDestination(int index, const SDL_FRect& destination);
+
+	/**
+	 * @brief 在指定位置添加默认点击波纹
+	 * @param x 渲染目标上的X坐标
+	 * @param y 渲染目标上的Y坐标
+	 * @param startTime 开始时间（秒）
+	 * @details 添加到所有包含该点的水面，坐标换算到各水面自身的坐标系
+	 */
+	void addDefaultClickRipple(float x, float y, float startTime);
+
+	/**
+	 * @brief 设置并行更新的线程数
+	 * @param count 线程数，小于等于1时在调用线程中依次更新
+	 * @details 以水面为单位分配任务，各水面自身保持单线程更新
+	 */
+	void setThreadCount(int count);
+
+	/**
+	 * @brief 获取并行更新的线程数
+	 * @return 线程数，1表示在调用线程中更新
+	 */
+	int getThreadCount() const;
+
+	/**
+	 * @brief 准备图集画布
+	 * @details 保存当前渲染目标，设置图集纹理为渲染目标并清空画布
+	 */
+	void setupCanvas();
+
+	/**
+	 * @brief 渲染全部水面
+	 * @param time 当前时间（秒）
+	 * @details 1. 恢复原始渲染目标 2. 推进各水面的后台网格切换并调整自适应网格 3. 网格变化时重新生成合并网格
+	 * 4. 并行更新全部水面 5. 一次绘制调用渲染全部水面
+	 */
+	void renderEffects(float time);
+
+private:
+	SDL_Window* _window = nullptr;
+	SDL_Renderer* _renderer = nullptr;
+
+	SDL_Texture* _originalRenderTarget = nullptr;
+	SDL_Texture* _atlas = nullptr;
+	int _atlasWidth = 0;
+	int _atlasHeight = 0;
+
+	/// 图集中相邻区域之间的间隔，避免线性过滤时采样到相邻水面的内容
+	static constexpr int kAtlasPadding = 2;
+	int _shelfX = 0;						///< 当前货架上的下一个空闲位置
+	int _shelfY = 0;						///< 当前货架的顶部
+	int _shelfHeight = 0;					///< 当前货架的高度
+
+	/**
+	 * @struct Surface
+	 * @brief 一个水面
+	 */
+	struct Surface
+	{
+		std::unique_ptr<WaterField> field;
+		SDL_FRect destination = {};			///< 在渲染目标上的位置和尺寸
+		SDL_Rect atlasRect = {};			///< 在图集中的区域
+		unsigned long long meshRevision = 0;	///< 合并网格对应的网格版本号
+		size_t firstVertex = 0;				///< 在合并顶点数组中的起始下标
+	};
+	std::vector<Surface> _surfaces;
+
+	std::vector<SDL_FPoint> _positions;		///< 全部水面的顶点位置，每帧由各 WaterField 写入
+	std::vector<SDL_FColor> _colors;		///< 全部水面的顶点颜色，RGB固定为白色，每帧只写入透明度
+	std::vector<SDL_FPoint> _texCoords;		///< 全部水面的图集纹理坐标
+	std::vector<Uint16> _indices16;			///< 顶点总数不超过65536时使用的16位合并索引
+	std::vector<int> _indices32;			///< 顶点总数更多时使用的32位合并索引
+	bool _meshDirty = false;
+
+	std::unique_ptr<WaterThreadPool> _threadPool;
+	float _updateTime = 0.0f;				///< 本帧的更新时间，供线程池任务读取
+
+	/**
+	 * @brief 在图集中分配区域
+	 * @param width 宽度
+	 * @param height 高度
+	 * @param rect 分配到的区域
+	 * @return 空间不足时返回false
+	 */
+	bool _allocateAtlasRect(int width, int height, SDL_Rect& rect);
+
+	/**
+	 * @brief 推进各水面的后台网格切换并调整自适应网格
+	 * @param time 当前时间（秒）
+	 * @details 网格切换完成或自适应网格拓扑变化的水面标记合并网格需要重新生成
+	 */
+	void _stepGridRebuilds(float time);
+
+	/**
+	 * @brief 重新生成合并网格
+	 * @details 按各水面当前的网格拓扑分配顶点区间，生成图集纹理坐标和偏移后的三角面索引；
+	 * 自适应网格水面的纹理坐标由顶点原始坐标换算
+	 */
+	void _rebuildMesh();
+
+	/**
+	 * @brief 更新一个水面并写出到合并数组
+	 * @param index 水面编号
+	 */
+	void _updateSurface(size_t index);
+};
@@ -0,0 +1,2371 @@
+﻿#define _USE_MATH_DEFINES 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "WaterField.h"
+
+
+/**
+ * @brief 创建缓冲池
+ * @param capacity 容量
+ */
+WaterClickRipplePool::WaterClickRipplePool(int capacity)
+{
+	setCapacity(capacity);
+}
+
+/**
+ * @brief 重新设置容量
+ * @param capacity 新容量（小于0按0处理）
+ * @details 容量变小时保留最新添加的波纹
+ */
+void WaterClickRipplePool::setCapacity(int capacity)
+{
+	size_t newCapacity = capacity > 0 ? static_cast<size_t>(capacity) : 0;
+	if (newCapacity == _slots.size())
+	{
+		return;
+	}
+	size_t keep = std::min(_count, newCapacity);
+	std::vector<WaterClickRippleParams> slots(newCapacity);
+	for (size_t i = 0; i < keep; i++)
+	{
+		slots[i] = _at(_count - keep + i);
+	}
+	_slots.swap(slots);
+	_head = 0;
+	_count = keep;
+}
+
+/**
+ * @brief 获取容量
+ * @return 容量
+ */
+size_t WaterClickRipplePool::capacity() const
+{
+	return _slots.size();
+}
+
+/**
+ * @brief 获取当前波纹数量
+ * @return 数量
+ */
+size_t WaterClickRipplePool::size() const
+{
+	return _count;
+}
+
+/**
+ * @brief 按添加顺序访问波纹
+ * @param index 下标（0为最早添加）
+ * @return 波纹参数
+ */
+const WaterClickRippleParams& WaterClickRipplePool::operator[](size_t index) const
+{
+	return _slots[(_head + index) % _slots.size()];
+}
+
+WaterClickRippleParams& WaterClickRipplePool::_at(size_t index)
+{
+	return _slots[(_head + index) % _slots.size()];
+}
+
+/**
+ * @brief 添加点击波纹
+ * @param params 波纹参数
+ * @param policy 已满时的处理策略
+ * @return 波纹被加入返回true，被丢弃返回false
+ */
+bool WaterClickRipplePool::push(const WaterClickRippleParams& params, WaterClickRippleOverflow policy)
+{
+	if (_slots.empty())
+	{
+		_droppedCount++;
+		return false;
+	}
+	if (_count == _slots.size())
+	{
+		switch (policy)
+		{
+		case WaterClickRippleOverflow::EvictOldest:
+			_removeAt(0);
+			break;
+		case WaterClickRippleOverflow::EvictWeakest:
+		{
+			// 以新波纹的起始时间比较各波纹的当前幅度，幅度相同时替换较早的波纹
+			size_t weakest = 0;
+			float weakestStrength = 0.0f;
+			for (size_t i = 0; i < _count; i++)
+			{
+				const WaterClickRippleParams& iter = _at(i);
+				float strength = std::abs(iter.rippleParams.amplitude) / (params.startTime - iter.startTime + 1.0f);
+				if (i == 0 || strength < weakestStrength)
+				{
+					weakest = i;
+					weakestStrength = strength;
+				}
+			}
+			_removeAt(weakest);
+			break;
+		}
+		default:
+			_droppedCount++;
+			return false;
+		}
+		_evictedCount++;
+	}
+	_at(_count) = params;
+	_count++;
+	return true;
+}
+
+/**
+ * @brief 移除已超过生命周期的波纹
+ * @param time 当前时间（秒）
+ */
+void WaterClickRipplePool::removeExpired(float time)
+{
+	size_t kept = 0;
+	for (size_t i = 0; i < _count; i++)
+	{
+		const WaterClickRippleParams& iter = _at(i);
+		if (time - iter.startTime > iter.lifeTime)
+		{
+			continue;
+		}
+		if (kept != i)
+		{
+			_at(kept) = iter;
+		}
+		kept++;
+	}
+	_count = kept;
+}
+
+/**
+ * @brief 清空所有波纹（保留容量）
+ */
+void WaterClickRipplePool::clear()
+{
+	_head = 0;
+	_count = 0;
+}
+
+/**
+ * @brief 获取因缓冲池已满而被丢弃的新波纹数量
+ * @return 累计数量
+ */
+unsigned long long WaterClickRipplePool::getDroppedCount() const
+{
+	return _droppedCount;
+}
+
+/**
+ * @brief 获取因缓冲池已满而被替换的旧波纹数量
+ * @return 累计数量
+ */
+unsigned long long WaterClickRipplePool::getEvictedCount() const
+{
+	return _evictedCount;
+}
+
+/**
+ * @brief 移除指定下标的波纹，后面的波纹依次前移以保持顺序
+ * @param index 下标
+ */
+void WaterClickRipplePool::_removeAt(size_t index)
+{
+	if (index == 0)
+	{
+		_head = (_head + 1) % _slots.size();
+		_count--;
+		return;
+	}
+	for (size_t i = index; i + 1 < _count; i++)
+	{
+		_at(i) = _at(i + 1);
+	}
+	_count--;
+}
+
+/**
+ * @brief 应用预设参数配置
+ * @details 配置包含两组直线波纹+一组固定波纹的默认效果
+ */
+void WaterField::applyPresetParams()
+{
+	clearParams();
+
+	setMaxClickRipple(5);
+	WaterRippleParams fixedRippleParams;
+	fixedRippleParams.amplitude = 15.0f;
+	fixedRippleParams.density = 0.015f;
+	fixedRippleParams.frequency = 5.0f;
+	fixedRippleParams.pos = { -100.0f, 600.0f };
+	addFixedRipple(fixedRippleParams);
+
+	WaterWaveParams waveParams;
+	waveParams.amplitude = 5.0f;
+	waveParams.angle = 5 * M_PI / 6;
+	waveParams.density = 0.02f;
+	waveParams.frequency = 8.0f;
+	waveParams.phi = 1.0f;
+	addWave(waveParams);
+
+	waveParams.amplitude = 8.0f;
+	waveParams.angle = 7 * M_PI / 6;
+	waveParams.density = 0.01f;
+	waveParams.frequency = 3.0f;
+	waveParams.phi = 0.0f;
+	addWave(waveParams);
+
+	WaterLightParams lightParams;
+	lightParams.decay = 10.0f;
+	lightParams.defaultAlpha = 0.9f;
+	lightParams.angle = 5 * M_PI / 4;
+	lightParams.minAlpha = 0.85f;
+	lightParams.minDistance = 0.0f;
+	setLightParams(lightParams);
+
+	WaterClickRippleParams waterClickRippleParams;
+	waterClickRippleParams.lifeTime = 5.0f;
+	waterClickRippleParams.rippleParams.amplitude = 30.0f;
+	waterClickRippleParams.rippleParams.density = 0.02f;
+	waterClickRippleParams.rippleParams.frequency = 10.0f;
+	setDefaultClickRippleParams(waterClickRippleParams);
+}
+
+/**
+ * @brief 重置所有水波纹参数为默认值
+ * @details 清除所有自定义波纹配置（包括直线波纹、固定波纹和点击波纹），恢复为初始状态，网格尺寸保持不变
+ */
+void WaterField::clearParams()
+{
+	finishUpdate();
+	WaterEffectParams defaultParams;
+	if (_gridSize > 0)
+	{
+		defaultParams.gridSize = _gridSize;
+	}
+	_params = defaultParams;
+	_meshRefineValid = false;
+	_rebuildFixedRippleCache();
+	_reserveFrameBuffers();
+	_resetHeightField();
+}
+
+/**
+ * @brief 添加直线传播的波纹效果
+ * @param params 直线波纹参数配置
+ * @details 根据角度参数计算法向量并存储预计算数据
+ */
+void WaterField::addWave(WaterWaveParams params)
+{
+	finishUpdate();
+	WaterWaveCalculatedParams cParams;
+	cParams.basicParams = params;
+	cParams.A = std::cos(params.angle);
+	cParams.B = -std::sin(params.angle);
+
+	_params.waves.push_back(cParams);
+	_meshRefineValid = false;
+	_reserveFrameBuffers();
+}
+
+/**
+ * @brief 添加固定位置的波纹源
+ * @param params 固定波纹参数配置
+ * @details 固定波纹会持续产生环形波纹效果
+ */
+void WaterField::addFixedRipple(WaterRippleParams params)
+{
+	finishUpdate();
+	_params.fixedRipples.push_back(params);
+	_meshRefineValid = false;
+	_appendFixedRippleCache(params);
+	_reserveFrameBuffers();
+}
+
+/**
+ * @brief 设置默认的点击波纹参数模板
+ * @param params 点击波纹默认配置
+ * @details 此配置将用于后续通过 addDefaultClickRipple 添加的波纹
+ */
+void WaterField::setDefaultClickRippleParams(WaterClickRippleParams params)
+{
+	finishUpdate();
+	_params.defaultClickRipple = params;
+}
+
+/**
+ * @brief 添加自定义点击波纹效果
+ * @param params 点击波纹完整参数配置
+ * @details 直接使用传入参数创建点击波纹，不受默认参数影响；
+ * HeightField 模式下改为在波纹位置注入振幅相同的冲击，忽略起始时间、频率和波纹密度
+ */
+void WaterField::addClickRipple(WaterClickRippleParams params)
+{
+	finishUpdate();
+	if (_clickRippleEngine == WaterClickRippleEngine::HeightField)
+	{
+		addImpulse(params.rippleParams.pos.x, params.rippleParams.pos.y, params.rippleParams.amplitude, _params.heightField.impulseRadius);
+		return;
+	}
+	_params.clickRipples.push(params, _params.clickRippleOverflow);
+	_meshRefineValid = false;
+}
+
+/**
+ * @brief 使用默认参数添加点击波纹
+ * @param x 点击位置的X坐标
+ * @param y 点击位置的Y坐标
+ * @param startTime 波纹起始时间（秒）
+ * @details 基于预设的默认参数在指定位置生成点击波纹
+ */
+void WaterField::addDefaultClickRipple(float x, float y, float startTime)
+{
+	WaterClickRippleParams params;
+	params = _params.defaultClickRipple;
+	params.startTime = startTime;
+	params.rippleParams.pos = { x, y };
+	addClickRipple(params);
+}
+
+/**
+ * @brief 设置点击波纹的模拟方式
+ * @param engine 模拟方式，默认为 Analytic
+ * @details HeightField 模式下 addClickRipple 和 addDefaultClickRipple 改为向高度场注入冲击（立即生效，忽略起始时间和生命周期），
+ * 高度场与网格顶点一一对应，按固定步长推进，直线波纹和固定波纹照常叠加。切换时清除现有的点击波纹和高度场
+ */
+void WaterField::setClickRippleEngine(WaterClickRippleEngine engine)
+{
+	finishUpdate();
+	if (engine == _clickRippleEngine)
+	{
+		return;
+	}
+	_clickRippleEngine = engine;
+	_params.clickRipples.clear();
+	// 高度场需要规则网格，先切换网格类型再按顶点数量分配高度场
+	_applyMeshLayout();
+	_resetHeightField();
+}
+
+/**
+ * @brief 获取点击波纹的模拟方式
+ * @return 模拟方式
+ */
+WaterClickRippleEngine WaterField::getClickRippleEngine() const
+{
+	return _clickRippleEngine;
+}
+
+/**
+ * @brief 设置高度场模拟参数
+ * @param params 高度场参数
+ */
+void WaterField::setHeightFieldParams(WaterHeightFieldParams params)
+{
+	finishUpdate();
+	_params.heightField = params;
+}
+
+/**
+ * @brief 向高度场注入冲击
+ * @param x 中心X坐标
+ * @param y 中心Y坐标
+ * @param amplitude 冲击产生的最大位移（像素）
+ * @param radius 冲击半径（像素）
+ * @details 叠加一个高斯形状的凸起，随后向外扩散为波纹；适合拖动时逐帧调用。
+ * 只在 HeightField 模式下生效，开销只与冲击覆盖的顶点数有关
+ */
+void WaterField::addImpulse(float x, float y, float amplitude, float radius)
+{
+	finishUpdate();
+	if (_clickRippleEngine != WaterClickRippleEngine::HeightField || _heightFieldCurrent.empty() || radius <= 0.0f || amplitude == 0.0f)
+	{
+		return;
+	}
+	// 高斯凸起 h = A·R·e^(-r²/R²) 的最大坡度约为0.86A，位移等于坡度，3R之外的高度可以忽略
+	float height = amplitude * radius;
+	float inverseRadius2 = 1.0f / (radius * radius);
+	float reach = radius * 3.0f;
+	size_t rows = _heightFieldCurrent.size() / _columns;
+	float cellWidth = _width / static_cast<float>(_columns - 1);
+	float cellHeight = _height / static_cast<float>(rows - 1);
+	size_t columnBegin = static_cast<size_t>(std::max(std::ceil((x - reach) / cellWidth), 0.0f));
+	size_t columnEnd = static_cast<size_t>(std::min(std::floor((x + reach) / cellWidth) + 1.0f, static_cast<float>(_columns)));
+	size_t rowBegin = static_cast<size_t>(std::max(std::ceil((y - reach) / cellHeight), 0.0f));
+	size_t rowEnd = static_cast<size_t>(std::min(std::floor((y + reach) / cellHeight) + 1.0f, static_cast<float>(rows)));
+	for (size_t row = rowBegin; row < rowEnd; row++)
+	{
+		for (size_t column = columnBegin; column < columnEnd; column++)
+		{
+			size_t i = row * _columns + column;
+			float dx = _originX[i] - x;
+			float dy = _originY[i] - y;
+			float value = height * std::exp(-(dx * dx + dy * dy) * inverseRadius2);
+			// 当前和上一步同时抬高，凸起从静止开始释放
+			_heightFieldCurrent[i] += value;
+			_heightFieldPrevious[i] += value;
+		}
+	}
+	_heightFieldActive = true;
+	_staticSimulations = 0;
+	_idle = false;
+}
+
+/**
+ * @brief 获取高度场的步长
+ * @return 秒，不超过1/60且满足波动方程的稳定条件
+ */
+float WaterField::_heightFieldInterval() const
+{
+	size_t rows = _columns > 0 ? _originX.size() / _columns : 0;
+	float speed = std::abs(_params.heightField.speed);
+	if (rows < 2 || _columns < 2 || speed <= 0.0f)
+	{
+		return 1.0f / 60.0f;
+	}
+	float cellWidth = _width / static_cast<float>(_columns - 1);
+	float cellHeight = _height / static_cast<float>(rows - 1);
+	// 显式差分的稳定条件为 c·dt·sqrt(1/dx² + 1/dy²) <= 1，留出一半余量
+	float limit = 0.5f / (speed * std::sqrt(1.0f / (cellWidth * cellWidth) + 1.0f / (cellHeight * cellHeight)));
+	return std::min(limit, 1.0f / 60.0f);
+}
+
+/**
+ * @brief 把高度场推进到指定时刻
+ * @param time 模拟时刻（秒）
+ * @details 每步按行带并行推进；全部高度都低于阈值时清零并停止推进，此后不再有任何开销
+ */
+void WaterField::_advanceHeightField(float time)
+{
+	if (!_heightFieldActive)
+	{
+		_heightFieldTimeValid = false;
+		return;
+	}
+	if (!_heightFieldTimeValid || time < _heightFieldTime)
+	{
+		// 首次推进或时间倒退时从当前时刻开始计时
+		_heightFieldTime = time;
+		_heightFieldTimeValid = true;
+		return;
+	}
+
+	float interval = _heightFieldInterval();
+	int steps = static_cast<int>((time - _heightFieldTime) / interval);
+	if (steps <= 0)
+	{
+		return;
+	}
+	if (steps > kMaxHeightFieldSteps)
+	{
+		steps = kMaxHeightFieldSteps;
+		_heightFieldTime = time;
+	}
+	else
+	{
+		_heightFieldTime += steps * interval;
+	}
+
+	size_t rows = _heightFieldCurrent.size() / _columns;
+	float cellWidth = _width / static_cast<float>(_columns - 1);
+	float cellHeight = _height / static_cast<float>(rows - 1);
+	float speed = _params.heightField.speed;
+	WaterKernel::HeightFieldStep step;
+	step.columns = _columns;
+	step.rows = rows;
+	step.coefficientX = (speed * interval / cellWidth) * (speed * interval / cellWidth);
+	step.coefficientY = (speed * interval / cellHeight) * (speed * interval / cellHeight);
+	step.damping = std::exp(-std::max(_params.heightField.damping, 0.0f) * interval);
+	for (int k = 0; k < steps; k++)
+	{
+		step.current = _heightFieldCurrent.data();
+		step.previous = _heightFieldPrevious.data();
+		_forEachBand([&step](size_t begin, size_t end)
+			{
+				WaterKernel::stepHeightField(step, begin, end);
+			});
+		_heightFieldCurrent.swap(_heightFieldPrevious);
+	}
+
+	// 位移为高度的坡度，高度低于半个网格间距内的阈值时坡度不会超过阈值
+	float threshold = std::max(_params.tileEpsilon, 1e-3f) * std::min(cellWidth, cellHeight) * 0.5f;
+	for (size_t i = 0; i < _heightFieldCurrent.size(); i++)
+	{
+		if (std::abs(_heightFieldCurrent[i]) > threshold || std::abs(_heightFieldPrevious[i]) > threshold)
+		{
+			return;
+		}
+	}
+	_resetHeightField();
+}
+
+/**
+ * @brief 清空高度场
+ * @details HeightField 模式下按顶点数量分配缓冲区，其他模式释放缓冲区
+ */
+void WaterField::_resetHeightField()
+{
+	if (_clickRippleEngine == WaterClickRippleEngine::HeightField)
+	{
+		_heightFieldCurrent.assign(_originX.size(), 0.0f);
+		_heightFieldPrevious.assign(_originX.size(), 0.0f);
+	}
+	else
+	{
+		std::vector<float>().swap(_heightFieldCurrent);
+		std::vector<float>().swap(_heightFieldPrevious);
+	}
+	_heightFieldActive = false;
+	_heightFieldTimeValid = false;
+}
+
+/**
+ * @brief 设置光线效果参数
+ * @param params 光线配置参数
+ * @details 控制波纹的透明度变化效果（光照模拟）。WaterLightingMode::Analytic 模式下透明度由位移对时间的解析导数计算，
+ * 不读取上一帧的位置和透明度，效果与帧率和模拟频率无关
+ */
+void WaterField::setLightParams(WaterLightParams params)
+{
+	finishUpdate();
+	_params.light = params;
+	_staticSimulations = 0;
+	_idle = false;
+}
+
+/**
+ * @brief 设置最大点击波纹数量
+ * @param count 允许同时存在的最大点击波纹数
+ * @details 按此数量预先分配点击波纹缓冲池，超过此数量时按 setClickRippleOverflow 设置的策略处理
+ */
+void WaterField::setMaxClickRipple(int count)
+{
+	finishUpdate();
+	_params.maxClickRipple = count;
+	_params.clickRipples.setCapacity(count);
+	_reserveFrameBuffers();
+}
+
+/**
+ * @brief 设置点击波纹数量达到上限时的处理策略
+ * @param policy 丢弃新波纹、替换最早的波纹或替换最弱的波纹（默认丢弃新波纹）
+ */
+void WaterField::setClickRippleOverflow(WaterClickRippleOverflow policy)
+{
+	finishUpdate();
+	_params.clickRippleOverflow = policy;
+}
+
+/**
+ * @brief 设置点击波纹的裁剪阈值
+ * @param epsilon 位移阈值（像素），0表示不裁剪
+ * @details 每个点击波纹只在位移可能超过此阈值的圆环内计算，圆环由起始时间、频率和密度确定，
+ * 被跳过的顶点上每个波纹的误差不超过此阈值，见 WaterKernel::clickRippleAnnulus
+ */
+void WaterField::setClickRippleEpsilon(float epsilon)
+{
+	finishUpdate();
+	_params.clickRippleEpsilon = epsilon;
+}
+
+/**
+ * @brief 设置位移内核的指令集路径
+ * @param isa 指令集路径（Scalar/SSE2/AVX2）
+ * @details 默认使用运行时检测到的最优路径，CPU不支持的路径会回退为检测结果；
+ * Precise 精度下始终使用 Scalar 路径，此设置在切换回 Fast 精度后生效
+ */
+void WaterField::setKernelIsa(WaterKernel::Isa isa)
+{
+	finishUpdate();
+	_kernelIsa = WaterKernel::isIsaSupported(isa) ? isa : WaterKernel::detectIsa();
+}
+
+/**
+ * @brief 获取当前使用的位移内核指令集路径
+ * @return 指令集路径
+ */
+WaterKernel::Isa WaterField::getKernelIsa() const
+{
+	return _kernelIsa;
+}
+
+/**
+ * @brief 设置超越函数的精度档位
+ * @param precision 精度档位，默认为 Fast
+ * @details Precise：只使用标量路径（忽略 setKernelIsa），使用标准库 sin/cos/exp/atan2 并逐顶点计算直线波纹（不使用可分离求值表），与原算法的公式完全相同；
+ * Fast：setKernelIsa 选择的路径，使用多项式近似和可分离求值表并去掉冗余的三角函数。
+ * 默认的 Fast 档位与原算法的输出并非逐位相同：按预设参数实测位移差约 1.2e-4 像素（上限 WaterKernel::kTolerance 即 1e-3 像素），
+ * 透明度差不超过 WaterKernel::kAlphaTolerance；可分离求值表与原公式float相位舍入之间的差异随时间增大，另见 WaterKernel::waveTableTolerance。
+ * 需要与原算法逐位一致的输出时设置为 Precise
+ */
+void WaterField::setPrecision(WaterKernel::Precision precision)
+{
+	finishUpdate();
+	_precision = precision;
+}
+
+/**
+ * @brief 获取超越函数的精度档位
+ * @return 精度档位
+ */
+WaterKernel::Precision WaterField::getPrecision() const
+{
+	return _precision;
+}
+
+/**
+ * @brief 获取实际使用的指令集路径
+ * @return Precise 精度下为 Scalar，否则为 setKernelIsa 的设置
+ */
+WaterKernel::Isa WaterField::_activeIsa() const
+{
+	return _precision == WaterKernel::Precision::Precise ? WaterKernel::Isa::Scalar : _kernelIsa;
+}
+
+/**
+ * @brief 设置顶点更新使用的线程数
+ * @param count 线程总数（含渲染线程），小于等于1时关闭并行模式
+ * @details 并行模式下网格按行切分为若干行带，由常驻线程池并行计算，空闲线程会窃取其他线程的行带；
+ * 每个顶点的计算互不依赖，结果与单线程完全一致
+ */
+void WaterField::setThreadCount(int count)
+{
+	finishUpdate();
+	if (count <= 1)
+	{
+		_threadPool.reset();
+		return;
+	}
+	if (_threadPool != nullptr && _threadPool->getThreadCount() == count)
+	{
+		return;
+	}
+	_threadPool.reset(new WaterThreadPool(count));
+}
+
+/**
+ * @brief 获取顶点更新使用的线程数
+ * @return 线程总数，单线程模式返回1
+ */
+int WaterField::getThreadCount() const
+{
+	return _threadPool != nullptr ? _threadPool->getThreadCount() : 1;
+}
+
+/**
+ * @brief 设置直线波纹是否使用可分离求值
+ * @param enabled 是否启用（默认启用）
+ * @details 启用后每帧为每个直线波纹构建行、列正弦余弦表，顶点上只做乘加运算，
+ * 三角函数调用从 O(顶点数×波纹数) 降为 O((行数+列数)×波纹数)，详见 WaterKernel::buildWaveTables；
+ * 只在 Fast 精度下生效，Precise 精度下逐顶点计算
+ */
+void WaterField::setSeparableWaves(bool enabled)
+{
+	finishUpdate();
+	_separableWaves = enabled;
+}
+
+/**
+ * @brief 获取直线波纹是否使用可分离求值
+ * @return 启用返回true
+ */
+bool WaterField::getSeparableWaves() const
+{
+	return _separableWaves;
+}
+
+/**
+ * @brief 设置固定波纹是否使用径向几何缓存
+ * @param enabled 是否启用（默认启用）
+ * @details 启用后为每个固定波纹缓存各顶点的 density·distance 和单位方向，每帧每顶点只需一次余弦；
+ * 缓存只在 initGrid 或 addFixedRipple 时构建，每个波纹占用 12 字节×顶点数
+ */
+void WaterField::setFixedRippleCache(bool enabled)
+{
+	finishUpdate();
+	if (_fixedRippleCacheEnabled == enabled)
+	{
+		return;
+	}
+	_fixedRippleCacheEnabled = enabled;
+	_rebuildFixedRippleCache();
+}
+
+/**
+ * @brief 获取固定波纹是否使用径向几何缓存
+ * @return 启用返回true
+ */
+bool WaterField::getFixedRippleCache() const
+{
+	return _fixedRippleCacheEnabled;
+}
+
+/**
+ * @brief 获取固定波纹几何缓存占用的内存
+ * @return 字节数
+ */
+size_t WaterField::getFixedRippleCacheBytes() const
+{
+	return (_fixedRipplePhase.capacity() + _fixedRippleDirX.capacity() + _fixedRippleDirY.capacity()
+		+ _fixedRipplePhasorCos.capacity() + _fixedRipplePhasorSin.capacity()) * sizeof(float);
+}
+
+/**
+ * @brief 设置固定波纹是否使用增量相量
+ * @param enabled 是否启用（默认关闭）
+ * @details 固定波纹的相位 frequency·time - density·distance 中后一项对每个顶点固定，相邻两次计算之间相位只旋转 frequency·Δt。
+ * 启用后为每个固定波纹保存各顶点的单位相量 (cos, sin)，每次计算只做一次复数乘法（旋转量以双精度按时间差求出），
+ * 每16次把模修正回1以限制累积误差，不再计算三角函数；相位按时间差累加，不再受 frequency·time 的float乘积精度限制。
+ * 只在 Fast 精度且启用径向几何缓存时生效，每个波纹另外占用 8 字节×顶点数；网格或固定波纹变化后的第一次计算以双精度重新求值。
+ * 直线波纹的可分离求值表每帧以双精度只按行列求值，顶点上已经没有三角函数，因此不使用增量相量
+ */
+void WaterField::setIncrementalPhasors(bool enabled)
+{
+	finishUpdate();
+	_incrementalPhasors = enabled;
+	_phasorsValid = false;
+	if (!enabled)
+	{
+		std::vector<float>().swap(_fixedRipplePhasorCos);
+		std::vector<float>().swap(_fixedRipplePhasorSin);
+	}
+}
+
+/**
+ * @brief 获取固定波纹是否使用增量相量
+ * @return 启用返回true
+ */
+bool WaterField::getIncrementalPhasors() const
+{
+	return _incrementalPhasors;
+}
+
+/**
+ * @brief 设置自适应网格
+ * @param params 自适应网格参数
+ * @details 启用后顶点只在波纹变化剧烈的地方（点击波纹的波前、固定波纹中心附近，以及波长较短时的整个水面）
+ * 细分到 gridSize 的密度，其余区域使用粗格子，顶点数和每帧的计算量随之减少；网格拓扑由 refineMesh 每帧按当前波纹调整。
+ * 顶点不再按行排列，可分离求值、点击波纹裁剪和分块跳过不再生效，三角面索引由 getMeshIndices 给出。
+ * 高度场模式需要规则网格，此时仍使用均匀网格。切换时像 initGrid 一样重置位移和透明度状态
+ */
+void WaterField::setQuadtreeMeshParams(WaterQuadtreeMeshParams params)
+{
+	finishUpdate();
+	params.levels = std::min(std::max(params.levels, 1), WaterQuadtreeMesh::kMaxLevels);
+	params.tolerance = std::max(params.tolerance, 0.0f);
+	params.refineInterval = std::max(params.refineInterval, 0.0f);
+	_quadtreeParams = params;
+	_applyMeshLayout();
+}
+
+/**
+ * @brief 获取自适应网格参数
+ * @return 参数
+ */
+WaterQuadtreeMeshParams WaterField::getQuadtreeMeshParams() const
+{
+	return _quadtreeParams;
+}
+
+/**
+ * @brief 判断当前是否使用自适应网格
+ * @return 已启用自适应网格、已初始化网格且点击波纹为 Analytic 模式时返回true
+ */
+bool WaterField::isQuadtreeMeshActive() const
+{
+	return _quadtreeActive;
+}
+
+/**
+ * @brief 按当前波纹调整自适应网格
+ * @param time 当前时间（秒）
+ * @return 顶点或三角面发生变化时返回true，调用方需要按 getVertexCount() 调整输出缓冲区并重新读取 getMeshIndices()
+ * @details 应在 update 之前调用，未使用自适应网格时直接返回false。每隔 refineInterval 秒
+ * 或波纹发生变化（添加波纹、清除参数、调整尺寸）后重新估计一次，其余调用直接返回。拓扑变化时新顶点的位移和透明度
+ * 由所在的旧格子插值得到，画面连续；只在拓扑变化时分配内存
+ */
+bool WaterField::refineMesh(float time)
+{
+	finishUpdate();
+	if (!_quadtreeActive)
+	{
+		return false;
+	}
+	// 上次的细分已经覆盖到 _meshRefineTime + refineInterval
+	if (_meshRefineValid && time >= _meshRefineTime && time < _meshRefineTime + _quadtreeParams.refineInterval)
+	{
+		return false;
+	}
+	_meshRefineTime = time;
+	_meshRefineValid = true;
+	// 与 update 一样先移除过期的点击波纹，已经消失的波纹不再保持细分
+	_params.clickRipples.removeExpired(time);
+	WaterKernel::Frame frame;
+	_collectKernelSources(time, frame);
+	if (!_quadtreeMesh.refine(frame, _quadtreeParams.tolerance, _quadtreeParams.refineInterval))
+	{
+		return false;
+	}
+	_remapMeshState();
+	_meshRevision++;
+	return true;
+}
+
+/**
+ * @brief 获取自适应网格的三角面索引
+ * @return 每三个顶点下标组成一个三角面；未使用自适应网格时为空，调用方按行生成均匀网格的索引
+ */
+const std::vector<unsigned int>& WaterField::getMeshIndices() const
+{
+	finishUpdate();
+	return _quadtreeMesh.getIndices();
+}
+
+/**
+ * @brief 获取网格拓扑的版本号
+ * @return 网格尺寸、网格类型或自适应网格的拓扑每次变化时加1；只改变绘制区域尺寸时不变
+ */
+unsigned long long WaterField::getMeshRevision() const
+{
+	finishUpdate();
+	return _meshRevision;
+}
+
+/**
+ * @brief 按自适应网格参数和点击波纹模式切换网格类型
+ * @details 需要自适应网格时按当前网格尺寸重新生成最粗的自适应网格，否则在自适应网格之后恢复均匀网格；
+ * 两种情况都重建固定波纹几何缓存并重置网格状态，进行中的后台网格重建按新的网格类型重新开始
+ */
+void WaterField::_applyMeshLayout()
+{
+	bool quadtree = _quadtreeParams.enabled && _clickRippleEngine == WaterClickRippleEngine::Analytic && _gridSize > 0;
+	if (!quadtree && !_quadtreeActive)
+	{
+		return;
+	}
+	_quadtreeActive = quadtree;
+	if (quadtree)
+	{
+		_quadtreeMesh.reset(_gridSize, _quadtreeParams.levels, _width, _height);
+		_columns = 0;
+		_originX.resize(_quadtreeMesh.getVertexCount());
+		_originY.resize(_quadtreeMesh.getVertexCount());
+		_quadtreeMesh.fillOrigins(_originX.data(), _originY.data());
+	}
+	else
+	{
+		_quadtreeMesh = WaterQuadtreeMesh();
+		_columns = static_cast<size_t>(_gridSize) + 1;
+		_originX.resize(_columns * _columns);
+		_originY.resize(_columns * _columns);
+		float rowY = 0.0f;
+		for (int row = 0; row <= _gridSize; row++)
+		{
+			size_t offset = row * _columns;
+			_fillOriginRow(_gridSize, row, rowY, _originX.data() + offset, _originY.data() + offset);
+		}
+	}
+	int pendingGridSize = _pendingGrid.gridSize;
+	if (pendingGridSize != 0)
+	{
+		_pendingGrid.gridSize = 0;
+		requestGridSize(pendingGridSize);
+	}
+	_rebuildFixedRippleCache();
+	_resetGridState();
+	_meshRevision++;
+}
+
+/**
+ * @brief 把网格状态换到细分之后的自适应网格
+ * @details 保留下来的顶点沿用原有状态，新顶点的位移和透明度由所在的旧格子双线性插值，
+ * 固定波纹几何缓存只为新顶点计算
+ */
+void WaterField::_remapMeshState()
+{
+	const std::vector<WaterQuadtreeMesh::Remap>& remap = _quadtreeMesh.getRemap();
+	size_t count = remap.size();
+	size_t previousCount = _originX.size();
+	std::vector<float> originX(count);
+	std::vector<float> originY(count);
+	_quadtreeMesh.fillOrigins(originX.data(), originY.data());
+
+	// 位置按相对原始坐标的位移插值，透明度直接插值
+	auto resample = [&remap, count](std::vector<float>& values, const float* previousOrigins, const float* origins)
+		{
+			std::vector<float> result(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				const WaterQuadtreeMesh::Remap& entry = remap[i];
+				if (entry.kept)
+				{
+					result[i] = values[entry.corners[0]];
+					continue;
+				}
+				float corners[4];
+				for (int k = 0; k < 4; k++)
+				{
+					corners[k] = values[entry.corners[k]] - (previousOrigins != nullptr ? previousOrigins[entry.corners[k]] : 0.0f);
+				}
+				float top = corners[0] + (corners[1] - corners[0]) * entry.u;
+				float bottom = corners[2] + (corners[3] - corners[2]) * entry.u;
+				result[i] = top + (bottom - top) * entry.v + (origins != nullptr ? origins[i] : 0.0f);
+			}
+			values.swap(result);
+		};
+	resample(_positionX, _originX.data(), originX.data());
+	resample(_positionY, _originY.data(), originY.data());
+	resample(_alpha, nullptr, nullptr);
+	if (_simulationRate > 0.0f)
+	{
+		resample(_previousX, _originX.data(), originX.data());
+		resample(_previousY, _originY.data(), originY.data());
+		resample(_previousAlpha, nullptr, nullptr);
+	}
+
+	// 保留下来的顶点复制原有的几何缓存，新顶点逐个计算
+	std::vector<float> phase(_fixedRippleCacheCount * count);
+	std::vector<float> dirX(_fixedRippleCacheCount * count);
+	std::vector<float> dirY(_fixedRippleCacheCount * count);
+	auto iter = _params.fixedRipples.begin();
+	for (size_t r = 0; r < _fixedRippleCacheCount; r++, ++iter)
+	{
+		WaterKernel::Ripple ripple;
+		ripple.x = iter->pos.x;
+		ripple.y = iter->pos.y;
+		ripple.density = iter->density;
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t target = r * count + i;
+			if (remap[i].kept)
+			{
+				size_t source = r * previousCount + remap[i].corners[0];
+				phase[target] = _fixedRipplePhase[source];
+				dirX[target] = _fixedRippleDirX[source];
+				dirY[target] = _fixedRippleDirY[source];
+			}
+			else
+			{
+				WaterKernel::buildRippleCache(&originX[i], &originY[i], 1, ripple, &phase[target], &dirX[target], &dirY[target]);
+			}
+		}
+	}
+	_fixedRipplePhase.swap(phase);
+	_fixedRippleDirX.swap(dirX);
+	_fixedRippleDirY.swap(dirY);
+
+	_originX.swap(originX);
+	_originY.swap(originY);
+	_offsetX.resize(count);
+	_offsetY.resize(count);
+	_phasorsValid = false;
+	_staticSimulations = 0;
+	_idle = false;
+	_lastOutput = WaterVertexSpan();
+}
+/**
+ * @brief 准备本次计算的增量相量
+ * @param frame 已填入几何缓存的内核输入，填入相量和旋转量
+ * @param time 模拟时刻（秒）
+ * @details 相量无效时按几何缓存以双精度重新求值（旋转量为0），否则按与上次的时间差求出每个波纹的旋转量
+ */
+void WaterField::_prepareFixedRipplePhasors(WaterKernel::Frame& frame, float time)
+{
+	size_t count = frame.vertexCount;
+	size_t rippleCount = frame.fixedRippleCount;
+	_fixedRippleRotation.resize(2 * rippleCount);
+	if (!_phasorsValid)
+	{
+		_fixedRipplePhasorCos.resize(rippleCount * count);
+		_fixedRipplePhasorSin.resize(rippleCount * count);
+		for (size_t r = 0; r < rippleCount; r++)
+		{
+			double angle = static_cast<double>(frame.fixedRipples[r].frequency) * time;
+			size_t offset = r * count;
+			_forEachBand([this, &frame, angle, offset](size_t begin, size_t end)
+				{
+					WaterKernel::buildRipplePhasors(frame.fixedRipplePhase + offset + begin, end - begin, angle,
+						_fixedRipplePhasorCos.data() + offset + begin, _fixedRipplePhasorSin.data() + offset + begin);
+				});
+			_fixedRippleRotation[2 * r] = 1.0f;
+			_fixedRippleRotation[2 * r + 1] = 0.0f;
+		}
+		_phasorsValid = true;
+		_phasorSteps = 0;
+	}
+	else
+	{
+		double interval = static_cast<double>(time) - _phasorTime;
+		for (size_t r = 0; r < rippleCount; r++)
+		{
+			double angle = static_cast<double>(frame.fixedRipples[r].frequency) * interval;
+			_fixedRippleRotation[2 * r] = static_cast<float>(std::cos(angle));
+			_fixedRippleRotation[2 * r + 1] = static_cast<float>(std::sin(angle));
+		}
+		_phasorSteps++;
+	}
+	_phasorTime = time;
+	frame.fixedRipplePhasorCos = _fixedRipplePhasorCos.data();
+	frame.fixedRipplePhasorSin = _fixedRipplePhasorSin.data();
+	frame.fixedRippleRotation = _fixedRippleRotation.data();
+	frame.fixedRipplePhasorRenormalize = _phasorSteps % kPhasorRenormalizeInterval == kPhasorRenormalizeInterval - 1;
+}
+
+/**
+ * @brief 为新添加的固定波纹追加几何缓存
+ * @param params 固定波纹参数
+ */
+void WaterField::_appendFixedRippleCache(const WaterRippleParams& params)
+{
+	size_t count = _originX.size();
+	if (!_fixedRippleCacheEnabled || count == 0)
+	{
+		return;
+	}
+	WaterKernel::Ripple ripple;
+	ripple.x = params.pos.x;
+	ripple.y = params.pos.y;
+	ripple.density = params.density;
+
+	size_t offset = _fixedRippleCacheCount * count;
+	_fixedRipplePhase.resize(offset + count);
+	_fixedRippleDirX.resize(offset + count);
+	_fixedRippleDirY.resize(offset + count);
+	WaterKernel::buildRippleCache(_originX.data(), _originY.data(), count, ripple, _fixedRipplePhase.data() + offset, _fixedRippleDirX.data() + offset, _fixedRippleDirY.data() + offset);
+	_fixedRippleCacheCount++;
+	_phasorsValid = false;
+}
+
+/**
+ * @brief 按当前网格和全部固定波纹重建几何缓存
+ * @details 进行中的后台网格重建已缓存的固定波纹可能已被替换，同样从头重新缓存
+ */
+void WaterField::_rebuildFixedRippleCache()
+{
+	_fixedRippleCacheCount = 0;
+	_phasorsValid = false;
+	_pendingGrid.cachedRipples = 0;
+	_pendingGrid.cachedVertices = 0;
+	_fixedRipplePhase.clear();
+	_fixedRippleDirX.clear();
+	_fixedRippleDirY.clear();
+	if (!_fixedRippleCacheEnabled)
+	{
+		_fixedRipplePhase.shrink_to_fit();
+		_fixedRippleDirX.shrink_to_fit();
+		_fixedRippleDirY.shrink_to_fit();
+		return;
+	}
+	for (auto& iter : _params.fixedRipples)
+	{
+		_appendFixedRippleCache(iter);
+	}
+}
+
+/**
+ * @brief 按当前网格和波纹数量预留逐帧使用的缓冲区
+ * @details 在参数或网格变化时调用，使 update 中的连续参数数组和可分离求值表不再扩容
+ */
+void WaterField::_reserveFrameBuffers()
+{
+	_kernelWaves.reserve(_params.waves.size());
+	_kernelFixedRipples.reserve(_params.fixedRipples.size());
+	_kernelClickRipples.reserve(_params.clickRipples.capacity());
+
+	size_t rows = _columns > 0 ? _originX.size() / _columns : 0;
+	_waveColumnSin.reserve(_params.waves.size() * _columns);
+	_waveColumnCos.reserve(_params.waves.size() * _columns);
+	_waveRowSin.reserve(_params.waves.size() * rows);
+	_waveRowCos.reserve(_params.waves.size() * rows);
+}
+
+/**
+ * @brief 整理当前帧的内核输入
+ * @param time 当前时间（秒）
+ * @return 指向SoA数组和连续参数数组的帧数据
+ * @details 把链表中的波纹参数复制到连续数组中（容量复用，不产生逐帧分配），
+ * 启用可分离求值时同时构建直线波纹的行、列表
+ */
+WaterKernel::Frame WaterField::_prepareKernelFrame(float time)
+{
+	WaterKernel::Frame frame;
+	_collectKernelSources(time, frame);
+	frame.originX = _originX.data();
+	frame.originY = _originY.data();
+	frame.offsetX = _offsetX.data();
+	frame.offsetY = _offsetY.data();
+	frame.time = time;
+	frame.clickRippleEpsilon = _params.clickRippleEpsilon;
+	frame.precision = _precision;
+	frame.positionX = _positionX.data();
+	frame.positionY = _positionY.data();
+	frame.alpha = _alpha.data();
+	frame.light.minDistance = _params.light.minDistance;
+	frame.light.defaultAlpha = _params.light.defaultAlpha;
+	frame.light.minAlpha = _params.light.minAlpha;
+	frame.light.decay = _params.light.decay;
+	frame.light.angle = _params.light.angle;
+	if (_params.light.mode == WaterLightingMode::Analytic)
+	{
+		// 解析光照不需要上一帧的位置，光照阶段之前位置数组用来暂存速度
+		frame.velocityX = _positionX.data();
+		frame.velocityY = _positionY.data();
+		frame.velocityInterval = _params.light.referenceInterval;
+	}
+
+	frame.columns = _columns;
+	frame.rows = _columns > 0 ? _originX.size() / _columns : 0;
+	if (_quadtreeActive)
+	{
+		frame.boundaryVertices = _quadtreeMesh.getBoundaryVertices().data();
+		frame.boundarySides = _quadtreeMesh.getBoundarySides().data();
+		frame.boundaryVertexCount = _quadtreeMesh.getBoundaryVertices().size();
+	}
+	// 查表使用和角公式，与逐顶点计算并非逐位相同，Precise 精度下不使用
+	if (_separableWaves && !_kernelWaves.empty() && frame.rows > 0 && _precision == WaterKernel::Precision::Fast)
+	{
+		_waveColumnSin.resize(_kernelWaves.size() * frame.columns);
+		_waveColumnCos.resize(_kernelWaves.size() * frame.columns);
+		_waveRowSin.resize(_kernelWaves.size() * frame.rows);
+		_waveRowCos.resize(_kernelWaves.size() * frame.rows);
+		WaterKernel::buildWaveTables(frame, _waveColumnSin.data(), _waveColumnCos.data(), _waveRowSin.data(), _waveRowCos.data());
+		frame.waveColumnSin = _waveColumnSin.data();
+		frame.waveColumnCos = _waveColumnCos.data();
+		frame.waveRowSin = _waveRowSin.data();
+		frame.waveRowCos = _waveRowCos.data();
+	}
+
+	frame.vertexCount = _originX.size();
+	if (_heightFieldActive)
+	{
+		frame.heightField = _heightFieldCurrent.data();
+		frame.heightFieldPrevious = _heightFieldPrevious.data();
+		frame.heightFieldRate = 1.0f / _heightFieldInterval();
+	}
+	if (_fixedRippleCacheEnabled && _fixedRippleCacheCount == _kernelFixedRipples.size() && _fixedRipplePhase.size() == _fixedRippleCacheCount * frame.vertexCount)
+	{
+		frame.fixedRipplePhase = _fixedRipplePhase.data();
+		frame.fixedRippleDirX = _fixedRippleDirX.data();
+		frame.fixedRippleDirY = _fixedRippleDirY.data();
+	}
+	if (_incrementalPhasors && frame.fixedRipplePhase != nullptr && frame.fixedRippleCount > 0 && _precision == WaterKernel::Precision::Fast)
+	{
+		_prepareFixedRipplePhasors(frame, time);
+	}
+	else
+	{
+		_phasorsValid = false;
+	}
+	return frame;
+}
+
+/**
+ * @brief 把链表中的波纹参数复制到连续数组中
+ * @param time 当前时间（秒），用于计算点击波纹的经过时间
+ * @param frame 输出：填入直线波纹、固定波纹和点击波纹的指针和数量
+ */
+void WaterField::_collectKernelSources(float time, WaterKernel::Frame& frame)
+{
+	_kernelWaves.clear();
+	for (auto& iter : _params.waves)
+	{
+		WaterKernel::Wave wave;
+		wave.A = iter.A;
+		wave.B = iter.B;
+		wave.amplitude = iter.basicParams.amplitude;
+		wave.frequency = iter.basicParams.frequency;
+		wave.density = iter.basicParams.density;
+		wave.phi = iter.basicParams.phi;
+		_kernelWaves.push_back(wave);
+	}
+
+	_kernelFixedRipples.clear();
+	for (auto& iter : _params.fixedRipples)
+	{
+		WaterKernel::Ripple ripple;
+		ripple.x = iter.pos.x;
+		ripple.y = iter.pos.y;
+		ripple.amplitude = iter.amplitude;
+		ripple.frequency = iter.frequency;
+		ripple.density = iter.density;
+		_kernelFixedRipples.push_back(ripple);
+	}
+
+	_kernelClickRipples.clear();
+	for (size_t i = 0; i < _params.clickRipples.size(); i++)
+	{
+		const WaterClickRippleParams& iter = _params.clickRipples[i];
+		WaterKernel::ClickRipple ripple;
+		ripple.x = iter.rippleParams.pos.x;
+		ripple.y = iter.rippleParams.pos.y;
+		ripple.amplitude = iter.rippleParams.amplitude;
+		ripple.frequency = iter.rippleParams.frequency;
+		ripple.density = iter.rippleParams.density;
+		ripple.elapsed = time - iter.startTime;
+		_kernelClickRipples.push_back(ripple);
+	}
+
+	frame.waves = _kernelWaves.data();
+	frame.waveCount = _kernelWaves.size();
+	frame.fixedRipples = _kernelFixedRipples.data();
+	frame.fixedRippleCount = _kernelFixedRipples.size();
+	frame.clickRipples = _kernelClickRipples.data();
+	frame.clickRippleCount = _kernelClickRipples.size();
+}
+
+/**
+ * @brief 初始化水波纹网格
+ * @param gridSize 网格尺寸（必须大于0）
+ * @param width 绘制区域宽度
+ * @param height 绘制区域高度
+ * @details 创建 (gridSize+1)×(gridSize+1) 个顶点，按行存储，首末行列分别位于绘制区域的边缘；
+ * 所有内部缓冲区在此分配，之后的 update 不再分配内存。启用自适应网格时改为生成最粗的自适应网格，见 setQuadtreeMeshParams
+ * @note 只有绘制区域尺寸变化时应调用 resize，它复用现有缓冲区
+ */
+void WaterField::initGrid(int gridSize, float width, float height)
+{
+	finishUpdate();
+	assert(gridSize > 0);
+	if (gridSize <= 0)
+	{
+		return;
+	}
+	_width = width;
+	_height = height;
+	if (gridSize == _gridSize)
+	{
+		// 网格尺寸不变时取消后台切换，在原有缓冲区中重新计算
+		requestGridSize(gridSize);
+		_relayoutGrid();
+		return;
+	}
+	// 与后台切换共用生成流程，一次完成全部工作
+	_gridSize = 0;
+	_pendingGrid.gridSize = 0;
+	requestGridSize(gridSize);
+	commitGridRebuild();
+}
+
+/**
+ * @brief 按行带执行任务
+ * @param task 任务，参数为顶点区间 [begin, end)
+ * @details 单线程模式直接处理全部顶点；并行模式按行切分（自适应网格按 kBandVertices 个顶点切分），
+ * 行带数量多于线程数以便负载不均时窃取
+ */
+template <typename Task>
+void WaterField::_forEachBand(const Task& task)
+{
+	size_t vertexCount = _originX.size();
+	if (_threadPool == nullptr)
+	{
+		task(0, vertexCount);
+		return;
+	}
+
+	struct Bands
+	{
+		const Task* task;
+		size_t columns;
+		size_t rows;
+		size_t count;
+		size_t vertexCount;
+	};
+	// 自适应网格没有行，按固定数量的顶点切分
+	size_t columns = _columns > 0 ? _columns : kBandVertices;
+	size_t rows = (vertexCount + columns - 1) / columns;
+	Bands bands = { &task, columns, rows, std::min(rows, static_cast<size_t>(_threadPool->getThreadCount()) * 4), vertexCount };
+	// 只捕获一个指针，std::function 可以内联存储，不产生逐帧分配
+	_threadPool->run(bands.count, [&bands](size_t band)
+		{
+			size_t begin = std::min(bands.rows * band / bands.count * bands.columns, bands.vertexCount);
+			size_t end = std::min(bands.rows * (band + 1) / bands.count * bands.columns, bands.vertexCount);
+			(*bands.task)(begin, end);
+		});
+}
+
+/**
+ * @brief 更新一帧并写出顶点
+ * @param time 当前时间（秒）
+ * @param output 输出缓冲区，至少能容纳 getVertexCount() 个顶点
+ * @details 计算所有波纹的叠加效果并把顶点位置和透明度写入 output：
+ * 1. 移除过期的点击波纹（每帧一次）
+ * 2. 由 WaterKernel 在SoA数组上计算直线波纹、固定波纹和点击波纹的偏移
+ * 3. 应用边界约束
+ * 4. 计算顶点透明度变化
+ * 并行模式下 2~4 步及写出按行带分配给线程池执行。透明度依赖上一帧的位置，由本对象保存，
+ * 因此 output 可以每帧不同
+ */
+void WaterField::update(float time, const WaterVertexSpan& output)
+{
+	finishUpdate();
+#if WATER_EFFECT_STATS
+	for (auto& nanoseconds : _stageNanoseconds)
+	{
+		nanoseconds.store(0, std::memory_order_relaxed);
+	}
+	auto start = std::chrono::steady_clock::now();
+	_update(time, output);
+	float updateMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	for (size_t i = 0; i < _stageNanoseconds.size(); i++)
+	{
+		_statsWindows[i].push(static_cast<float>(_stageNanoseconds[i].load(std::memory_order_relaxed)) * 1e-6f);
+	}
+	_statsWindows[static_cast<size_t>(WaterStage::Update)].push(updateMs);
+#else
+	_update(time, output);
+#endif
+}
+
+/**
+ * @brief 在后台线程开始更新一帧
+ * @param time 要计算的时刻（秒），通常为预测的下一帧显示时间
+ * @param output 输出缓冲区，finishUpdate 之前调用方不能读写
+ * @details 与 update 的计算相同，调用后立即返回，调用方可以同时提交上一帧的顶点。
+ * 进行中的后台更新在 update、finishUpdate 以及任何修改参数、网格或读取模拟状态的调用开始时先完成，
+ * 因此在更新进行中调整参数是安全的，改动从下一次更新开始生效
+ */
+void WaterField::beginUpdate(float time, const WaterVertexSpan& output)
+{
+	finishUpdate();
+	if (_updateWorker == nullptr)
+	{
+		_updateWorker = std::make_unique<WaterBackgroundWorker>();
+		_updateJob = [this]()
+			{
+				update(_pendingTime, _pendingOutput);
+			};
+	}
+	_pendingTime = time;
+	_pendingOutput = output;
+	_updateWorker->start(_updateJob);
+}
+
+/**
+ * @brief 等待后台更新完成
+ * @details 没有进行中的后台更新时立即返回；之后 beginUpdate 的输出缓冲区可以读取
+ */
+void WaterField::finishUpdate() const
+{
+	if (_updateWorker != nullptr)
+	{
+		_updateWorker->wait();
+	}
+}
+
+/**
+ * @brief 判断是否有进行中的后台更新
+ * @return 已调用 beginUpdate 且尚未完成时返回true
+ */
+bool WaterField::isUpdatePending() const
+{
+	return _updateWorker != nullptr && _updateWorker->isBusy();
+}
+
+/**
+ * @brief update 的实现
+ * @param time 当前时间（秒）
+ * @param output 输出缓冲区
+ */
+void WaterField::_update(float time, const WaterVertexSpan& output)
+{
+	_params.clickRipples.removeExpired(time);
+
+	if (_originX.empty())
+	{
+		return;
+	}
+	bool isStatic = _params.waves.empty() && _params.fixedRipples.empty() && _params.clickRipples.size() == 0 && !_heightFieldActive;
+	if (!isStatic)
+	{
+		_staticSimulations = 0;
+		_idle = false;
+	}
+	// 输出缓冲区与上次不同时需要完整写出，否则只写出发生变化的分块
+	bool writeAll = output.x != _lastOutput.x || output.y != _lastOutput.y || output.alpha != _lastOutput.alpha || output.stride != _lastOutput.stride || output.alphaStride != _lastOutput.alphaStride
+		|| output.offsetX != _lastOutput.offsetX || output.offsetY != _lastOutput.offsetY;
+	_lastOutput = output;
+	if (_idle)
+	{
+		// 状态不再变化，输出缓冲区与上次相同时无需重写
+		if (writeAll)
+		{
+			_forEachBand([this, &output](size_t begin, size_t end)
+				{
+					_writeInterpolated(output, 1.0f, begin, end);
+				});
+		}
+		return;
+	}
+
+	if (_simulationRate <= 0.0f)
+	{
+		_writeAll = writeAll;
+		_simulate(time, output);
+	}
+	else
+	{
+		// 提前计算下一个模拟时刻的状态，在当前时刻与其之间插值，点击波纹不会因降低模拟频率而延迟出现
+		long long tick = static_cast<long long>(std::floor(static_cast<double>(time) * _simulationRate));
+		if (!_simulationValid || tick != _simulationTick)
+		{
+			if (!_simulationValid || tick != _simulationTick + 1)
+			{
+				_simulate(static_cast<float>(tick / static_cast<double>(_simulationRate)), WaterVertexSpan());
+			}
+			_previousX = _positionX;
+			_previousY = _positionY;
+			_previousAlpha = _alpha;
+			_simulate(static_cast<float>((tick + 1) / static_cast<double>(_simulationRate)), WaterVertexSpan());
+			_simulationTick = tick;
+			_simulationValid = true;
+		}
+		float weight = static_cast<float>(static_cast<double>(time) * _simulationRate - tick);
+		weight = std::min(std::max(weight, 0.0f), 1.0f);
+		_forEachBand([this, &output, weight](size_t begin, size_t end)
+			{
+				_writeInterpolated(output, weight, begin, end);
+			});
+	}
+
+	if (isStatic && _isSettled())
+	{
+		_idle = true;
+	}
+}
+
+/**
+ * @brief 设置模拟频率
+ * @param hz 每秒模拟次数，小于等于0时每次 update 都完整计算（默认）
+ * @details 启用后只在 1/hz 秒的整数倍时刻计算网格，两个模拟时刻之间对顶点位置和透明度做线性插值，
+ * 每帧只需一次插值写出；适合刷新率远高于水波变化速度的场合。
+ * 透明度按相邻两次模拟之间的位移计算，因此模拟频率会影响光照效果的强弱；WaterLightingMode::Analytic 模式下不受影响
+ */
+void WaterField::setSimulationRate(float hz)
+{
+	finishUpdate();
+	_simulationRate = hz > 0.0f ? hz : 0.0f;
+	_simulationValid = false;
+	_staticSimulations = 0;
+	_idle = false;
+	if (_simulationRate > 0.0f)
+	{
+		_previousX = _positionX;
+		_previousY = _positionY;
+		_previousAlpha = _alpha;
+	}
+	else
+	{
+		std::vector<float>().swap(_previousX);
+		std::vector<float>().swap(_previousY);
+		std::vector<float>().swap(_previousAlpha);
+	}
+}
+
+/**
+ * @brief 获取模拟频率
+ * @return 每秒模拟次数，0表示每次 update 都完整计算
+ */
+float WaterField::getSimulationRate() const
+{
+	return _simulationRate;
+}
+
+/**
+ * @brief 判断当前是否处于静止状态
+ * @return 没有任何波纹且顶点已回到静止位置和透明度时返回true，此时 update 不做计算
+ */
+bool WaterField::isIdle() const
+{
+	finishUpdate();
+	return _idle;
+}
+
+/**
+ * @brief 使上次写出的输出失效
+ * @details 下一次 update 完整写出全部顶点；输出缓冲区的内容被调用方改写（例如重新填充颜色数组）后调用
+ */
+void WaterField::invalidateOutput()
+{
+	finishUpdate();
+	_lastOutput = WaterVertexSpan();
+}
+
+/**
+ * @brief 计算一个模拟时刻的网格状态
+ * @param time 模拟时刻（秒）
+ * @param output 输出缓冲区，指针为空时只更新内部状态
+ * @details 更新内部的位置和透明度；计时结果用于自动调整网格尺寸
+ */
+void WaterField::_simulate(float time, const WaterVertexSpan& output)
+{
+	auto start = std::chrono::steady_clock::now();
+	_advanceHeightField(time);
+#if WATER_EFFECT_STATS
+	if (_heightFieldActive)
+	{
+		long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		_stageNanoseconds[static_cast<size_t>(WaterStage::ClickRipples)].fetch_add(nanoseconds, std::memory_order_relaxed);
+	}
+#endif
+	WaterKernel::Frame frame = _prepareKernelFrame(time);
+	_markTiles(frame);
+	_forEachBand([this, &frame, &output](size_t begin, size_t end)
+		{
+			_updateRange(frame, output, begin, end);
+		});
+	if (_params.waves.empty() && _params.fixedRipples.empty() && _params.clickRipples.size() == 0 && !_heightFieldActive)
+	{
+		_staticSimulations++;
+	}
+	_adaptGridSize(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+/**
+ * @brief 在前后两个模拟状态之间插值并写出
+ * @param output 输出缓冲区
+ * @param weight 后一个状态的权重 [0, 1]
+ * @param begin 起始顶点下标
+ * @param end 结束顶点下标（不含）
+ * @details 未启用模拟频率或权重为1时直接写出当前状态
+ */
+void WaterField::_writeInterpolated(const WaterVertexSpan& output, float weight, size_t begin, size_t end)
+{
+	if (_simulationRate <= 0.0f || weight >= 1.0f)
+	{
+		_writeRange(output, begin, end);
+		return;
+	}
+	const float* previous[] = { _previousX.data(), _previousY.data(), _previousAlpha.data() };
+	const float* current[] = { _positionX.data(), _positionY.data(), _alpha.data() };
+	float* targets[] = { output.x, output.y, output.alpha };
+	size_t strides[] = { output.stride, output.stride, output.alphaStride != 0 ? output.alphaStride : output.stride };
+	float offsets[] = { output.offsetX, output.offsetY, 0.0f };
+	for (int k = 0; k < 3; k++)
+	{
+		if (targets[k] == nullptr)
+		{
+			continue;
+		}
+		char* target = reinterpret_cast<char*>(targets[k]) + begin * strides[k];
+		for (size_t i = begin; i < end; i++, target += strides[k])
+		{
+			*reinterpret_cast<float*>(target) = previous[k][i] + (current[k][i] - previous[k][i]) * weight + offsets[k];
+		}
+	}
+}
+
+/**
+ * @brief 判断网格是否已回到静止状态
+ * @return 位置等于原始位置、透明度等于稳定值（启用模拟频率时前后两个状态都满足）时返回true
+ * @details 没有波纹时偏移为0，一次模拟后位置即回到原位；透明度每次最多变化0.1，需要若干次模拟才能收敛
+ */
+bool WaterField::_isSettled() const
+{
+	size_t required = _simulationRate > 0.0f ? 2 : 1;
+	if (_staticSimulations < required)
+	{
+		return false;
+	}
+	float steady = std::min(std::max(_params.light.defaultAlpha, _params.light.minAlpha), 1.0f);
+	for (size_t i = 0; i < _alpha.size(); i++)
+	{
+		if (_alpha[i] != steady || (required == 2 && _previousAlpha[i] != steady))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief 更新一段连续顶点
+ * @param frame 当前帧的内核输入
+ * @param output 输出缓冲区
+ * @param begin 起始顶点下标
+ * @param end 结束顶点下标（不含）
+ * @details 由 _runKernel 计算位移、应用边界约束并计算透明度，再写入 output，只读写区间内的顶点；
+ * 启用分块时交给 _updateTiles 处理
+ */
+void WaterField::_updateRange(const WaterKernel::Frame& frame, const WaterVertexSpan& output, size_t begin, size_t end)
+{
+	// 各阶段耗时先在本地累加，区间结束时一次性计入本帧统计
+	long long stageNanoseconds[static_cast<size_t>(WaterStage::Update)] = {};
+	if (!_tilesEnabled)
+	{
+		_runKernel(frame, begin, end, stageNanoseconds);
+		_writeRange(output, begin, end);
+	}
+	else
+	{
+		_updateTiles(frame, output, begin, end, stageNanoseconds);
+	}
+#if WATER_EFFECT_STATS
+	for (size_t i = 0; i < _stageNanoseconds.size(); i++)
+	{
+		_stageNanoseconds[i].fetch_add(stageNanoseconds[i], std::memory_order_relaxed);
+	}
+#endif
+}
+
+/**
+ * @brief 按分块更新一段连续顶点
+ * @param frame 当前帧的内核输入
+ * @param output 输出缓冲区
+ * @param begin 起始顶点下标（行首）
+ * @param end 结束顶点下标（不含，行首）
+ * @param stageNanoseconds 各阶段耗时（纳秒）
+ * @details 只计算活跃分块，需要复位的分块写入静止状态，其余分块只在需要完整写出时写出
+ */
+void WaterField::_updateTiles(const WaterKernel::Frame& frame, const WaterVertexSpan& output, size_t begin, size_t end, long long* stageNanoseconds)
+{
+
+	// 区间按整行划分，逐行把模式相同的相邻分块合并为一段连续顶点处理
+	float steady = std::min(std::max(_params.light.defaultAlpha, _params.light.minAlpha), 1.0f);
+	for (size_t rowStart = begin; rowStart < end; rowStart += _columns)
+	{
+		const unsigned char* modes = _tileModes.data() + rowStart / _columns / kTileSize * _tileColumns;
+		for (size_t tile = 0; tile < _tileColumns;)
+		{
+			unsigned char mode = modes[tile];
+			size_t last = tile + 1;
+			while (last < _tileColumns && modes[last] == mode)
+			{
+				last++;
+			}
+			size_t runBegin = rowStart + tile * kTileSize;
+			size_t runEnd = rowStart + std::min(last * kTileSize, _columns);
+			if (mode == TileActive)
+			{
+				_runKernel(frame, runBegin, runEnd, stageNanoseconds);
+			}
+			else
+			{
+				// 跳过计算的分块也要把增量相量旋转到本帧
+				WaterKernel::advanceFixedRipplePhasors(frame, runBegin, runEnd);
+			}
+			if (mode == TileReset)
+			{
+				// 静止位置为零位移经过边界约束后的位置
+				std::fill(_offsetX.begin() + runBegin, _offsetX.begin() + runEnd, 0.0f);
+				std::fill(_offsetY.begin() + runBegin, _offsetY.begin() + runEnd, 0.0f);
+				WaterKernel::applyBoundary(frame, runBegin, runEnd);
+				for (size_t i = runBegin; i < runEnd; i++)
+				{
+					_positionX[i] = _originX[i] + _offsetX[i];
+					_positionY[i] = _originY[i] + _offsetY[i];
+					_alpha[i] = steady;
+				}
+			}
+			if (mode != TileRest || _writeAll)
+			{
+				_writeRange(output, runBegin, runEnd);
+			}
+			tile = last;
+		}
+	}
+}
+
+/**
+ * @brief 对一段连续顶点执行内核更新
+ * @param frame 当前帧的内核输入
+ * @param begin 起始顶点下标
+ * @param end 结束顶点下标（不含）
+ * @param stageNanoseconds 启用统计时按 WaterStage 累加各阶段耗时（纳秒）
+ * @details 不统计时直接调用 WaterKernel::update，统计时逐阶段调用并计时
+ */
+void WaterField::_runKernel(const WaterKernel::Frame& frame, size_t begin, size_t end, long long* stageNanoseconds)
+{
+#if WATER_EFFECT_STATS
+	WaterKernel::Isa isa = _activeIsa();
+	auto start = std::chrono::steady_clock::now();
+	auto lap = [&start, stageNanoseconds](WaterStage stage)
+		{
+			auto now = std::chrono::steady_clock::now();
+			stageNanoseconds[static_cast<size_t>(stage)] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+			start = now;
+		};
+	WaterKernel::resetDisplacement(frame, begin, end);
+	WaterKernel::accumulateWaves(isa, frame, begin, end);
+	lap(WaterStage::Waves);
+	WaterKernel::accumulateFixedRipples(isa, frame, begin, end);
+	lap(WaterStage::FixedRipples);
+	WaterKernel::accumulateClickRipples(isa, frame, begin, end);
+	WaterKernel::accumulateHeightField(frame, begin, end);
+	lap(WaterStage::ClickRipples);
+	WaterKernel::applyBoundary(frame, begin, end);
+	lap(WaterStage::Boundary);
+	WaterKernel::applyLighting(frame, begin, end);
+	lap(WaterStage::Lighting);
+#else
+	(void)stageNanoseconds;
+	WaterKernel::update(_activeIsa(), frame, begin, end);
+#endif
+}
+
+/**
+ * @brief 标记本次模拟需要计算的分块
+ * @param frame 当前帧的内核输入
+ * @details 直线波纹和固定波纹的位移不随距离衰减，振幅之和超过阈值或启用了高度场时所有分块都需要计算（此时不启用分块）；
+ * 否则每个点击波纹只标记与其有效圆环（位移可能超过阈值的区域）相交的分块。
+ * 未标记的分块保持静止位置和稳定透明度：上次模拟时有变化的分块复位一次，之后不再处理
+ */
+void WaterField::_markTiles(const WaterKernel::Frame& frame)
+{
+	size_t tileCount = _tileModes.size();
+	float epsilon = _params.tileEpsilon;
+	float velocityInterval = frame.velocityX != nullptr ? frame.velocityInterval : 0.0f;
+	// 解析光照时速度乘以参考间隔也不能超过阈值
+	float globalAmplitude = 0.0f;
+	for (size_t i = 0; i < frame.waveCount; i++)
+	{
+		globalAmplitude += std::abs(frame.waves[i].amplitude) * std::max(1.0f, std::abs(frame.waves[i].frequency) * velocityInterval);
+	}
+	for (size_t i = 0; i < frame.fixedRippleCount; i++)
+	{
+		globalAmplitude += std::abs(frame.fixedRipples[i].amplitude) * std::max(1.0f, std::abs(frame.fixedRipples[i].frequency) * velocityInterval);
+	}
+	// 高度场覆盖整个网格，启用时所有分块都需要计算；自适应网格的顶点不按行排列，不能分块
+	_tilesEnabled = epsilon > 0.0f && globalAmplitude <= epsilon && frame.heightField == nullptr && frame.columns > 0;
+	if (!_tilesEnabled)
+	{
+		std::fill(_tileActive.begin(), _tileActive.end(), 1);
+		_updatedTiles = tileCount;
+		_skippedTiles = 0;
+		return;
+	}
+
+	std::fill(_tileModes.begin(), _tileModes.end(), TileRest);
+	for (size_t k = 0; k < frame.clickRippleCount; k++)
+	{
+		const WaterKernel::ClickRipple& ripple = frame.clickRipples[k];
+		WaterKernel::Annulus annulus;
+		if (!WaterKernel::clickRippleAnnulus(ripple, epsilon, annulus, velocityInterval))
+		{
+			continue;
+		}
+		for (size_t row = 0; row < _tileRows; row++)
+		{
+			float dy = std::max(std::max(_tileMinY[row] - ripple.y, ripple.y - _tileMaxY[row]), 0.0f);
+			if (dy > annulus.outerRadius)
+			{
+				continue;
+			}
+			float farY = std::max(std::abs(ripple.y - _tileMinY[row]), std::abs(ripple.y - _tileMaxY[row]));
+			for (size_t column = 0; column < _tileColumns; column++)
+			{
+				float dx = std::max(std::max(_tileMinX[column] - ripple.x, ripple.x - _tileMaxX[column]), 0.0f);
+				float farX = std::max(std::abs(ripple.x - _tileMinX[column]), std::abs(ripple.x - _tileMaxX[column]));
+				float nearest = std::sqrt(dx * dx + dy * dy);
+				float farthest = std::sqrt(farX * farX + farY * farY);
+				if (nearest <= annulus.outerRadius && farthest >= annulus.innerRadius)
+				{
+					_tileModes[row * _tileColumns + column] = TileActive;
+				}
+			}
+		}
+	}
+
+	_updatedTiles = 0;
+	for (size_t i = 0; i < tileCount; i++)
+	{
+		if (_tileModes[i] == TileActive)
+		{
+			_updatedTiles++;
+		}
+		else if (_tileActive[i] != 0)
+		{
+			_tileModes[i] = TileReset;
+		}
+		_tileActive[i] = _tileModes[i] == TileActive ? 1 : 0;
+	}
+	_skippedTiles = tileCount - _updatedTiles;
+}
+
+/**
+ * @brief 把当前状态写出到输出缓冲区
+ * @param output 输出缓冲区（为空的指针跳过）
+ * @param begin 起始顶点下标
+ * @param end 结束顶点下标（不含）
+ */
+void WaterField::_writeRange(const WaterVertexSpan& output, size_t begin, size_t end)
+{
+	const float* sources[] = { _positionX.data(), _positionY.data(), _alpha.data() };
+	float* targets[] = { output.x, output.y, output.alpha };
+	size_t strides[] = { output.stride, output.stride, output.alphaStride != 0 ? output.alphaStride : output.stride };
+	float offsets[] = { output.offsetX, output.offsetY, 0.0f };
+	for (int k = 0; k < 3; k++)
+	{
+		if (targets[k] == nullptr)
+		{
+			continue;
+		}
+		if (strides[k] == sizeof(float) && offsets[k] == 0.0f)
+		{
+			std::memcpy(targets[k] + begin, sources[k] + begin, (end - begin) * sizeof(float));
+			continue;
+		}
+		char* target = reinterpret_cast<char*>(targets[k]) + begin * strides[k];
+		for (size_t i = begin; i < end; i++, target += strides[k])
+		{
+			*reinterpret_cast<float*>(target) = sources[k][i] + offsets[k];
+		}
+	}
+}
+
+/**
+ * @brief 获取网格尺寸
+ * @return 每行的格子数，未初始化时返回0
+ */
+int WaterField::getGridSize() const
+{
+	return _gridSize;
+}
+
+/**
+ * @brief 获取顶点数量
+ * @return 顶点数量
+ */
+size_t WaterField::getVertexCount() const
+{
+	return _originX.size();
+}
+
+/**
+ * @brief 获取顶点原始X坐标
+ * @return 长度为 getVertexCount() 的数组
+ */
+const float* WaterField::getOriginX() const
+{
+	return _originX.data();
+}
+
+/**
+ * @brief 获取顶点原始Y坐标
+ * @return 长度为 getVertexCount() 的数组
+ */
+const float* WaterField::getOriginY() const
+{
+	return _originY.data();
+}
+
+/**
+ * @brief 获取当前参数
+ * @return 参数
+ */
+const WaterEffectParams& WaterField::getParams() const
+{
+	finishUpdate();
+	return _params;
+}
+
+/**
+ * @brief 请求分帧切换到新的网格尺寸
+ * @param gridSize 新的网格尺寸（必须大于0）
+ * @details 新网格（顶点和固定波纹几何缓存）在后台缓冲区中由 stepGridRebuild 分帧生成，
+ * 生成期间继续使用当前网格；与当前尺寸相同时取消进行中的重建。绘制区域尺寸不变，尺寸变化时调用 resize
+ */
+void WaterField::requestGridSize(int gridSize)
+{
+	finishUpdate();
+	if (gridSize <= 0 || gridSize == _pendingGrid.gridSize)
+	{
+		return;
+	}
+	PendingGrid& pending = _pendingGrid;
+	pending.gridSize = 0;
+	pending.originX.clear();
+	pending.originY.clear();
+	pending.fixedRipplePhase.clear();
+	pending.fixedRippleDirX.clear();
+	pending.fixedRippleDirY.clear();
+	if (gridSize == _gridSize)
+	{
+		return;
+	}
+	size_t count = (static_cast<size_t>(gridSize) + 1) * (static_cast<size_t>(gridSize) + 1);
+	pending.gridSize = gridSize;
+	pending.nextRow = 0;
+	pending.rowY = 0.0f;
+	pending.cachedRipples = 0;
+	pending.cachedVertices = 0;
+	if (_quadtreeActive)
+	{
+		// 自适应网格在提交时按新尺寸重新生成最粗的网格，不需要后台缓冲区
+		return;
+	}
+	pending.originX.resize(count);
+	pending.originY.resize(count);
+}
+
+/**
+ * @brief 获取正在后台生成的网格尺寸
+ * @return 网格尺寸，没有进行中的重建时返回0
+ */
+int WaterField::getPendingGridSize() const
+{
+	finishUpdate();
+	return _pendingGrid.gridSize;
+}
+
+/**
+ * @brief 推进后台网格的生成
+ * @return 新网格已全部生成、可以提交时返回true
+ * @details 每次调用最多处理 getGridRebuildBudget() 个顶点（生成一个顶点或为一个顶点缓存一个固定波纹各算一个），
+ * 应在 update 之前调用，返回true后调用 commitGridRebuild
+ */
+bool WaterField::stepGridRebuild()
+{
+	finishUpdate();
+	return _stepGridRebuild(_gridRebuildBudget);
+}
+
+/**
+ * @brief 推进后台网格的生成
+ * @param budget 本次最多处理的顶点数量
+ * @return 新网格已全部生成时返回true
+ */
+bool WaterField::_stepGridRebuild(size_t budget)
+{
+	PendingGrid& pending = _pendingGrid;
+	int gridSize = pending.gridSize;
+	if (gridSize == 0)
+	{
+		return false;
+	}
+	if (_quadtreeActive)
+	{
+		return true;
+	}
+
+	size_t work = 0;
+	size_t columns = static_cast<size_t>(gridSize) + 1;
+	for (; pending.nextRow <= gridSize && work < budget; pending.nextRow++)
+	{
+		size_t offset = pending.nextRow * columns;
+		_fillOriginRow(gridSize, pending.nextRow, pending.rowY, pending.originX.data() + offset, pending.originY.data() + offset);
+		work += columns;
+	}
+	if (pending.nextRow <= gridSize)
+	{
+		return false;
+	}
+
+	// 固定波纹在生成期间可能增加，每次按当前数量补齐缓存
+	size_t count = pending.originX.size();
+	size_t rippleCount = _fixedRippleCacheEnabled ? _params.fixedRipples.size() : 0;
+	if (pending.cachedRipples >= rippleCount)
+	{
+		return true;
+	}
+	pending.fixedRipplePhase.resize(rippleCount * count);
+	pending.fixedRippleDirX.resize(rippleCount * count);
+	pending.fixedRippleDirY.resize(rippleCount * count);
+	auto iter = std::next(_params.fixedRipples.begin(), pending.cachedRipples);
+	while (pending.cachedRipples < rippleCount && work < budget)
+	{
+		WaterKernel::Ripple ripple;
+		ripple.x = iter->pos.x;
+		ripple.y = iter->pos.y;
+		ripple.density = iter->density;
+
+		size_t begin = pending.cachedVertices;
+		size_t chunk = std::min(count - begin, budget - work);
+		size_t offset = pending.cachedRipples * count + begin;
+		WaterKernel::buildRippleCache(pending.originX.data() + begin, pending.originY.data() + begin, chunk, ripple,
+			pending.fixedRipplePhase.data() + offset, pending.fixedRippleDirX.data() + offset, pending.fixedRippleDirY.data() + offset);
+		pending.cachedVertices += chunk;
+		work += chunk;
+		if (pending.cachedVertices == count)
+		{
+			pending.cachedRipples++;
+			pending.cachedVertices = 0;
+			++iter;
+		}
+	}
+	return pending.cachedRipples >= rippleCount;
+}
+
+/**
+ * @brief 提交后台生成的网格
+ * @details 把新网格换入并重置位移和透明度状态（与 initGrid 相同），之后 getVertexCount() 返回新的顶点数量，
+ * 调用方需要按新数量调整输出缓冲区；新网格尚未生成完时先同步完成剩余部分。使用自适应网格时不在后台生成，提交时按新尺寸重新生成最粗的自适应网格
+ */
+void WaterField::commitGridRebuild()
+{
+	finishUpdate();
+	PendingGrid& pending = _pendingGrid;
+	if (pending.gridSize == 0)
+	{
+		return;
+	}
+	if (_quadtreeParams.enabled && _clickRippleEngine == WaterClickRippleEngine::Analytic)
+	{
+		// 自适应网格按新尺寸重新生成，后台生成的均匀网格（如果有）不再需要
+		_gridSize = pending.gridSize;
+		_params.gridSize = pending.gridSize;
+		pending = PendingGrid();
+		_quadtreeActive = true;
+		_applyMeshLayout();
+		return;
+	}
+	_stepGridRebuild(SIZE_MAX);
+
+	_gridSize = pending.gridSize;
+	_params.gridSize = pending.gridSize;
+	_quadtreeActive = false;
+	_quadtreeMesh = WaterQuadtreeMesh();
+	_meshRevision++;
+	_columns = static_cast<size_t>(pending.gridSize) + 1;
+	_originX.swap(pending.originX);
+	_originY.swap(pending.originY);
+	_fixedRipplePhase.swap(pending.fixedRipplePhase);
+	_fixedRippleDirX.swap(pending.fixedRippleDirX);
+	_fixedRippleDirY.swap(pending.fixedRippleDirY);
+	_fixedRippleCacheCount = _fixedRippleCacheEnabled ? std::min(pending.cachedRipples, _params.fixedRipples.size()) : 0;
+	_fixedRipplePhase.resize(_fixedRippleCacheCount * _originX.size());
+	_fixedRippleDirX.resize(_fixedRippleCacheCount * _originX.size());
+	_fixedRippleDirY.resize(_fixedRippleCacheCount * _originX.size());
+
+	// 释放旧网格占用的内存
+	pending = PendingGrid();
+
+	_resetGridState();
+}
+
+/**
+ * @brief 生成一行顶点的原始坐标
+ * @param gridSize 网格尺寸
+ * @param row 行号（0 ~ gridSize）
+ * @param rowY 输入为该行的Y坐标，输出为下一行的Y坐标（逐行累加，与原实现一致）
+ * @param originX 输出：该行 gridSize+1 个顶点的X坐标
+ * @param originY 输出：该行 gridSize+1 个顶点的Y坐标
+ * @details 首末行列分别位于绘制区域的边缘
+ */
+void WaterField::_fillOriginRow(int gridSize, int row, float& rowY, float* originX, float* originY) const
+{
+	float cellW = _width / gridSize;
+	float cellH = _height / gridSize;
+	if (row == gridSize)
+	{
+		rowY = _height;
+	}
+	float columnX = 0.0f;
+	for (int x = 0; x <= gridSize; ++x) {
+		if (x == gridSize)
+		{
+			columnX = _width;
+		}
+		originX[x] = columnX;
+		originY[x] = rowY;
+		columnX += cellW;
+	}
+	rowY += cellH;
+}
+
+/**
+ * @brief 按当前顶点原始坐标重置网格状态
+ * @details 位移、位置、透明度、插值历史和分块范围回到初始状态，自适应计时和静止判断重新开始；
+ * 顶点数量不变时复用原有缓冲区，不分配内存
+ */
+void WaterField::_resetGridState()
+{
+	size_t count = _originX.size();
+	_offsetX.assign(count, 0.0f);
+	_offsetY.assign(count, 0.0f);
+	_positionX = _originX;
+	_positionY = _originY;
+	_alpha.assign(count, _params.light.defaultAlpha);
+	_reserveFrameBuffers();
+	_resetHeightField();
+	_phasorsValid = false;
+	_meshRefineValid = false;
+
+	_updateCost = 0.0f;
+	_adaptiveFrames = 0;
+
+	_simulationValid = false;
+	_staticSimulations = 0;
+	_idle = false;
+	if (_simulationRate > 0.0f)
+	{
+		_previousX = _positionX;
+		_previousY = _positionY;
+		_previousAlpha = _alpha;
+	}
+
+	// 分块的原始坐标范围，用于判断与点击波纹圆环是否相交，自适应网格不分块
+	size_t rows = _columns > 0 ? count / _columns : 0;
+	_tileColumns = (_columns + kTileSize - 1) / kTileSize;
+	_tileRows = (rows + kTileSize - 1) / kTileSize;
+	_tileMinX.resize(_tileColumns);
+	_tileMaxX.resize(_tileColumns);
+	_tileMinY.resize(_tileRows);
+	_tileMaxY.resize(_tileRows);
+	for (size_t column = 0; column < _tileColumns; column++)
+	{
+		_tileMinX[column] = _originX[column * kTileSize];
+		_tileMaxX[column] = _originX[std::min((column + 1) * kTileSize, _columns) - 1];
+	}
+	for (size_t row = 0; row < _tileRows; row++)
+	{
+		_tileMinY[row] = _originY[row * kTileSize * _columns];
+		_tileMaxY[row] = _originY[(std::min((row + 1) * kTileSize, rows) - 1) * _columns];
+	}
+	_tileModes.assign(_tileColumns * _tileRows, TileActive);
+	_tileActive.assign(_tileColumns * _tileRows, 1);
+	_updatedTiles = 0;
+	_skippedTiles = 0;
+	_lastOutput = WaterVertexSpan();
+}
+
+/**
+ * @brief 调整绘制区域尺寸
+ * @param width 新的绘制区域宽度
+ * @param height 新的绘制区域高度
+ * @details 保持网格尺寸不变，在原有缓冲区中重新计算顶点原始坐标、固定波纹几何缓存和分块范围，
+ * 并像 initGrid 一样重置位移和透明度状态，不分配内存；尺寸与当前相同时不做任何事。
+ * 进行中的后台网格重建按新尺寸重新开始，复用其缓冲区
+ */
+void WaterField::resize(float width, float height)
+{
+	finishUpdate();
+	if (width == _width && height == _height)
+	{
+		return;
+	}
+	_width = width;
+	_height = height;
+
+	int pendingGridSize = _pendingGrid.gridSize;
+	if (pendingGridSize != 0)
+	{
+		_pendingGrid.gridSize = 0;
+		requestGridSize(pendingGridSize);
+	}
+	if (_gridSize != 0)
+	{
+		_relayoutGrid();
+	}
+}
+
+/**
+ * @brief 按当前绘制区域尺寸重新计算现有网格
+ * @details 在原有缓冲区中重新生成顶点原始坐标和已缓存的固定波纹几何缓存，并重置网格状态
+ */
+void WaterField::_relayoutGrid()
+{
+	if (_quadtreeActive)
+	{
+		_quadtreeMesh.setArea(_width, _height);
+		_quadtreeMesh.fillOrigins(_originX.data(), _originY.data());
+	}
+	else
+	{
+		float rowY = 0.0f;
+		for (int row = 0; row <= _gridSize; row++)
+		{
+			size_t offset = row * _columns;
+			_fillOriginRow(_gridSize, row, rowY, _originX.data() + offset, _originY.data() + offset);
+		}
+	}
+	size_t count = _originX.size();
+	auto iter = _params.fixedRipples.begin();
+	for (size_t r = 0; r < _fixedRippleCacheCount; r++, ++iter)
+	{
+		WaterKernel::Ripple ripple;
+		ripple.x = iter->pos.x;
+		ripple.y = iter->pos.y;
+		ripple.density = iter->density;
+		WaterKernel::buildRippleCache(_originX.data(), _originY.data(), count, ripple,
+			_fixedRipplePhase.data() + r * count, _fixedRippleDirX.data() + r * count, _fixedRippleDirY.data() + r * count);
+	}
+	_resetGridState();
+}
+
+/**
+ * @brief 设置每次 stepGridRebuild 处理的顶点数量上限
+ * @param budget 顶点数量（默认32768）
+ */
+void WaterField::setGridRebuildBudget(size_t budget)
+{
+	finishUpdate();
+	_gridRebuildBudget = std::max<size_t>(budget, 1);
+}
+
+/**
+ * @brief 获取每次 stepGridRebuild 处理的顶点数量上限
+ * @return 顶点数量
+ */
+size_t WaterField::getGridRebuildBudget() const
+{
+	return _gridRebuildBudget;
+}
+
+/**
+ * @brief 设置按更新耗时自动调整网格尺寸
+ * @param targetMs 每帧 update 的目标耗时（毫秒），小于等于0时关闭自动调整
+ * @param minGridSize 最小网格尺寸
+ * @param maxGridSize 最大网格尺寸
+ * @details update 的耗时经指数平滑后与目标比较，超过目标的110%时缩小网格，低于70%时放大网格，
+ * 两者之间不做调整；新尺寸按耗时与顶点数成正比估算，使耗时回到目标的90%左右，每次变化不超过25%，小于5%时不切换。
+ * 网格切换后先观察一段时间再做下一次判断，新网格通过 requestGridSize 分帧生成
+ */
+void WaterField::setAdaptiveGridSize(float targetMs, int minGridSize, int maxGridSize)
+{
+	finishUpdate();
+	_adaptiveTargetMs = targetMs > 0.0f ? targetMs : 0.0f;
+	_adaptiveMinGridSize = std::max(minGridSize, 1);
+	_adaptiveMaxGridSize = std::max(maxGridSize, _adaptiveMinGridSize);
+	_adaptiveFrames = 0;
+}
+
+/**
+ * @brief 获取平滑后的 update 耗时
+ * @return 毫秒
+ */
+float WaterField::getUpdateCost() const
+{
+	finishUpdate();
+	return _updateCost;
+}
+
+/**
+ * @brief 根据本帧耗时决定是否调整网格尺寸
+ * @param costMs 本帧 update 耗时（毫秒）
+ */
+void WaterField::_adaptGridSize(float costMs)
+{
+	// 网格切换后丢弃前几帧（缓存冷启动），再观察一段时间的平滑耗时
+	const int kWarmupFrames = 5;
+	const int kSettleFrames = 30;
+
+	_adaptiveFrames++;
+	if (_adaptiveFrames <= kWarmupFrames)
+	{
+		return;
+	}
+	_updateCost = _updateCost > 0.0f ? _updateCost + (costMs - _updateCost) * 0.1f : costMs;
+	if (_adaptiveTargetMs <= 0.0f || _pendingGrid.gridSize != 0 || _adaptiveFrames < kWarmupFrames + kSettleFrames)
+	{
+		return;
+	}
+
+	int gridSize = _gridSize;
+	if (_updateCost <= _adaptiveTargetMs * 1.1f && _updateCost >= _adaptiveTargetMs * 0.7f && gridSize >= _adaptiveMinGridSize && gridSize <= _adaptiveMaxGridSize)
+	{
+		return;
+	}
+	float scale = std::sqrt(_adaptiveTargetMs * 0.9f / std::max(_updateCost, 1e-3f));
+	scale = std::min(std::max(scale, 0.75f), 1.25f);
+	int newGridSize = static_cast<int>(gridSize * scale + 0.5f);
+	newGridSize = std::min(std::max(newGridSize, _adaptiveMinGridSize), _adaptiveMaxGridSize);
+	// 变化太小时不切换，避免耗时抖动引起反复重建
+	bool outOfRange = gridSize < _adaptiveMinGridSize || gridSize > _adaptiveMaxGridSize;
+	if (outOfRange || std::abs(newGridSize - gridSize) >= std::max(2, gridSize / 20))
+	{
+		requestGridSize(newGridSize);
+	}
+	_adaptiveFrames = kWarmupFrames;
+}
+
+/**
+ * @brief 获取性能统计
+ * @return 最近 WaterTimingWindow::kCapacity 帧的各阶段耗时汇总以及当前的顶点数、点击波纹数和提交数据量
+ * @details 编译时 WATER_EFFECT_STATS 定义为0时不做任何计时，返回全零
+ */
+WaterStats WaterField::getStats() const
+{
+	finishUpdate();
+	WaterStats stats;
+#if WATER_EFFECT_STATS
+	WaterTiming* timings[] = { &stats.waves, &stats.fixedRipples, &stats.clickRipples, &stats.boundary, &stats.lighting, &stats.update, &stats.submit };
+	for (size_t i = 0; i < _statsWindows.size(); i++)
+	{
+		*timings[i] = _statsWindows[i].summarize();
+	}
+	stats.frameCount = _statsWindows[static_cast<size_t>(WaterStage::Update)].size();
+	stats.vertexCount = _originX.size();
+	stats.indexCount = _statsIndexCount;
+	stats.activeClickRipples = _params.clickRipples.size();
+	stats.droppedClickRipples = _params.clickRipples.getDroppedCount() + _params.clickRipples.getEvictedCount();
+	stats.uploadedBytes = _statsUploadedBytes;
+	stats.totalUploadedBytes = _statsTotalUploadedBytes;
+#endif
+	return stats;
+}
+
+/**
+ * @brief 清空性能统计窗口和累计的提交字节数
+ */
+void WaterField::resetStats()
+{
+	finishUpdate();
+#if WATER_EFFECT_STATS
+	for (auto& window : _statsWindows)
+	{
+		window.clear();
+	}
+	_statsTotalUploadedBytes = 0;
+#endif
+}
+
+/**
+ * @brief 记录一次几何体提交
+ * @param ms 提交耗时（毫秒）
+ * @param indexCount 索引数量
+ * @param bytes 提交的顶点和索引字节数
+ * @details 由渲染适配层在每次绘制后调用；WATER_EFFECT_STATS 为0时不做任何事
+ */
+void WaterField::_recordSubmission(float ms, size_t indexCount, size_t bytes)
+{
+#if WATER_EFFECT_STATS
+	_statsWindows[static_cast<size_t>(WaterStage::Submit)].push(ms);
+	_statsIndexCount = indexCount;
+	_statsUploadedBytes = bytes;
+	_statsTotalUploadedBytes += bytes;
+#else
+	(void)ms;
+	(void)indexCount;
+	(void)bytes;
+#endif
+}
+
+/**
+ * @brief 设置分块跳过的位移阈值
+ * @param epsilon 位移阈值（像素），0表示不跳过
+ * @details 网格按 kTileSize×kTileSize 个顶点分块，每次模拟只计算位移可能超过阈值的分块，
+ * 其余分块保持静止位置和稳定透明度，不做逐顶点计算。直线波纹和固定波纹的位移不随距离衰减，
+ * 两者振幅之和超过阈值时所有分块都需要计算；点击波纹只影响与其有效圆环相交的分块
+ */
+void WaterField::setTileEpsilon(float epsilon)
+{
+	finishUpdate();
+	_params.tileEpsilon = epsilon;
+}
+
+/**
+ * @brief 获取最近一次模拟中计算的分块数量
+ * @return 分块数量
+ */
+size_t WaterField::getUpdatedTileCount() const
+{
+	finishUpdate();
+	return _updatedTiles;
+}
+
+/**
+ * @brief 获取最近一次模拟中跳过的分块数量
+ * @return 分块数量
+ */
+size_t WaterField::getSkippedTileCount() const
+{
+	finishUpdate();
+	return _skippedTiles;
+}
@@ -0,0 +1,1104 @@
+﻿#pragma once
+#include <array>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+#include "WaterKernel.h"
+#include "WaterQuadtreeMesh.h"
+#include "WaterStats.h"
+#include "WaterThreadPool.h"
+
+
+/**
+ * @struct WaterPoint
+ * @brief 二维坐标
+ */
+struct WaterPoint
+{
+	float x = 0.0f;						///< X坐标
+	float y = 0.0f;						///< Y坐标
+};
+
+
+/**
+ * @struct WaterRippleParams
+ * @brief 基础波纹效果参数
+ * @details 定义单个波纹的物理属性和位置信息
+ */
+struct WaterRippleParams
+{
+	float amplitude = 0.0f;				///< 波纹振幅（影响波动强度）
+	float frequency = 0.0f;				///< 波纹频率（控制波动速度）
+	float density = 0.0f;				///< 波纹密度（影响传播衰减）
+	WaterPoint pos;						///< 波纹中心位置坐标
+};
+
+/**
+ * @struct WaterClickRippleParams
+ * @brief 点击触发的波纹参数
+ * @details 包含动态波纹的时间属性和基础物理参数
+ */
+struct WaterClickRippleParams
+{
+	WaterRippleParams rippleParams;		///< 基础波纹物理参数
+	float startTime = 0.0f;				///< 波纹起始时间（单位：秒）
+	float lifeTime = 0.0f;				///< 波纹生命周期（单位：秒）
+};
+
+/**
+ * @enum WaterClickRippleOverflow
+ * @brief 点击波纹数量达到上限时的处理策略
+ */
+enum class WaterClickRippleOverflow
+{
+	DropNewest,		///< 丢弃新的点击波纹
+	EvictOldest,	///< 替换最早添加的点击波纹
+	EvictWeakest,	///< 替换当前位移幅度（amplitude/(elapsed+1)）最小的点击波纹
+};
+
+/**
+ * @class WaterClickRipplePool
+ * @brief 固定容量的点击波纹环形缓冲池
+ * @details 容量在设置上限时一次性分配，添加点击波纹时不产生内存分配；
+ * 元素按添加的先后顺序存储，下标0为最早添加的波纹，过期波纹由 removeExpired 每帧统一清理
+ */
+class WaterClickRipplePool
+{
+public:
+
+	/**
+	 * @brief 创建缓冲池
+	 * @param capacity 容量
+	 */
+	explicit WaterClickRipplePool(int capacity = 5);
+
+	/**
+	 * @brief 重新设置容量
+	 * @param capacity 新容量（小于0按0处理）
+	 * @details 容量变小时保留最新添加的波纹
+	 */
+	void setCapacity(int capacity);
+
+	/**
+	 * @brief 获取容量
+	 * @return 容量
+	 */
+	size_t capacity() const;
+
+	/**
+	 * @brief 获取当前波纹数量
+	 * @return 数量
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief 按添加顺序访问波纹
+	 * @param index 下标（0为最早添加）
+	 * @return 波纹参数
+	 */
+	const WaterClickRippleParams& operator[](size_t index) const;
+
+	/**
+	 * @brief 添加点击波纹
+	 * @param params 波纹参数
+	 * @param policy 已满时的处理策略
+	 * @return 波纹被加入返回true，被丢弃返回false
+	 */
+	bool push(const WaterClickRippleParams& params, WaterClickRippleOverflow policy);
+
+	/**
+	 * @brief 移除已超过生命周期的波纹
+	 * @param time 当前时间（秒）
+	 */
+	void removeExpired(float time);
+
+	/**
+	 * @brief 清空所有波纹（保留容量）
+	 */
+	void clear();
+
+	/**
+	 * @brief 获取因缓冲池已满而被丢弃的新波纹数量
+	 * @return 累计数量
+	 */
+	unsigned long long getDroppedCount() const;
+
+	/**
+	 * @brief 获取因缓冲池已满而被替换的旧波纹数量
+	 * @return 累计数量
+	 */
+	unsigned long long getEvictedCount() const;
+
+private:
+	std::vector<WaterClickRippleParams> _slots;
+	size_t _head = 0;
+	size_t _count = 0;
+	unsigned long long _droppedCount = 0;
+	unsigned long long _evictedCount = 0;
+
+	WaterClickRippleParams& _at(size_t index);
+
+	/**
+	 * @brief 移除指定下标的波纹，后面的波纹依次前移以保持顺序
+	 * @param index 下标
+	 */
+	void _removeAt(size_t index);
+};
+
+/**
+ * @struct WaterWaveParams
+ * @brief 直线传播波纹参数
+ * @details 定义沿特定方向传播的波纹属性
+ */
+struct WaterWaveParams
+{
+	float amplitude = 0.0f;				///< 波动强度
+	float frequency = 0.0f;				///< 波动频率
+	float density = 0.0f;				///< 波纹密度系数（值越大波纹越密集）
+	float angle = 0.0f;					///< 传播方向角度（弧度制）
+	float phi = 0.0f;					///< 相位偏移量
+};
+
+/**
+ * @struct WaterWaveCalculatedParams
+ * @brief 预计算的波纹参数
+ * @details 存储直线波纹的法向量等预计算结果
+ */
+struct WaterWaveCalculatedParams
+{
+	float A = 0.0f;						///< 法向量的X分量（cos(angle)）
+	float B = 0.0f;						///< 法向量的Y分量（-sin(angle)）
+	WaterWaveParams basicParams;			///< 基础波纹参数
+};
+
+/**
+ * @enum WaterLightingMode
+ * @brief 透明度（光照）的计算方式
+ */
+enum class WaterLightingMode
+{
+	FrameDelta,		///< 由相邻两帧的顶点位置之差计算，每帧变化不超过0.1（效果随帧率变化）
+	Analytic,		///< 由位移对时间的解析导数计算，不依赖上一帧状态（效果与帧率无关）
+};
+
+/**
+ * @struct WaterLightParams
+ * @brief 光照效果参数
+ * @details 控制波纹的透明度变化和光照模拟效果
+ */
+struct WaterLightParams
+{
+	float minDistance = 0.0f;			///< 最小位移阈值（低于此值不计算透明度变化）
+	float defaultAlpha = 1.0f;			///< 默认透明度值
+	float minAlpha = 0.0f;				///< 最小透明度值
+	float decay = 10.0f;					///< 透明度衰减系数（值越大衰减越慢）
+	float angle = 0.0f;					///< 光照角度（弧度制）
+	WaterLightingMode mode = WaterLightingMode::FrameDelta;	///< 透明度计算方式
+	float referenceInterval = 1.0f / 60.0f;	///< 解析模式下把速度换算为位移的参考帧间隔（秒），与该帧率下 FrameDelta 的效果接近
+};
+
+/**
+ * @enum WaterClickRippleEngine
+ * @brief 点击波纹的模拟方式
+ */
+enum class WaterClickRippleEngine
+{
+	Analytic,		///< 每个点击波纹在每个顶点上按公式求值，开销与活跃波纹数量成正比（数量受 maxClickRipple 限制）
+	HeightField,	///< 点击和拖动向高度场注入冲击，由波动方程传播，每帧开销与交互数量无关
+};
+
+/**
+ * @struct WaterHeightFieldParams
+ * @brief 高度场模拟参数
+ */
+struct WaterHeightFieldParams
+{
+	float speed = 500.0f;				///< 波速（像素/秒），默认与预设点击波纹的 frequency/density 一致
+	float damping = 2.0f;				///< 速度衰减率（1/秒），振幅约按 e^(-damping·t/2) 衰减
+	float impulseRadius = 24.0f;		///< 点击冲击的半径（像素）
+};
+
+/**
+ * @struct WaterEffectParams
+ * @brief 水波纹效果全局参数容器
+ * @details 整合所有波纹效果的配置参数和渲染设置
+ */
+struct WaterEffectParams
+{
+	int gridSize = 30;								///< 网格分辨率（值越大波纹越精细，性能开销越大）
+	std::list<WaterWaveCalculatedParams> waves;		///< 直线波纹参数列表
+	std::list<WaterRippleParams> fixedRipples;		///< 固定位置波纹列表
+	int maxClickRipple = 5;							///< 最大同时存在的点击波纹数量
+	WaterClickRippleOverflow clickRippleOverflow = WaterClickRippleOverflow::DropNewest;	///< 点击波纹达到上限时的处理策略
+	WaterClickRipplePool clickRipples{ 5 };			///< 活跃的点击波纹（容量与 maxClickRipple 一致）
+	float clickRippleEpsilon = 0.01f;				///< 点击波纹裁剪阈值（像素，位移低于此值的区域不计算，0表示不裁剪）
+	float tileEpsilon = 0.01f;						///< 分块跳过阈值（像素，位移不可能超过此值的分块保持静止，0表示不跳过）
+	WaterClickRippleParams defaultClickRipple;		///< 默认点击波纹参数模板
+	WaterLightParams light;							///< 光照效果参数
+	WaterHeightFieldParams heightField;				///< 高度场模拟参数（WaterClickRippleEngine::HeightField）
+};
+
+/**
+ * @struct WaterQuadtreeMeshParams
+ * @brief 自适应网格参数
+ * @details 启用后网格不再是均匀的 (gridSize+1)×(gridSize+1) 个顶点，而是按波纹分布细分的四叉树网格，
+ * 最细处与 gridSize 的均匀网格相同，开阔水面最粗为 2^levels 个最细格子，见 WaterQuadtreeMesh
+ */
+struct WaterQuadtreeMeshParams
+{
+	bool enabled = false;				///< 是否启用（默认关闭）
+	int levels = 2;						///< 细分层数，限制在 [1, WaterQuadtreeMesh::kMaxLevels]
+	float tolerance = 0.5f;				///< 允许的线性插值误差（像素），越小细分越多
+	float refineInterval = 0.1f;		///< 重新细分的时间间隔（秒），点击波纹的波前按这段时间内扫过的范围细分
+};
+
+/**
+ * @struct WaterVertexSpan
+ * @brief 调用方提供的顶点输出缓冲区
+ * @details 三个指针分别指向第0个顶点的X坐标、Y坐标和透明度，相邻顶点间隔 stride 字节，
+ * 因此既可以指向连续的float数组，也可以指向交错存储的顶点结构体中的字段；为空的指针不输出。
+ * offsetX/offsetY 在写出时加到顶点坐标上，多个网格写入同一个合并缓冲区时用来放置到各自的位置
+ */
+struct WaterVertexSpan
+{
+	float* x = nullptr;					///< 顶点X坐标
+	float* y = nullptr;					///< 顶点Y坐标
+	float* alpha = nullptr;				///< 顶点透明度
+	size_t stride = sizeof(float);		///< 相邻顶点之间的字节数
+	size_t alphaStride = 0;				///< 相邻顶点透明度之间的字节数，0表示与 stride 相同（位置和颜色分开存储时使用）
+	float offsetX = 0.0f;				///< 写出时加到X坐标上的平移量
+	float offsetY = 0.0f;				///< 写出时加到Y坐标上的平移量
+};
+
+/**
+ * @class WaterField
+ * @brief 与渲染后端无关的水波纹模拟核心
+ * @details 管理波纹参数和网格，按时间计算每个顶点的位置和透明度并写入调用方提供的缓冲区；
+ * 不依赖SDL，可以用于其他渲染后端、离屏预览或无窗口的测试。
+ * 缓冲区在 initGrid 和添加波纹时分配，update 不分配内存。
+ * 位移默认按 Fast 精度计算（多项式近似，与原公式的位移差约 1.2e-4 像素，长时间运行后另有可分离求值表的相位舍入差异），需要逐位一致时见 setPrecision
+ */
+class WaterField
+{
+public:
+
+	/**
+	 * @brief 应用预设参数配置
+	 * @details 配置包含两组直线波纹+一组固定波纹的默认效果
+	 */
+	void applyPresetParams();
+
+
+	/**
+	 * @brief 初始化水波纹网格
+	 * @param gridSize 网格尺寸（必须大于0）
+	 * @param width 绘制区域宽度
+	 * @param height 绘制区域高度
+	 * @details 创建 (gridSize+1)×(gridSize+1) 个顶点，按行存储，首末行列分别位于绘制区域的边缘；
+	 * 所有内部缓冲区在此分配，之后的 update 不再分配内存。启用自适应网格时改为生成最粗的自适应网格，见 setQuadtreeMeshParams
+	 * @note 只有绘制区域尺寸变化时应调用 resize，它复用现有缓冲区
+	 */
+	void initGrid(int gridSize, float width, float height);
+
+	/**
+	 * @brief 更新一帧并写出顶点
+	 * @param time 当前时间（秒）
+	 * @param output 输出缓冲区，至少能容纳 getVertexCount() 个顶点
+	 * @details 计算所有波纹的叠加效果并把顶点位置和透明度写入 output：
+	 * 1. 移除过期的点击波纹（每帧一次）
+	 * 2. 由 WaterKernel 在SoA数组上计算直线波纹、固定波纹和点击波纹的偏移
+	 * 3. 应用边界约束
+	 * 4. 计算顶点透明度变化
+	 * 并行模式下 2~4 步及写出按行带分配给线程池执行。透明度依赖上一帧的位置（解析光照模式除外），由本对象保存，
+	 * 因此 output 可以每帧不同。
+	 * 设置了模拟频率时 2~4 步只在模拟时刻执行，其余帧只做插值；没有任何波纹且网格已静止时跳过全部计算，
+	 * 输出缓冲区与上次相同时也不再写出
+	 */
+	void update(float time, const WaterVertexSpan& output);
+
+	/**
+	 * @brief 在后台线程开始更新一帧
+	 * @param time 要计算的时刻（秒），通常为预测的下一帧显示时间
+	 * @param output 输出缓冲区，finishUpdate 之前调用方不能读写
+	 * @details 与 update 的计算相同，调用后立即返回，调用方可以同时提交上一帧的顶点。
+	 * 进行中的后台更新在 update、finishUpdate 以及任何修改参数、网格或读取模拟状态的调用开始时先完成，
+	 * 因此在更新进行中调整参数是安全的，改动从下一次更新开始生效
+	 */
+	void beginUpdate(float time, const WaterVertexSpan& output);
+
+	/**
+	 * @brief 等待后台更新完成
+	 * @details 没有进行中的后台更新时立即返回；之后 beginUpdate 的输出缓冲区可以读取
+	 */
+	void finishUpdate() const;
+
+	/**
+	 * @brief 判断是否有进行中的后台更新
+	 * @return 已调用 beginUpdate 且尚未完成时返回true
+	 */
+	bool isUpdatePending() const;
+
+	/**
+	 * @brief 设置模拟频率
+	 * @param hz 每秒模拟次数，小于等于0时每次 update 都完整计算（默认）
+	 * @details 启用后只在 1/hz 秒的整数倍时刻计算网格，两个模拟时刻之间对顶点位置和透明度做线性插值，
+	 * 每帧只需一次插值写出；适合刷新率远高于水波变化速度的场合。
+	 * 透明度按相邻两次模拟之间的位移计算，因此模拟频率会影响光照效果的强弱；WaterLightingMode::Analytic 模式下不受影响
+	 */
+	void setSimulationRate(float hz);
+
+	/**
+	 * @brief 获取模拟频率
+	 * @return 每秒模拟次数，0表示每次 update 都完整计算
+	 */
+	float getSimulationRate() const;
+
+	/**
+	 * @brief 判断当前是否处于静止状态
+	 * @return 没有任何波纹且顶点已回到静止位置和透明度时返回true，此时 update 不做计算
+	 */
+	bool isIdle() const;
+
+	/**
+	 * @brief 使上次写出的输出失效
+	 * @details 下一次 update 完整写出全部顶点；输出缓冲区的内容被调用方改写（例如重新填充颜色数组）后调用
+	 */
+	void invalidateOutput();
+
+	/**
+	 * @brief 获取网格尺寸
+	 * @return 每行的格子数，未初始化时返回0
+	 */
+	int getGridSize() const;
+
+	/**
+	 * @brief 获取顶点数量
+	 * @return 顶点数量
+	 */
+	size_t getVertexCount() const;
+
+	/**
+	 * @brief 获取顶点原始X坐标
+	 * @return 长度为 getVertexCount() 的数组
+	 */
+	const float* getOriginX() const;
+
+	/**
+	 * @brief 获取顶点原始Y坐标
+	 * @return 长度为 getVertexCount() 的数组
+	 */
+	const float* getOriginY() const;
+
+	/**
+	 * @brief 获取当前参数
+	 * @return 参数
+	 */
+	const WaterEffectParams& getParams() const;
+
+	/**
+	 * @brief 请求分帧切换到新的网格尺寸
+	 * @param gridSize 新的网格尺寸（必须大于0）
+	 * @details 新网格（顶点和固定波纹几何缓存）在后台缓冲区中由 stepGridRebuild 分帧生成，
+	 * 生成期间继续使用当前网格；与当前尺寸相同时取消进行中的重建。绘制区域尺寸不变，尺寸变化时调用 resize
+	 */
+	void requestGridSize(int gridSize);
+
+	/**
+	 * @brief 获取正在后台生成的网格尺寸
+	 * @return 网格尺寸，没有进行中的重建时返回0
+	 */
+	int getPendingGridSize() const;
+
+	/**
+	 * @brief 推进后台网格的生成
+	 * @return 新网格已全部生成、可以提交时返回true
+	 * @details 每次调用最多处理 getGridRebuildBudget() 个顶点（生成一个顶点或为一个顶点缓存一个固定波纹各算一个），
+	 * 应在 update 之前调用，返回true后调用 commitGridRebuild
+	 */
+	bool stepGridRebuild();
+
+	/**
+	 * @brief 提交后台生成的网格
+	 * @details 把新网格换入并重置位移和透明度状态（与 initGrid 相同），之后 getVertexCount() 返回新的顶点数量，
+	 * 调用方需要按新数量调整输出缓冲区；新网格尚未生成完时先同步完成剩余部分。使用自适应网格时不在后台生成，提交时按新尺寸重新生成最粗的自适应网格
+	 */
+	void commitGridRebuild();
+
+	/**
+	 * @brief 调整绘制区域尺寸
+	 * @param width 新的绘制区域宽度
+	 * @param height 新的绘制区域高度
+	 * @details 保持网格尺寸不变，在原有缓冲区中重新计算顶点原始坐标、固定波纹几何缓存和分块范围，
+	 * 并像 initGrid 一样重置位移和透明度状态，不分配内存；尺寸与当前相同时不做任何事。
+	 * 进行中的后台网格重建按新尺寸重新开始，复用其缓冲区
+	 */
+	void resize(float width, float height);
+
+	/**
+	 * @brief 设置每次 stepGridRebuild 处理的顶点数量上限
+	 * @param budget 顶点数量（默认32768）
+	 */
+	void setGridRebuildBudget(size_t budget);
+
+	/**
+	 * @brief 获取每次 stepGridRebuild 处理的顶点数量上限
+	 * @return 顶点数量
+	 */
+	size_t getGridRebuildBudget() const;
+
+	/**
+	 * @brief 设置按更新耗时自动调整网格尺寸
+	 * @param targetMs 每帧 update 的目标耗时（毫秒），小于等于0时关闭自动调整
+	 * @param minGridSize 最小网格尺寸
+	 * @param maxGridSize 最大网格尺寸
+	 * @details update 的耗时经指数平滑后与目标比较，超过目标的110%时缩小网格，低于70%时放大网格，
+	 * 两者之间不做调整；新尺寸按耗时与顶点数成正比估算，使耗时回到目标的90%左右，每次变化不超过25%，小于5%时不切换。
+	 * 网格切换后先观察一段时间再做下一次判断，新网格通过 requestGridSize 分帧生成
+	 */
+	void setAdaptiveGridSize(float targetMs, int minGridSize, int maxGridSize);
+
+	/**
+	 * @brief 获取平滑后的 update 耗时
+	 * @return 毫秒
+	 */
+	float getUpdateCost() const;
+
+	/**
+	 * @brief 重置所有水波纹参数为默认值
+	 * @details 清除所有自定义波纹配置（包括直线波纹、固定波纹和点击波纹），恢复为初始状态，网格尺寸保持不变
+	 */
+	void clearParams();
+
+	/**
+	 * @brief 添加直线传播的波纹效果
+	 * @param params 直线波纹参数配置
+	 * @details 根据角度参数计算法向量并存储预计算数据
+	 */
+	void addWave(WaterWaveParams params);
+
+	/**
+	 * @brief 添加固定位置的波纹源
+	 * @param params 固定波纹参数配置
+	 * @details 固定波纹会持续产生环形波纹效果
+	 */
+	void addFixedRipple(WaterRippleParams params);
+
+	/**
+	 * @brief 设置默认的点击波纹参数模板
+	 * @param params 点击波纹默认配置
+	 * @details 此配置将用于后续通过 addDefaultClickRipple 添加的波纹
+	 */
+	void setDefaultClickRippleParams(WaterClickRippleParams params);
+
+	/**
+	 * @brief 添加自定义点击波纹效果
+	 * @param params 点击波纹完整参数配置
+	 * @details 直接使用传入参数创建点击波纹，不受默认参数影响
+	 */
+	void addClickRipple(WaterClickRippleParams params);
+
+	/**
+	 * @brief 使用默认参数添加点击波纹
+	 * @param x 点击位置的X坐标
+	 * @param y 点击位置的Y坐标
+	 * @param startTime 波纹起始时间（秒）
+	 * @details 基于预设的默认参数在指定位置生成点击波纹
+	 */
+	void addDefaultClickRipple(float x, float y, float startTime);
+
+	/**
+	 * @brief 设置点击波纹的模拟方式
+	 * @param engine 模拟方式，默认为 Analytic
+	 * @details HeightField 模式下 addClickRipple 和 addDefaultClickRipple 改为向高度场注入冲击（立即生效，忽略起始时间和生命周期），
+	 * 高度场与网格顶点一一对应，按固定步长推进，直线波纹和固定波纹照常叠加。切换时清除现有的点击波纹和高度场
+	 */
+	void setClickRippleEngine(WaterClickRippleEngine engine);
+
+	/**
+	 * @brief 获取点击波纹的模拟方式
+	 * @return 模拟方式
+	 */
+	WaterClickRippleEngine getClickRippleEngine() const;
+
+	/**
+	 * @brief 设置高度场模拟参数
+	 * @param params 高度场参数
+	 */
+	void setHeightFieldParams(WaterHeightFieldParams params);
+
+	/**
+	 * @brief 向高度场注入冲击
+	 * @param x 中心X坐标
+	 * @param y 中心Y坐标
+	 * @param amplitude 冲击产生的最大位移（像素）
+	 * @param radius 冲击半径（像素）
+	 * @details 叠加一个高斯形状的凸起，随后向外扩散为波纹；适合拖动时逐帧调用。
+	 * 只在 HeightField 模式下生效，开销只与冲击覆盖的顶点数有关
+	 */
+	void addImpulse(float x, float y, float amplitude, float radius);
+
+	/**
+	 * @brief 设置颜色效果参数
+	 * @param params 颜色配置参数
+	 * @details 控制波纹的透明度变化效果（光照模拟）。WaterLightingMode::Analytic 模式下透明度由位移对时间的解析导数计算，
+	 * 不读取上一帧的位置和透明度，效果与帧率和模拟频率无关
+	 */
+	void setLightParams(WaterLightParams params);
+
+	/**
+	 * @brief 设置最大点击波纹数量
+	 * @param count 允许同时存在的最大点击波纹数
+	 * @details 按此数量预先分配点击波纹缓冲池，超过此数量时按 setClickRippleOverflow 设置的策略处理
+	 */
+	void setMaxClickRipple(int count);
+
+	/**
+	 * @brief 设置点击波纹数量达到上限时的处理策略
+	 * @param policy 丢弃新波纹、替换最早的波纹或替换最弱的波纹（默认丢弃新波纹）
+	 */
+	void setClickRippleOverflow(WaterClickRippleOverflow policy);
+
+	/**
+	 * @brief 设置点击波纹的裁剪阈值
+	 * @param epsilon 位移阈值（像素），0表示不裁剪
+	 * @details 每个点击波纹只在位移可能超过此阈值的圆环内计算，圆环由起始时间、频率和密度确定，
+	 * 被跳过的顶点上每个波纹的误差不超过此阈值，见 WaterKernel::clickRippleAnnulus
+	 */
+	void setClickRippleEpsilon(float epsilon);
+
+	/**
+	 * @brief 设置分块跳过的位移阈值
+	 * @param epsilon 位移阈值（像素），0表示不跳过
+	 * @details 网格按 kTileSize×kTileSize 个顶点分块，每次模拟只计算位移可能超过阈值的分块，
+	 * 其余分块保持静止位置和稳定透明度，不做逐顶点计算。直线波纹和固定波纹的位移不随距离衰减，
+	 * 两者振幅之和超过阈值时所有分块都需要计算；点击波纹只影响与其有效圆环相交的分块
+	 */
+	void setTileEpsilon(float epsilon);
+
+	/**
+	 * @brief 获取最近一次模拟中计算的分块数量
+	 * @return 分块数量
+	 */
+	size_t getUpdatedTileCount() const;
+
+	/**
+	 * @brief 获取最近一次模拟中跳过的分块数量
+	 * @return 分块数量
+	 */
+	size_t getSkippedTileCount() const;
+
+	/**
+	 * @brief 获取性能统计
+	 * @return 最近 WaterTimingWindow::kCapacity 帧的各阶段耗时汇总以及当前的顶点数、点击波纹数和提交数据量
+	 * @details 编译时 WATER_EFFECT_STATS 定义为0时不做任何计时，返回全零
+	 */
+	WaterStats getStats() const;
+
+	/**
+	 * @brief 清空性能统计窗口和累计的提交字节数
+	 */
+	void resetStats();
+
+	/// 分块的边长（顶点数）
+	static constexpr size_t kTileSize = 16;
+
+	/**
+	 * @brief 设置位移内核的指令集路径
+	 * @param isa 指令集路径（Scalar/SSE2/AVX2）
+	 * @details 默认使用运行时检测到的最优路径，CPU不支持的路径会回退为检测结果；
+	 * Precise 精度下始终使用 Scalar 路径，此设置在切换回 Fast 精度后生效
+	 */
+	void setKernelIsa(WaterKernel::Isa isa);
+
+	/**
+	 * @brief 获取当前使用的位移内核指令集路径
+	 * @return 指令集路径
+	 */
+	WaterKernel::Isa getKernelIsa() const;
+
+	/**
+	 * @brief 设置超越函数的精度档位
+	 * @param precision 精度档位，默认为 Fast
+	 * @details Precise：只使用标量路径（忽略 setKernelIsa），使用标准库 sin/cos/exp/atan2 并逐顶点计算直线波纹（不使用可分离求值表），与原算法的公式完全相同；
+	 * Fast：setKernelIsa 选择的路径，使用多项式近似和可分离求值表并去掉冗余的三角函数。
+	 * 默认的 Fast 档位与原算法的输出并非逐位相同：按预设参数实测位移差约 1.2e-4 像素（上限 WaterKernel::kTolerance 即 1e-3 像素），
+	 * 透明度差不超过 WaterKernel::kAlphaTolerance；可分离求值表与原公式float相位舍入之间的差异随时间增大，另见 WaterKernel::waveTableTolerance。
+	 * 需要与原算法逐位一致的输出时设置为 Precise
+	 */
+	void setPrecision(WaterKernel::Precision precision);
+
+	/**
+	 * @brief 获取超越函数的精度档位
+	 * @return 精度档位
+	 */
+	WaterKernel::Precision getPrecision() const;
+
+	/**
+	 * @brief 设置顶点更新使用的线程数
+	 * @param count 线程总数（含渲染线程），小于等于1时关闭并行模式
+	 * @details 并行模式下网格按行切分为若干行带，由常驻线程池并行计算，空闲线程会窃取其他线程的行带；
+	 * 每个顶点的计算互不依赖，结果与单线程完全一致
+	 */
+	void setThreadCount(int count);
+
+	/**
+	 * @brief 获取顶点更新使用的线程数
+	 * @return 线程总数，单线程模式返回1
+	 */
+	int getThreadCount() const;
+
+	/**
+	 * @brief 设置直线波纹是否使用可分离求值
+	 * @param enabled 是否启用（默认启用）
+	 * @details 启用后每帧为每个直线波纹构建行、列正弦余弦表，顶点上只做乘加运算，
+	 * 三角函数调用从 O(顶点数×波纹数) 降为 O((行数+列数)×波纹数)，详见 WaterKernel::buildWaveTables；
+	 * 只在 Fast 精度下生效，Precise 精度下逐顶点计算
+	 */
+	void setSeparableWaves(bool enabled);
+
+	/**
+	 * @brief 获取直线波纹是否使用可分离求值
+	 * @return 启用返回true
+	 */
+	bool getSeparableWaves() const;
+
+	/**
+	 * @brief 设置固定波纹是否使用径向几何缓存
+	 * @param enabled 是否启用（默认启用）
+	 * @details 启用后为每个固定波纹缓存各顶点的 density·distance 和单位方向，每帧每顶点只需一次余弦；
+	 * 缓存只在 initGrid 或 addFixedRipple 时构建，每个波纹占用 12 字节×顶点数
+	 */
+	void setFixedRippleCache(bool enabled);
+
+	/**
+	 * @brief 获取固定波纹是否使用径向几何缓存
+	 * @return 启用返回true
+	 */
+	bool getFixedRippleCache() const;
+
+	/**
+	 * @brief 获取固定波纹几何缓存占用的内存
+	 * @return 字节数
+	 */
+	size_t getFixedRippleCacheBytes() const;
+
+	/**
+	 * @brief 设置固定波纹是否使用增量相量
+	 * @param enabled 是否启用（默认关闭）
+	 * @details 固定波纹的相位 frequency·time - density·distance 中后一项对每个顶点固定，相邻两次计算之间相位只旋转 frequency·Δt。
+	 * 启用后为每个固定波纹保存各顶点的单位相量 (cos, sin)，每次计算只做一次复数乘法（旋转量以双精度按时间差求出），
+	 * 每16次把模修正回1以限制累积误差，不再计算三角函数；相位按时间差累加，不再受 frequency·time 的float乘积精度限制。
+	 * 只在 Fast 精度且启用径向几何缓存时生效，每个波纹另外占用 8 字节×顶点数；网格或固定波纹变化后的第一次计算以双精度重新求值。
+	 * 直线波纹的可分离求值表每帧以双精度只按行列求值，顶点上已经没有三角函数，因此不使用增量相量
+	 */
+	void setIncrementalPhasors(bool enabled);
+
+	/**
+	 * @brief 获取固定波纹是否使用增量相量
+	 * @return 启用返回true
+	 */
+	bool getIncrementalPhasors() const;
+
+	/**
+	 * @brief 设置自适应网格
+	 * @param params 自适应网格参数
+	 * @details 启用后顶点只在波纹变化剧烈的地方（点击波纹的波前、固定波纹中心附近，以及波长较短时的整个水面）
+	 * 细分到 gridSize 的密度，其余区域使用粗格子，顶点数和每帧的计算量随之减少；网格拓扑由 refineMesh 每帧按当前波纹调整。
+	 * 顶点不再按行排列，可分离求值、点击波纹裁剪和分块跳过不再生效，三角面索引由 getMeshIndices 给出。
+	 * 高度场模式需要规则网格，此时仍使用均匀网格。切换时像 initGrid 一样重置位移和透明度状态
+	 */
+	void setQuadtreeMeshParams(WaterQuadtreeMeshParams params);
+
+	/**
+	 * @brief 获取自适应网格参数
+	 * @return 参数
+	 */
+	WaterQuadtreeMeshParams getQuadtreeMeshParams() const;
+
+	/**
+	 * @brief 判断当前是否使用自适应网格
+	 * @return 已启用自适应网格、已初始化网格且点击波纹为 Analytic 模式时返回true
+	 */
+	bool isQuadtreeMeshActive() const;
+
+	/**
+	 * @brief 按当前波纹调整自适应网格
+	 * @param time 当前时间（秒）
+	 * @return 顶点或三角面发生变化时返回true，调用方需要按 getVertexCount() 调整输出缓冲区并重新读取 getMeshIndices()
+	 * @details 应在 update 之前调用，未使用自适应网格时直接返回false。每隔 refineInterval 秒
+	 * 或波纹发生变化（添加波纹、清除参数、调整尺寸）后重新估计一次，其余调用直接返回。拓扑变化时新顶点的位移和透明度
+	 * 由所在的旧格子插值得到，画面连续；只在拓扑变化时分配内存
+	 */
+	bool refineMesh(float time);
+
+	/**
+	 * @brief 获取自适应网格的三角面索引
+	 * @return 每三个顶点下标组成一个三角面；未使用自适应网格时为空，调用方按行生成均匀网格的索引
+	 */
+	const std::vector<unsigned int>& getMeshIndices() const;
+
+	/**
+	 * @brief 获取网格拓扑的版本号
+	 * @return 网格尺寸、网格类型或自适应网格的拓扑每次变化时加1；只改变绘制区域尺寸时不变
+	 */
+	unsigned long long getMeshRevision() const;
+
+protected:
+
+	/**
+	 * @brief 记录一次几何体提交
+	 * @param ms 提交耗时（毫秒）
+	 * @param indexCount 索引数量
+	 * @param bytes 提交的顶点和索引字节数
+	 * @details 由渲染适配层在每次绘制后调用；WATER_EFFECT_STATS 为0时不做任何事
+	 */
+	void _recordSubmission(float ms, size_t indexCount, size_t bytes);
+
+private:
+	WaterEffectParams _params;
+
+	WaterKernel::Isa _kernelIsa = WaterKernel::detectIsa();
+	WaterKernel::Precision _precision = WaterKernel::Precision::Fast;
+	WaterClickRippleEngine _clickRippleEngine = WaterClickRippleEngine::Analytic;
+
+	/**
+	 * @brief 获取实际使用的指令集路径
+	 * @return Precise 精度下为 Scalar，否则为 setKernelIsa 的设置
+	 */
+	WaterKernel::Isa _activeIsa() const;
+	int _gridSize = 0;										///< 当前网格尺寸
+	size_t _columns = 0;									///< 每行顶点数
+	float _width = 0.0f;									///< 绘制区域宽度
+	float _height = 0.0f;									///< 绘制区域高度
+
+	/**
+	 * @struct PendingGrid
+	 * @brief 分帧生成中的网格
+	 */
+	struct PendingGrid
+	{
+		int gridSize = 0;									///< 目标网格尺寸，0表示没有进行中的重建
+		int nextRow = 0;									///< 下一个要生成的顶点行
+		float rowY = 0.0f;									///< 下一行的Y坐标（逐行累加，与一次生成的结果一致）
+		size_t cachedRipples = 0;							///< 已完成几何缓存的固定波纹数量
+		size_t cachedVertices = 0;							///< 当前固定波纹已缓存的顶点数量
+		std::vector<float> originX;							///< 新网格的顶点原始X坐标
+		std::vector<float> originY;							///< 新网格的顶点原始Y坐标
+		std::vector<float> fixedRipplePhase;				///< 新网格的固定波纹几何缓存
+		std::vector<float> fixedRippleDirX;
+		std::vector<float> fixedRippleDirY;
+	};
+	PendingGrid _pendingGrid;
+	size_t _gridRebuildBudget = 32768;						///< 每次 stepGridRebuild 处理的顶点数量上限
+
+	float _adaptiveTargetMs = 0.0f;							///< 自动调整的目标耗时，0表示关闭
+	int _adaptiveMinGridSize = 0;
+	int _adaptiveMaxGridSize = 0;
+	float _updateCost = 0.0f;								///< 平滑后的 update 耗时（毫秒）
+	int _adaptiveFrames = 0;								///< 当前网格下已观察的帧数
+
+	/**
+	 * @brief 推进后台网格的生成
+	 * @param budget 本次最多处理的顶点数量
+	 * @return 新网格已全部生成时返回true
+	 */
+	bool _stepGridRebuild(size_t budget);
+
+	/**
+	 * @brief 生成一行顶点的原始坐标
+	 * @param gridSize 网格尺寸
+	 * @param row 行号（0 ~ gridSize）
+	 * @param rowY 输入为该行的Y坐标，输出为下一行的Y坐标（逐行累加，与原实现一致）
+	 * @param originX 输出：该行 gridSize+1 个顶点的X坐标
+	 * @param originY 输出：该行 gridSize+1 个顶点的Y坐标
+	 * @details 首末行列分别位于绘制区域的边缘
+	 */
+	void _fillOriginRow(int gridSize, int row, float& rowY, float* originX, float* originY) const;
+
+	/**
+	 * @brief 按当前顶点原始坐标重置网格状态
+	 * @details 位移、位置、透明度、插值历史和分块范围回到初始状态，自适应计时和静止判断重新开始；
+	 * 顶点数量不变时复用原有缓冲区，不分配内存
+	 */
+	void _resetGridState();
+
+	/**
+	 * @brief 按当前绘制区域尺寸重新计算现有网格
+	 * @details 在原有缓冲区中重新生成顶点原始坐标和已缓存的固定波纹几何缓存，并重置网格状态
+	 */
+	void _relayoutGrid();
+
+	/**
+	 * @brief 根据本帧耗时决定是否调整网格尺寸
+	 * @param costMs 本帧 update 耗时（毫秒）
+	 */
+	void _adaptGridSize(float costMs);
+	std::vector<float> _originX;							///< 顶点原始X坐标（SoA）
+	std::vector<float> _originY;							///< 顶点原始Y坐标（SoA）
+	std::vector<float> _offsetX;							///< 当前帧X方向位移（SoA）
+	std::vector<float> _offsetY;							///< 当前帧Y方向位移（SoA）
+	std::vector<float> _positionX;							///< 顶点X坐标，保留到下一帧用于计算透明度（SoA）
+	std::vector<float> _positionY;							///< 顶点Y坐标，保留到下一帧用于计算透明度（SoA）
+	std::vector<float> _alpha;								///< 顶点透明度，保留到下一帧用于平滑（SoA）
+	std::vector<WaterKernel::Wave> _kernelWaves;			///< 直线波纹的连续存储副本
+	std::vector<WaterKernel::Ripple> _kernelFixedRipples;	///< 固定波纹的连续存储副本
+	std::vector<WaterKernel::ClickRipple> _kernelClickRipples;	///< 点击波纹的连续存储副本
+
+	/**
+	 * @brief 按当前网格和波纹数量预留逐帧使用的缓冲区
+	 * @details 在参数或网格变化时调用，使 update 中的连续参数数组和可分离求值表不再扩容
+	 */
+	void _reserveFrameBuffers();
+
+	/**
+	 * @brief 整理当前帧的内核输入
+	 * @param time 当前时间（秒）
+	 * @return 指向SoA数组和连续参数数组的帧数据
+	 * @details 把链表中的波纹参数复制到连续数组中（容量复用，不产生逐帧分配），
+	 * 启用可分离求值时同时构建直线波纹的行、列表
+	 */
+	WaterKernel::Frame _prepareKernelFrame(float time);
+
+	/**
+	 * @brief 把链表中的波纹参数复制到连续数组中
+	 * @param time 当前时间（秒），用于计算点击波纹的经过时间
+	 * @param frame 输出：填入直线波纹、固定波纹和点击波纹的指针和数量
+	 */
+	void _collectKernelSources(float time, WaterKernel::Frame& frame);
+
+	bool _separableWaves = true;							///< 直线波纹是否使用可分离求值
+	std::vector<float> _waveColumnSin;						///< 可分离求值表：列正弦
+	std::vector<float> _waveColumnCos;						///< 可分离求值表：列余弦
+	std::vector<float> _waveRowSin;							///< 可分离求值表：行正弦
+	std::vector<float> _waveRowCos;							///< 可分离求值表：行余弦
+
+	bool _fixedRippleCacheEnabled = true;					///< 固定波纹是否使用径向几何缓存
+	size_t _fixedRippleCacheCount = 0;						///< 已缓存的固定波纹数量
+	std::vector<float> _fixedRipplePhase;					///< 固定波纹几何缓存：density·distance
+	std::vector<float> _fixedRippleDirX;					///< 固定波纹几何缓存：单位方向X分量
+	std::vector<float> _fixedRippleDirY;					///< 固定波纹几何缓存：单位方向Y分量
+
+	/**
+	 * @brief 为新添加的固定波纹追加几何缓存
+	 * @param params 固定波纹参数
+	 */
+	void _appendFixedRippleCache(const WaterRippleParams& params);
+
+	/**
+	 * @brief 按当前网格和全部固定波纹重建几何缓存
+	 * @details 进行中的后台网格重建已缓存的固定波纹可能已被替换，同样从头重新缓存
+	 */
+	void _rebuildFixedRippleCache();
+
+	WaterQuadtreeMeshParams _quadtreeParams;				///< 自适应网格参数
+	WaterQuadtreeMesh _quadtreeMesh;						///< 自适应网格的拓扑，使用均匀网格时为空
+	bool _quadtreeActive = false;							///< 当前网格是否为自适应网格（此时 _columns 为0）
+	unsigned long long _meshRevision = 0;					///< 网格拓扑的版本号
+	float _meshRefineTime = 0.0f;							///< 上次细分的时间（秒）
+	bool _meshRefineValid = false;							///< 上次细分之后波纹和网格没有变化
+
+	/**
+	 * @brief 按自适应网格参数和点击波纹模式切换网格类型
+	 * @details 需要自适应网格时按当前网格尺寸重新生成最粗的自适应网格，否则在自适应网格之后恢复均匀网格；
+	 * 两种情况都重建固定波纹几何缓存并重置网格状态，进行中的后台网格重建按新的网格类型重新开始
+	 */
+	void _applyMeshLayout();
+
+	/**
+	 * @brief 把网格状态换到细分之后的自适应网格
+	 * @details 保留下来的顶点沿用原有状态，新顶点的位移和透明度由所在的旧格子双线性插值，
+	 * 固定波纹几何缓存只为新顶点计算
+	 */
+	void _remapMeshState();
+
+	bool _incrementalPhasors = false;						///< 固定波纹是否使用增量相量
+	std::vector<float> _fixedRipplePhasorCos;				///< 增量相量余弦，布局同几何缓存
+	std::vector<float> _fixedRipplePhasorSin;				///< 增量相量正弦
+	std::vector<float> _fixedRippleRotation;				///< 每个固定波纹本次的旋转量 (cos, sin)
+	bool _phasorsValid = false;								///< 增量相量是否对应当前网格和固定波纹
+	double _phasorTime = 0.0;								///< 增量相量对应的时间（秒）
+	unsigned int _phasorSteps = 0;							///< 上次求值以来的旋转次数
+	static constexpr unsigned int kPhasorRenormalizeInterval = 16;	///< 每隔多少次旋转把相量的模修正回1
+
+	/**
+	 * @brief 准备本次计算的增量相量
+	 * @param frame 已填入几何缓存的内核输入，填入相量和旋转量
+	 * @param time 模拟时刻（秒）
+	 * @details 相量无效时按几何缓存以双精度重新求值（旋转量为0），否则按与上次的时间差求出每个波纹的旋转量
+	 */
+	void _prepareFixedRipplePhasors(WaterKernel::Frame& frame, float time);
+
+	std::unique_ptr<WaterThreadPool> _threadPool;			///< 并行模式的线程池（单线程模式为空）
+
+	/**
+	 * @brief 更新一段连续顶点
+	 * @param frame 当前帧的内核输入
+	 * @param output 输出缓冲区
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 由 _runKernel 计算位移、应用边界约束并计算透明度，再写入 output，只读写区间内的顶点；
+	 * 启用分块时交给 _updateTiles 处理
+	 */
+	void _updateRange(const WaterKernel::Frame& frame, const WaterVertexSpan& output, size_t begin, size_t end);
+
+	/**
+	 * @brief 对一段连续顶点执行内核更新
+	 * @param frame 当前帧的内核输入
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @param stageNanoseconds 启用统计时按 WaterStage 累加各阶段耗时（纳秒）
+	 * @details 不统计时直接调用 WaterKernel::update，统计时逐阶段调用并计时
+	 */
+	void _runKernel(const WaterKernel::Frame& frame, size_t begin, size_t end, long long* stageNanoseconds);
+
+	/**
+	 * @brief 按分块更新一段连续顶点
+	 * @param frame 当前帧的内核输入
+	 * @param output 输出缓冲区
+	 * @param begin 起始顶点下标（行首）
+	 * @param end 结束顶点下标（不含，行首）
+	 * @param stageNanoseconds 各阶段耗时（纳秒）
+	 * @details 只计算活跃分块，需要复位的分块写入静止状态，其余分块只在需要完整写出时写出
+	 */
+	void _updateTiles(const WaterKernel::Frame& frame, const WaterVertexSpan& output, size_t begin, size_t end, long long* stageNanoseconds);
+
+	/**
+	 * @brief update 的实现
+	 * @param time 当前时间（秒）
+	 * @param output 输出缓冲区
+	 */
+	void _update(float time, const WaterVertexSpan& output);
+
+#if WATER_EFFECT_STATS
+	/// 每个计时项最近若干帧的耗时
+	std::array<WaterTimingWindow, static_cast<size_t>(WaterStage::Count)> _statsWindows;
+	/// 本帧各更新阶段的耗时之和（纳秒），由各行带累加
+	std::array<std::atomic<long long>, static_cast<size_t>(WaterStage::Update)> _stageNanoseconds = {};
+	size_t _statsIndexCount = 0;							///< 最近一次提交的索引数
+	size_t _statsUploadedBytes = 0;							///< 最近一次提交的字节数
+	unsigned long long _statsTotalUploadedBytes = 0;		///< 累计提交的字节数
+#endif
+
+	/**
+	 * @brief 把当前状态写出到输出缓冲区
+	 * @param output 输出缓冲区（为空的指针跳过）
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 */
+	void _writeRange(const WaterVertexSpan& output, size_t begin, size_t end);
+
+	float _simulationRate = 0.0f;							///< 模拟频率（次/秒），0表示每帧计算
+	bool _simulationValid = false;							///< 前后两个模拟状态是否有效
+	long long _simulationTick = 0;							///< 前一个模拟状态对应的时刻序号
+	std::vector<float> _previousX;							///< 前一个模拟状态的顶点X坐标（插值起点）
+	std::vector<float> _previousY;							///< 前一个模拟状态的顶点Y坐标
+	std::vector<float> _previousAlpha;						///< 前一个模拟状态的顶点透明度
+	size_t _staticSimulations = 0;							///< 没有任何波纹时连续模拟的次数
+	bool _idle = false;										///< 网格已静止，update 跳过计算
+	WaterVertexSpan _lastOutput;							///< 上一次 update 写出的输出缓冲区
+	bool _writeAll = true;									///< 本次模拟需要写出全部顶点（输出缓冲区发生了变化）
+
+	/**
+	 * @enum TileMode
+	 * @brief 分块在本次模拟中的处理方式
+	 */
+	enum TileMode : unsigned char
+	{
+		TileRest,		///< 保持静止，不处理
+		TileReset,		///< 上次有变化，本次复位为静止状态
+		TileActive,		///< 正常计算
+	};
+	size_t _tileColumns = 0;								///< 每行分块数
+	size_t _tileRows = 0;									///< 分块行数
+	std::vector<float> _tileMinX;							///< 每列分块的原始X坐标范围
+	std::vector<float> _tileMaxX;
+	std::vector<float> _tileMinY;							///< 每行分块的原始Y坐标范围
+	std::vector<float> _tileMaxY;
+	std::vector<unsigned char> _tileModes;					///< 本次模拟中各分块的 TileMode
+	std::vector<unsigned char> _tileActive;					///< 各分块的内部状态是否偏离静止状态
+	bool _tilesEnabled = false;								///< 本次模拟是否按分块处理
+	size_t _updatedTiles = 0;								///< 最近一次模拟中计算的分块数量
+	size_t _skippedTiles = 0;								///< 最近一次模拟中跳过的分块数量
+
+	/**
+	 * @brief 标记本次模拟需要计算的分块
+	 * @param frame 当前帧的内核输入
+	 * @details 直线波纹和固定波纹的位移不随距离衰减，振幅之和超过阈值或启用了高度场时所有分块都需要计算（此时不启用分块）；
+	 * 否则每个点击波纹只标记与其有效圆环（位移可能超过阈值的区域）相交的分块。
+	 * 未标记的分块保持静止位置和稳定透明度：上次模拟时有变化的分块复位一次，之后不再处理
+	 */
+	void _markTiles(const WaterKernel::Frame& frame);
+
+	std::vector<float> _heightFieldCurrent;					///< 高度场当前高度（HeightField 模式，与顶点一一对应）
+	std::vector<float> _heightFieldPrevious;				///< 高度场上一步的高度
+	bool _heightFieldActive = false;						///< 高度场是否有非零高度
+	bool _heightFieldTimeValid = false;						///< _heightFieldTime 是否有效
+	float _heightFieldTime = 0.0f;							///< 高度场已推进到的时刻（秒）
+
+	/// 每次模拟最多推进的高度场步数，超出部分的时间被丢弃（波纹变慢而不是卡顿）
+	static constexpr int kMaxHeightFieldSteps = 16;
+
+	/**
+	 * @brief 获取高度场的步长
+	 * @return 秒，不超过1/60且满足波动方程的稳定条件
+	 */
+	float _heightFieldInterval() const;
+
+	/**
+	 * @brief 把高度场推进到指定时刻
+	 * @param time 模拟时刻（秒）
+	 * @details 每步按行带并行推进；全部高度都低于阈值时清零并停止推进，此后不再有任何开销
+	 */
+	void _advanceHeightField(float time);
+
+	/**
+	 * @brief 清空高度场
+	 * @details HeightField 模式下按顶点数量分配缓冲区，其他模式释放缓冲区
+	 */
+	void _resetHeightField();
+
+	/**
+	 * @brief 计算一个模拟时刻的网格状态
+	 * @param time 模拟时刻（秒）
+	 * @param output 输出缓冲区，指针为空时只更新内部状态
+	 * @details 更新内部的位置和透明度；计时结果用于自动调整网格尺寸
+	 */
+	void _simulate(float time, const WaterVertexSpan& output);
+
+	/**
+	 * @brief 按行带执行任务
+	 * @param task 任务，参数为顶点区间 [begin, end)
+	 * @details 单线程模式直接处理全部顶点；并行模式按行切分（自适应网格按 kBandVertices 个顶点切分），
+	 * 行带数量多于线程数以便负载不均时窃取
+	 */
+	template <typename Task>
+	void _forEachBand(const Task& task);
+
+	/// 自适应网格并行更新时切分行带的顶点数单位
+	static constexpr size_t kBandVertices = 64;
+
+	/**
+	 * @brief 在前后两个模拟状态之间插值并写出
+	 * @param output 输出缓冲区
+	 * @param weight 后一个状态的权重 [0, 1]
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 未启用模拟频率或权重为1时直接写出当前状态
+	 */
+	void _writeInterpolated(const WaterVertexSpan& output, float weight, size_t begin, size_t end);
+
+	/**
+	 * @brief 判断网格是否已回到静止状态
+	 * @return 位置等于原始位置、透明度等于稳定值（启用模拟频率时前后两个状态都满足）时返回true
+	 * @details 没有波纹时偏移为0，一次模拟后位置即回到原位；透明度每次最多变化0.1，需要若干次模拟才能收敛
+	 */
+	bool _isSettled() const;
+
+	float _pendingTime = 0.0f;								///< 后台更新的时刻
+	WaterVertexSpan _pendingOutput;							///< 后台更新的输出缓冲区
+	std::function<void()> _updateJob;						///< 后台更新任务，只创建一次
+	/// 后台更新线程，第一次 beginUpdate 时创建；最后声明，析构时最先等待进行中的更新完成
+	std::unique_ptr<WaterBackgroundWorker> _updateWorker;
+};
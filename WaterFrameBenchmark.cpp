@@ -0,0 +1,506 @@
+﻿/**
+ * @file WaterFrameBenchmark.cpp
+ * @brief 示例程序完整一帧的无窗口基准测试
+ * @details 使用 SDL 的 offscreen 视频驱动和软件渲染器（可用 --renderer 指定其他渲染器）创建隐藏窗口，
+ * 按示例程序 TestSDLWater.cpp 的方式渲染：1600×900 的逻辑尺寸、预设波纹参数，背景改用程序生成的棋盘格纹理，
+ * 不需要 water_effect.bmp。对每个网格尺寸、点击波纹数量和绘制方式先预热，再逐帧计时，帧时间按60帧/秒推进，
+ * 与实际运行速度无关，结果可复现。点击波纹按生命周期均匀地持续添加，整个测试期间保持指定数量。
+ * 结果以CSV（默认）或JSON输出到标准输出。
+ *
+ * 构建（Linux/macOS）：
+ *   g++ -O2 -std=c++17 -o WaterFrameBenchmark WaterFrameBenchmark.cpp WaterEffect.cpp WaterField.cpp WaterStats.cpp
+ *       WaterKernel.cpp WaterKernelPortable.cpp WaterKernelSSE2.cpp WaterKernelAVX2.cpp WaterThreadPool.cpp WaterQuadtreeMesh.cpp
+ *       $(pkg-config --cflags --libs sdl3)
+ *
+ * 用法：
+ *   WaterFrameBenchmark [--format csv|json] [--grids 50,100,200,400] [--ripples 0,4,16,64] [--paths canvas,texture]
+ *                       [--frames 120] [--threads 1] [--renderer software]
+ *
+ * 绘制方式：
+ * - canvas：setupEffectCanvas、把背景绘制到画布、renderEffect（示例程序按 C 键切换到的方式，画布比例为1）
+ * - texture：renderTexture 直接扭曲背景纹理（示例程序的默认方式）
+ *
+ * 计时阶段（毫秒/帧，平均值）：
+ * - clear：清空窗口
+ * - canvas：setupEffectCanvas（切换渲染目标并清空画布），texture 方式下为0
+ * - background：把背景绘制到画布，texture 方式下为0
+ * - effect：renderEffect / renderTexture（顶点更新、几何体提交和光栅化）；
+ *   其中 update 和 submit 取自 WaterField::getStats，编译时定义 WATER_EFFECT_STATS=0 时为0
+ * - present：SDL_RenderPresent（把逻辑尺寸的画面合成到窗口）
+ * SDL 会把渲染命令攒到下次切换目标或提交时才执行，为了把光栅化计入各自的阶段，每个阶段结束时调用 SDL_FlushRenderer，
+ * 因此各阶段之和比不刷新时略大
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <SDL3/SDL.h>
+#include "WaterEffect.h"
+
+namespace
+{
+	constexpr int kWindowWidth = 1600;
+	constexpr int kWindowHeight = 900;
+	constexpr int kBackgroundTile = 32;
+	constexpr int kWarmupFrames = 10;
+	constexpr float kStartTime = 1.0f;
+	constexpr float kFrameInterval = 1.0f / 60.0f;
+
+	/**
+	 * @enum Stage
+	 * @brief 一帧中分别计时的阶段
+	 */
+	enum Stage
+	{
+		StageClear,
+		StageCanvas,
+		StageBackground,
+		StageEffect,
+		StagePresent,
+		StageCount,
+	};
+
+	const char* const kStageNames[StageCount] = { "clear", "canvas", "background", "effect", "present" };
+
+	/**
+	 * @struct Options
+	 * @brief 命令行参数
+	 */
+	struct Options
+	{
+		bool json = false;
+		std::vector<int> grids = { 50, 100, 200, 400 };
+		std::vector<int> ripples = { 0, 4, 16, 64 };
+		std::vector<std::string> paths = { "canvas", "texture" };
+		int frames = 120;
+		int threads = 1;
+		const char* renderer = SDL_SOFTWARE_RENDERER;
+	};
+
+	/**
+	 * @struct Result
+	 * @brief 一个配置的计时结果
+	 */
+	struct Result
+	{
+		size_t vertices = 0;
+		double stageMs[StageCount] = {};	///< 各阶段的平均耗时
+		double updateMs = 0.0;				///< effect 阶段中顶点更新的平均耗时
+		double submitMs = 0.0;				///< effect 阶段中几何体提交的平均耗时
+		double meanMs = 0.0;
+		double medianMs = 0.0;
+		double p99Ms = 0.0;
+	};
+
+	/**
+	 * @brief 解析逗号分隔的整数列表
+	 * @param text 输入文本
+	 * @param values 输出
+	 * @return 格式正确返回true
+	 */
+	bool parseList(const char* text, std::vector<int>& values)
+	{
+		values.clear();
+		std::string item;
+		for (const char* p = text;; p++)
+		{
+			if (*p == ',' || *p == '\0')
+			{
+				char* end = nullptr;
+				long value = std::strtol(item.c_str(), &end, 10);
+				if (item.empty() || *end != '\0' || value < 0)
+				{
+					return false;
+				}
+				values.push_back(static_cast<int>(value));
+				item.clear();
+				if (*p == '\0')
+				{
+					break;
+				}
+			}
+			else
+			{
+				item += *p;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief 解析逗号分隔的绘制方式列表
+	 * @param text 输入文本
+	 * @param paths 输出
+	 * @return 格式正确返回true
+	 */
+	bool parsePathList(const char* text, std::vector<std::string>& paths)
+	{
+		paths.clear();
+		std::string list = std::string(text) + ",";
+		size_t start = 0;
+		for (size_t comma = list.find(','); comma != std::string::npos; start = comma + 1, comma = list.find(',', start))
+		{
+			std::string name = list.substr(start, comma - start);
+			if (name != "canvas" && name != "texture")
+			{
+				return false;
+			}
+			paths.push_back(name);
+		}
+		return true;
+	}
+
+	/**
+	 * @brief 解析命令行参数
+	 * @param argc 参数数量
+	 * @param argv 参数数组
+	 * @param options 输出
+	 * @return 参数正确返回true
+	 */
+	bool parseOptions(int argc, char* argv[], Options& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const char* arg = argv[i];
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+			if (value == nullptr)
+			{
+				return false;
+			}
+			i++;
+			std::vector<int> list;
+			if (std::strcmp(arg, "--format") == 0)
+			{
+				if (std::strcmp(value, "json") != 0 && std::strcmp(value, "csv") != 0)
+				{
+					return false;
+				}
+				options.json = std::strcmp(value, "json") == 0;
+			}
+			else if (std::strcmp(arg, "--grids") == 0)
+			{
+				if (!parseList(value, options.grids) || std::count(options.grids.begin(), options.grids.end(), 0) > 0)
+				{
+					return false;
+				}
+			}
+			else if (std::strcmp(arg, "--ripples") == 0)
+			{
+				if (!parseList(value, options.ripples))
+				{
+					return false;
+				}
+			}
+			else if (std::strcmp(arg, "--paths") == 0)
+			{
+				if (!parsePathList(value, options.paths))
+				{
+					return false;
+				}
+			}
+			else if (std::strcmp(arg, "--frames") == 0 || std::strcmp(arg, "--threads") == 0)
+			{
+				if (!parseList(value, list) || list.size() != 1 || list[0] <= 0)
+				{
+					return false;
+				}
+				if (std::strcmp(arg, "--frames") == 0)
+				{
+					options.frames = list[0];
+				}
+				else
+				{
+					options.threads = list[0];
+				}
+			}
+			else if (std::strcmp(arg, "--renderer") == 0)
+			{
+				options.renderer = value;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief 生成背景纹理
+	 * @param renderer 渲染器
+	 * @return 窗口尺寸的纹理，失败时返回nullptr
+	 * @details 按行列渐变着色的棋盘格，代替示例程序的 water_effect.bmp；边缘和颜色变化让扭曲后的采样与实际图片相近
+	 */
+	SDL_Texture* createBackground(SDL_Renderer* renderer)
+	{
+		SDL_Surface* surface = SDL_CreateSurface(kWindowWidth, kWindowHeight, SDL_PIXELFORMAT_ARGB8888);
+		if (surface == nullptr)
+		{
+			return nullptr;
+		}
+		for (int y = 0; y < kWindowHeight; y += kBackgroundTile)
+		{
+			for (int x = 0; x < kWindowWidth; x += kBackgroundTile)
+			{
+				bool dark = (x / kBackgroundTile + y / kBackgroundTile) % 2 != 0;
+				Uint8 red = static_cast<Uint8>(x * 255 / kWindowWidth);
+				Uint8 green = static_cast<Uint8>(y * 255 / kWindowHeight);
+				Uint8 blue = dark ? 96 : 224;
+				SDL_Rect rect = { x, y, kBackgroundTile, kBackgroundTile };
+				SDL_FillSurfaceRect(surface, &rect, SDL_MapSurfaceRGB(surface, red, green, blue));
+			}
+		}
+		SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+		SDL_DestroySurface(surface);
+		return texture;
+	}
+
+	/**
+	 * @class RippleLoad
+	 * @brief 保持固定数量的点击波纹
+	 * @details 按 生命周期/数量 的间隔添加波纹，开始时补齐此前应当存在的波纹，之后任意时刻都有指定数量的波纹处于各自生命周期的不同阶段。
+	 * 波纹中心由固定种子的线性同余序列生成，结果可复现
+	 */
+	class RippleLoad
+	{
+	public:
+		RippleLoad(WaterEffect& effect, int count)
+			: _effect(effect), _count(count)
+		{
+			if (count <= 0)
+			{
+				return;
+			}
+			const WaterEffectParams& params = effect.getParams();
+			_interval = params.defaultClickRipple.lifeTime / count;
+			effect.setMaxClickRipple(std::max(params.maxClickRipple, count + 1));
+			_nextTime = kStartTime - _interval * (count - 1);
+		}
+
+		/**
+		 * @brief 添加开始时间不晚于 time 的波纹
+		 * @param time 当前时间（秒）
+		 */
+		void advance(float time)
+		{
+			if (_count <= 0)
+			{
+				return;
+			}
+			for (; _nextTime <= time; _nextTime += _interval)
+			{
+				float x = _random() * kWindowWidth;
+				float y = _random() * kWindowHeight;
+				_effect.addDefaultClickRipple(x, y, _nextTime);
+			}
+		}
+
+	private:
+		WaterEffect& _effect;
+		int _count = 0;
+		float _interval = 0.0f;
+		float _nextTime = 0.0f;
+		unsigned int _seed = 12345u;
+
+		/**
+		 * @brief 生成 [0, 1) 内的伪随机数
+		 * @return 伪随机数
+		 */
+		float _random()
+		{
+			_seed = _seed * 1664525u + 1013904223u;
+			return static_cast<float>(_seed >> 8) / 16777216.0f;
+		}
+	};
+
+	/**
+	 * @brief 计时一个配置
+	 * @param options 命令行参数
+	 * @param window 隐藏窗口
+	 * @param renderer 渲染器
+	 * @param background 背景纹理
+	 * @param grid 网格尺寸
+	 * @param ripples 点击波纹数量
+	 * @param canvas 是否经过画布绘制
+	 * @param result 输出
+	 * @details 每次都创建新的 WaterEffect
+	 */
+	void measure(const Options& options, SDL_Window* window, SDL_Renderer* renderer, SDL_Texture* background, int grid, int ripples, bool canvas, Result& result)
+	{
+		WaterEffect effect(window, renderer);
+		effect.applyPresetParams();
+		effect.setThreadCount(options.threads);
+		effect.initGrid(grid, kWindowWidth, kWindowHeight);
+		RippleLoad load(effect, ripples);
+		result.vertices = effect.getVertexCount();
+
+		std::vector<double> frameMs;
+		for (int f = -kWarmupFrames; f < options.frames; f++)
+		{
+			float time = kStartTime + f * kFrameInterval;
+			load.advance(time);
+			double stageMs[StageCount] = {};
+			auto last = std::chrono::steady_clock::now();
+			auto lap = [&stageMs, &last](Stage stage)
+				{
+					auto now = std::chrono::steady_clock::now();
+					stageMs[stage] = std::chrono::duration<double, std::milli>(now - last).count();
+					last = now;
+				};
+
+			SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+			SDL_RenderClear(renderer);
+			SDL_FlushRenderer(renderer);
+			lap(StageClear);
+			if (canvas)
+			{
+				effect.setupEffectCanvas();
+				SDL_FlushRenderer(renderer);
+				lap(StageCanvas);
+				SDL_RenderTexture(renderer, background, nullptr, nullptr);
+				SDL_FlushRenderer(renderer);
+				lap(StageBackground);
+				effect.renderEffect(time);
+			}
+			else
+			{
+				effect.renderTexture(background, time);
+			}
+			SDL_FlushRenderer(renderer);
+			lap(StageEffect);
+			SDL_RenderPresent(renderer);
+			lap(StagePresent);
+
+			if (f < 0)
+			{
+				continue;
+			}
+			double total = 0.0;
+			for (int stage = 0; stage < StageCount; stage++)
+			{
+				result.stageMs[stage] += stageMs[stage];
+				total += stageMs[stage];
+			}
+			frameMs.push_back(total);
+		}
+
+		// 统计窗口只保存最近 WaterTimingWindow::kCapacity 帧，计时帧数更多时只反映最后这些帧
+		WaterStats stats = effect.getStats();
+		result.updateMs = stats.update.avgMs;
+		result.submitMs = stats.submit.avgMs;
+		double sum = 0.0;
+		for (double ms : frameMs)
+		{
+			sum += ms;
+		}
+		for (double& ms : result.stageMs)
+		{
+			ms /= frameMs.size();
+		}
+		result.meanMs = sum / frameMs.size();
+		std::sort(frameMs.begin(), frameMs.end());
+		result.medianMs = frameMs[frameMs.size() / 2];
+		result.p99Ms = frameMs[(frameMs.size() * 99 + 99) / 100 - 1];
+	}
+
+	/**
+	 * @brief 输出用法说明
+	 */
+	void printUsage()
+	{
+		std::fprintf(stderr,
+			"usage: WaterFrameBenchmark [--format csv|json] [--grids 50,100,200,400] [--ripples 0,4,16,64] [--paths canvas,texture]\n"
+			"                           [--frames 120] [--threads 1] [--renderer software]\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+	if (!SDL_Init(SDL_INIT_VIDEO))
+	{
+		std::fprintf(stderr, "SDL initialization failed: %s\n", SDL_GetError());
+		return 1;
+	}
+	SDL_Window* window = SDL_CreateWindow("WaterFrameBenchmark", kWindowWidth, kWindowHeight, SDL_WINDOW_HIDDEN);
+	SDL_Renderer* renderer = window != nullptr ? SDL_CreateRenderer(window, options.renderer) : nullptr;
+	if (renderer == nullptr)
+	{
+		std::fprintf(stderr, "renderer creation failed: %s\n", SDL_GetError());
+		SDL_Quit();
+		return 1;
+	}
+	// 与示例程序相同，按逻辑尺寸拉伸到窗口，present 阶段包含这次合成
+	SDL_SetRenderLogicalPresentation(renderer, kWindowWidth, kWindowHeight, SDL_LOGICAL_PRESENTATION_STRETCH);
+	SDL_Texture* background = createBackground(renderer);
+	if (background == nullptr)
+	{
+		std::fprintf(stderr, "background creation failed: %s\n", SDL_GetError());
+		SDL_DestroyRenderer(renderer);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	if (options.json)
+	{
+		std::printf("{\n  \"renderer\": \"%s\",\n  \"frames\": %d,\n  \"threads\": %d,\n  \"results\": [", SDL_GetRendererName(renderer), options.frames, options.threads);
+	}
+	else
+	{
+		std::printf("path,grid,vertices,ripples,fps,frame_mean_ms,frame_median_ms,frame_p99_ms,clear_ms,canvas_ms,background_ms,effect_ms,update_ms,submit_ms,present_ms\n");
+	}
+
+	bool first = true;
+	for (int grid : options.grids)
+	{
+		for (int ripples : options.ripples)
+		{
+			for (const std::string& path : options.paths)
+			{
+				Result result;
+				measure(options, window, renderer, background, grid, ripples, path == "canvas", result);
+				double fps = result.meanMs > 0.0 ? 1000.0 / result.meanMs : 0.0;
+				if (options.json)
+				{
+					std::printf("%s\n    { \"path\": \"%s\", \"grid\": %d, \"vertices\": %zu, \"ripples\": %d, \"fps\": %.1f, \"frame_mean_ms\": %.3f, \"frame_median_ms\": %.3f, \"frame_p99_ms\": %.3f",
+						first ? "" : ",", path.c_str(), grid, result.vertices, ripples, fps, result.meanMs, result.medianMs, result.p99Ms);
+					for (int stage = 0; stage < StageCount; stage++)
+					{
+						std::printf(", \"%s_ms\": %.3f", kStageNames[stage], result.stageMs[stage]);
+					}
+					std::printf(", \"update_ms\": %.3f, \"submit_ms\": %.3f }", result.updateMs, result.submitMs);
+				}
+				else
+				{
+					std::printf("%s,%d,%zu,%d,%.1f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+						path.c_str(), grid, result.vertices, ripples, fps, result.meanMs, result.medianMs, result.p99Ms,
+						result.stageMs[StageClear], result.stageMs[StageCanvas], result.stageMs[StageBackground], result.stageMs[StageEffect],
+						result.updateMs, result.submitMs, result.stageMs[StagePresent]);
+				}
+				first = false;
+				std::fflush(stdout);
+			}
+		}
+	}
+	if (options.json)
+	{
+		std::printf("\n  ]\n}\n");
+	}
+
+	SDL_DestroyTexture(background);
+	SDL_DestroyRenderer(renderer);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	return 0;
+}
@@ -0,0 +1,1258 @@
+﻿#include <cmath>
+#include <algorithm>
+#include "WaterKernel.h"
+
+#if defined(WATER_KERNEL_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace WaterKernel
+{
+#if defined(WATER_KERNEL_X86)
+	namespace Sse2
+	{
+		void accumulateWaves(const Frame& frame, size_t begin, size_t end);
+		void accumulateSeparableWaves(const Frame& frame, size_t begin, size_t end);
+		void accumulateFixedRipples(const Frame& frame, size_t begin, size_t end);
+		void accumulateCachedFixedRipples(const Frame& frame, size_t begin, size_t end);
+		void accumulatePhasorFixedRipples(const Frame& frame, size_t begin, size_t end);
+		void accumulateClickRipples(const Frame& frame, size_t begin, size_t end);
+		void accumulateClickRippleSpan(const Frame& frame, const ClickRipple& ripple, size_t begin, size_t end);
+	}
+
+	namespace Avx2
+	{
+		void accumulateWaves(const Frame& frame, size_t begin, size_t end);
+		void accumulateSeparableWaves(const Frame& frame, size_t begin, size_t end);
+		void accumulateFixedRipples(const Frame& frame, size_t begin, size_t end);
+		void accumulateCachedFixedRipples(const Frame& frame, size_t begin, size_t end);
+		void accumulatePhasorFixedRipples(const Frame& frame, size_t begin, size_t end);
+		void accumulateClickRipples(const Frame& frame, size_t begin, size_t end);
+		void accumulateClickRippleSpan(const Frame& frame, const ClickRipple& ripple, size_t begin, size_t end);
+	}
+#endif
+
+	namespace Portable
+	{
+		void accumulateWaves(const Frame& frame, size_t begin, size_t end);
+		void accumulateFixedRipples(const Frame& frame, size_t begin, size_t end);
+		void accumulateCachedFixedRipples(const Frame& frame, size_t begin, size_t end);
+		void accumulatePhasorFixedRipples(const Frame& frame, size_t begin, size_t end);
+		void accumulateClickRipples(const Frame& frame, size_t begin, size_t end);
+		void accumulateClickRippleSpan(const Frame& frame, const ClickRipple& ripple, size_t begin, size_t end);
+	}
+
+	namespace Scalar
+	{
+		/**
+		 * @brief 标量参考实现：直线波纹
+		 * @details 公式与原逐顶点循环完全相同
+		 */
+		template <bool Velocity>
+		static void accumulateWavesLoop(const Frame& frame, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				float offset_x = frame.offsetX[i], offset_y = frame.offsetY[i];
+				float x = frame.originX[i];
+				float y = frame.originY[i];
+				for (size_t w = 0; w < frame.waveCount; w++)
+				{
+					const Wave& iter = frame.waves[w];
+					float distance_to_line = (iter.A * x + iter.B * y + iter.phi);
+
+					float phase = iter.frequency * frame.time - iter.density * distance_to_line;
+					float line_offset = iter.amplitude * std::sin(phase);
+					offset_x += line_offset * iter.A;
+					offset_y += line_offset * iter.B;
+					if (Velocity)
+					{
+						float line_velocity = iter.amplitude * iter.frequency * frame.velocityInterval * std::cos(phase);
+						frame.velocityX[i] += line_velocity * iter.A;
+						frame.velocityY[i] += line_velocity * iter.B;
+					}
+				}
+				frame.offsetX[i] = offset_x;
+				frame.offsetY[i] = offset_y;
+			}
+		}
+
+		void accumulateWaves(const Frame& frame, size_t begin, size_t end)
+		{
+			if (frame.velocityX != nullptr)
+			{
+				accumulateWavesLoop<true>(frame, begin, end);
+			}
+			else
+			{
+				accumulateWavesLoop<false>(frame, begin, end);
+			}
+		}
+
+		/**
+		 * @brief 标量实现：可分离求值的直线波纹
+		 * @details 只有乘加运算，与SIMD路径结果逐位一致
+		 */
+		template <bool Velocity>
+		static void accumulateSeparableWavesLoop(const Frame& frame, size_t begin, size_t end)
+		{
+			size_t row = begin / frame.columns;
+			size_t column = begin % frame.columns;
+			for (size_t i = begin; i < end; i++)
+			{
+				float offset_x = frame.offsetX[i], offset_y = frame.offsetY[i];
+				for (size_t w = 0; w < frame.waveCount; w++)
+				{
+					const float* columnSin = frame.waveColumnSin + w * frame.columns;
+					const float* columnCos = frame.waveColumnCos + w * frame.columns;
+					float line_offset = columnSin[column] * frame.waveRowCos[w * frame.rows + row] + columnCos[column] * frame.waveRowSin[w * frame.rows + row];
+					offset_x += line_offset * frame.waves[w].A;
+					offset_y += line_offset * frame.waves[w].B;
+					if (Velocity)
+					{
+						// amplitude·cos(a+b) = amplitude·(cos a·cos b - sin a·sin b)
+						float line_velocity = (columnCos[column] * frame.waveRowCos[w * frame.rows + row] - columnSin[column] * frame.waveRowSin[w * frame.rows + row]) * (frame.waves[w].frequency * frame.velocityInterval);
+						frame.velocityX[i] += line_velocity * frame.waves[w].A;
+						frame.velocityY[i] += line_velocity * frame.waves[w].B;
+					}
+				}
+				frame.offsetX[i] = offset_x;
+				frame.offsetY[i] = offset_y;
+				if (++column == frame.columns)
+				{
+					column = 0;
+					++row;
+				}
+			}
+		}
+
+		void accumulateSeparableWaves(const Frame& frame, size_t begin, size_t end)
+		{
+			if (frame.velocityX != nullptr)
+			{
+				accumulateSeparableWavesLoop<true>(frame, begin, end);
+			}
+			else
+			{
+				accumulateSeparableWavesLoop<false>(frame, begin, end);
+			}
+		}
+
+		/**
+		 * @brief 标量参考实现：固定波纹
+		 */
+		template <bool Velocity>
+		static void accumulateFixedRipplesLoop(const Frame& frame, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				float offset_x = frame.offsetX[i], offset_y = frame.offsetY[i];
+				for (size_t r = 0; r < frame.fixedRippleCount; r++)
+				{
+					const Ripple& iter = frame.fixedRipples[r];
+					float dx = frame.originX[i] - iter.x;
+					float dy = frame.originY[i] - iter.y;
+					float angle = std::atan2(-dy, dx);
+					float distance = std::sqrt(dx * dx + dy * dy);
+					offset_x += iter.amplitude * std::cos(iter.frequency * frame.time - iter.density * distance) * std::cos(angle);
+					offset_y += iter.amplitude * std::cos(iter.frequency * frame.time - iter.density * distance) * -std::sin(angle);
+					if (Velocity)
+					{
+						float velocity = -iter.amplitude * iter.frequency * frame.velocityInterval * std::sin(iter.frequency * frame.time - iter.density * distance);
+						frame.velocityX[i] += velocity * std::cos(angle);
+						frame.velocityY[i] += velocity * -std::sin(angle);
+					}
+				}
+				frame.offsetX[i] = offset_x;
+				frame.offsetY[i] = offset_y;
+			}
+		}
+
+		void accumulateFixedRipples(const Frame& frame, size_t begin, size_t end)
+		{
+			if (frame.velocityX != nullptr)
+			{
+				accumulateFixedRipplesLoop<true>(frame, begin, end);
+			}
+			else
+			{
+				accumulateFixedRipplesLoop<false>(frame, begin, end);
+			}
+		}
+
+		/**
+		 * @brief 标量实现：使用几何缓存的固定波纹
+		 */
+		template <bool Velocity>
+		static void accumulateCachedFixedRipplesLoop(const Frame& frame, size_t begin, size_t end)
+		{
+			for (size_t r = 0; r < frame.fixedRippleCount; r++)
+			{
+				const Ripple& iter = frame.fixedRipples[r];
+				const float* phase = frame.fixedRipplePhase + r * frame.vertexCount;
+				const float* dirX = frame.fixedRippleDirX + r * frame.vertexCount;
+				const float* dirY = frame.fixedRippleDirY + r * frame.vertexCount;
+				float base = iter.frequency * frame.time;
+				for (size_t i = begin; i < end; i++)
+				{
+					float value = iter.amplitude * std::cos(base - phase[i]);
+					frame.offsetX[i] += value * dirX[i];
+					frame.offsetY[i] += value * dirY[i];
+				}
+				if (Velocity)
+				{
+					float scale = -iter.amplitude * iter.frequency * frame.velocityInterval;
+					for (size_t i = begin; i < end; i++)
+					{
+						float velocity = scale * std::sin(base - phase[i]);
+						frame.velocityX[i] += velocity * dirX[i];
+						frame.velocityY[i] += velocity * dirY[i];
+					}
+				}
+			}
+		}
+
+		void accumulateCachedFixedRipples(const Frame& frame, size_t begin, size_t end)
+		{
+			if (frame.velocityX != nullptr)
+			{
+				accumulateCachedFixedRipplesLoop<true>(frame, begin, end);
+			}
+			else
+			{
+				accumulateCachedFixedRipplesLoop<false>(frame, begin, end);
+			}
+		}
+
+		/**
+		 * @brief 标量参考实现：单个点击波纹对单个顶点的位移
+		 */
+		static void addClickRipple(const ClickRipple& iter, float x, float y, float& offset_x, float& offset_y)
+		{
+			float dx = x - iter.x;
+			float dy = y - iter.y;
+			float angle = std::atan2(dy, dx);
+			float distance = std::sqrt(dx * dx + dy * dy);
+			float distance_to_ripple = std::abs(iter.elapsed * iter.frequency - distance * iter.density);
+
+			offset_x += iter.amplitude * std::cos(distance_to_ripple) * std::cos(angle) * std::exp(-distance_to_ripple) / (iter.elapsed + 1.0f);
+			offset_y += iter.amplitude * std::cos(distance_to_ripple) * std::sin(angle) * std::exp(-distance_to_ripple) / (iter.elapsed + 1.0f);
+		}
+
+		/**
+		 * @brief 标量参考实现：单个点击波纹对单个顶点的位移对时间的导数
+		 * @details 记 w = elapsed·frequency - distance·density，r = |w|，位移为 amplitude·cos r·exp(-r)/(elapsed+1)，
+		 * 对 elapsed 求导得 amplitude·exp(-r)/(elapsed+1)·(-sign(w)·frequency·(sin r + cos r) - cos r/(elapsed+1))
+		 */
+		static void addClickRippleVelocity(const ClickRipple& iter, float x, float y, float interval, float& velocity_x, float& velocity_y)
+		{
+			float dx = x - iter.x;
+			float dy = y - iter.y;
+			float angle = std::atan2(dy, dx);
+			float distance = std::sqrt(dx * dx + dy * dy);
+			float w = iter.elapsed * iter.frequency - distance * iter.density;
+			float distance_to_ripple = std::abs(w);
+			float signed_frequency = w > 0.0f ? iter.frequency : -iter.frequency;
+			float attenuation = 1.0f / (iter.elapsed + 1.0f);
+
+			float value = iter.amplitude * interval * std::exp(-distance_to_ripple) * attenuation;
+			value *= -(signed_frequency * (std::sin(distance_to_ripple) + std::cos(distance_to_ripple)) + std::cos(distance_to_ripple) * attenuation);
+			velocity_x += value * std::cos(angle);
+			velocity_y += value * std::sin(angle);
+		}
+
+		/**
+		 * @brief 标量参考实现：点击波纹
+		 */
+		template <bool Velocity>
+		static void accumulateClickRipplesLoop(const Frame& frame, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				float offset_x = frame.offsetX[i], offset_y = frame.offsetY[i];
+				for (size_t r = 0; r < frame.clickRippleCount; r++)
+				{
+					addClickRipple(frame.clickRipples[r], frame.originX[i], frame.originY[i], offset_x, offset_y);
+					if (Velocity)
+					{
+						addClickRippleVelocity(frame.clickRipples[r], frame.originX[i], frame.originY[i], frame.velocityInterval, frame.velocityX[i], frame.velocityY[i]);
+					}
+				}
+				frame.offsetX[i] = offset_x;
+				frame.offsetY[i] = offset_y;
+			}
+		}
+
+		void accumulateClickRipples(const Frame& frame, size_t begin, size_t end)
+		{
+			if (frame.velocityX != nullptr)
+			{
+				accumulateClickRipplesLoop<true>(frame, begin, end);
+			}
+			else
+			{
+				accumulateClickRipplesLoop<false>(frame, begin, end);
+			}
+		}
+
+		/**
+		 * @brief 标量参考实现：单个点击波纹在连续顶点区间上的位移
+		 */
+		template <bool Velocity>
+		static void accumulateClickRippleSpanLoop(const Frame& frame, const ClickRipple& ripple, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				addClickRipple(ripple, frame.originX[i], frame.originY[i], frame.offsetX[i], frame.offsetY[i]);
+				if (Velocity)
+				{
+					addClickRippleVelocity(ripple, frame.originX[i], frame.originY[i], frame.velocityInterval, frame.velocityX[i], frame.velocityY[i]);
+				}
+			}
+		}
+
+		void accumulateClickRippleSpan(const Frame& frame, const ClickRipple& ripple, size_t begin, size_t end)
+		{
+			if (frame.velocityX != nullptr)
+			{
+				accumulateClickRippleSpanLoop<true>(frame, ripple, begin, end);
+			}
+			else
+			{
+				accumulateClickRippleSpanLoop<false>(frame, ripple, begin, end);
+			}
+		}
+	}
+
+	/**
+	 * @brief 在升序排列（按步长取值）的坐标中查找第一个不小于 value 的下标
+	 * @param values 坐标数组
+	 * @param count 元素数量
+	 * @param stride 相邻元素的间隔
+	 * @param value 查找值
+	 * @return 下标，全部小于 value 时返回 count
+	 */
+	static size_t lowerBound(const float* values, size_t count, size_t stride, float value)
+	{
+		size_t first = 0;
+		while (count > 0)
+		{
+			size_t half = count / 2;
+			if (values[(first + half) * stride] < value)
+			{
+				first += half + 1;
+				count -= half + 1;
+			}
+			else
+			{
+				count = half;
+			}
+		}
+		return first;
+	}
+
+	/**
+	 * @brief 把坐标区间 [low, high] 转换为列区间，两侧各多留一列以吸收舍入误差
+	 */
+	static void columnRange(const Frame& frame, float low, float high, size_t& columnBegin, size_t& columnEnd)
+	{
+		columnBegin = lowerBound(frame.originX, frame.columns, 1, low);
+		columnBegin = columnBegin > 0 ? columnBegin - 1 : 0;
+		columnEnd = std::min(lowerBound(frame.originX, frame.columns, 1, high) + 1, frame.columns);
+	}
+
+	static void accumulateClickRippleSpan(Isa isa, const Frame& frame, const ClickRipple& ripple, size_t begin, size_t end)
+	{
+		switch (isa)
+		{
+#if defined(WATER_KERNEL_X86)
+		case Isa::AVX2:
+			Avx2::accumulateClickRippleSpan(frame, ripple, begin, end);
+			break;
+		case Isa::SSE2:
+			Sse2::accumulateClickRippleSpan(frame, ripple, begin, end);
+			break;
+#endif
+		default:
+			if (frame.precision == Precision::Fast)
+			{
+				Portable::accumulateClickRippleSpan(frame, ripple, begin, end);
+			}
+			else
+			{
+				Scalar::accumulateClickRippleSpan(frame, ripple, begin, end);
+			}
+			break;
+		}
+	}
+
+	/**
+	 * @brief 只在每个点击波纹的有效圆环内累加位移
+	 * @details 逐行求出圆环与该行相交的列区间（内圆把一行分成左右两段），再与 [begin, end) 求交
+	 */
+	static void accumulateCulledClickRipples(Isa isa, const Frame& frame, size_t begin, size_t end)
+	{
+		size_t columns = frame.columns;
+		size_t firstRow = begin / columns;
+		size_t lastRow = (end + columns - 1) / columns;
+		for (size_t r = 0; r < frame.clickRippleCount; r++)
+		{
+			const ClickRipple& ripple = frame.clickRipples[r];
+			Annulus annulus;
+			if (!clickRippleAnnulus(ripple, frame.clickRippleEpsilon, annulus, frame.velocityX != nullptr ? frame.velocityInterval : 0.0f))
+			{
+				continue;
+			}
+			float outer2 = annulus.outerRadius * annulus.outerRadius;
+			float inner2 = annulus.innerRadius * annulus.innerRadius;
+
+			size_t rowBegin = lowerBound(frame.originY, frame.rows, columns, ripple.y - annulus.outerRadius);
+			rowBegin = std::max(rowBegin > 0 ? rowBegin - 1 : 0, firstRow);
+			size_t rowEnd = std::min(std::min(lowerBound(frame.originY, frame.rows, columns, ripple.y + annulus.outerRadius) + 1, frame.rows), lastRow);
+			for (size_t row = rowBegin; row < rowEnd; row++)
+			{
+				float dy = frame.originY[row * columns] - ripple.y;
+				float dy2 = dy * dy;
+				if (dy2 > outer2)
+				{
+					continue;
+				}
+				float halfWidth = std::sqrt(outer2 - dy2);
+				size_t spanBegin[2], spanEnd[2];
+				size_t spanCount = 1;
+				if (inner2 > dy2)
+				{
+					float innerHalfWidth = std::sqrt(inner2 - dy2);
+					columnRange(frame, ripple.x - halfWidth, ripple.x - innerHalfWidth, spanBegin[0], spanEnd[0]);
+					columnRange(frame, ripple.x + innerHalfWidth, ripple.x + halfWidth, spanBegin[1], spanEnd[1]);
+					if (spanBegin[1] <= spanEnd[0])
+					{
+						spanEnd[0] = spanEnd[1];
+					}
+					else
+					{
+						spanCount = 2;
+					}
+				}
+				else
+				{
+					columnRange(frame, ripple.x - halfWidth, ripple.x + halfWidth, spanBegin[0], spanEnd[0]);
+				}
+
+				for (size_t k = 0; k < spanCount; k++)
+				{
+					size_t vertexBegin = std::max(row * columns + spanBegin[k], begin);
+					size_t vertexEnd = std::min(row * columns + spanEnd[k], end);
+					if (vertexBegin < vertexEnd)
+					{
+						accumulateClickRippleSpan(isa, frame, ripple, vertexBegin, vertexEnd);
+					}
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief 检查CPU与操作系统是否支持AVX2
+	 * @return 支持返回true
+	 */
+	static bool cpuHasAvx2()
+	{
+#if defined(WATER_KERNEL_X86) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+		{
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#elif defined(WATER_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * @brief 检查CPU是否支持SSE2
+	 * @return 支持返回true
+	 */
+	static bool cpuHasSse2()
+	{
+#if defined(__x86_64__) || defined(_M_X64)
+		return true;
+#elif defined(WATER_KERNEL_X86) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[3] & (1 << 26)) != 0;
+#elif defined(WATER_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+		return __builtin_cpu_supports("sse2");
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * @brief 检测当前CPU支持的最优指令集路径
+	 * @return 可用的最优路径
+	 */
+	Isa detectIsa()
+	{
+		static const Isa detected = cpuHasAvx2() ? Isa::AVX2 : (cpuHasSse2() ? Isa::SSE2 : Isa::Scalar);
+		return detected;
+	}
+
+	/**
+	 * @brief 判断指定路径在当前CPU上是否可用
+	 * @param isa 指令集路径
+	 * @return 可用返回true
+	 */
+	bool isIsaSupported(Isa isa)
+	{
+		return static_cast<int>(isa) <= static_cast<int>(detectIsa());
+	}
+
+	/**
+	 * @brief 获取指令集路径名称
+	 * @param isa 指令集路径
+	 * @return 名称字符串（"scalar"/"sse2"/"avx2"）
+	 */
+	const char* isaName(Isa isa)
+	{
+		switch (isa)
+		{
+		case Isa::SSE2:
+			return "sse2";
+		case Isa::AVX2:
+			return "avx2";
+		default:
+			return "scalar";
+		}
+	}
+
+	/**
+	 * @brief 构建直线波纹的可分离求值表
+	 * @param frame 帧数据（使用 originX/originY/columns/rows/waves/time）
+	 * @param columnSin 输出：amplitude·sin(列相位)，waveCount × columns
+	 * @param columnCos 输出：amplitude·cos(列相位)，waveCount × columns
+	 * @param rowSin 输出：sin(行相位)，waveCount × rows
+	 * @param rowCos 输出：cos(行相位)，waveCount × rows
+	 */
+	void buildWaveTables(const Frame& frame, float* columnSin, float* columnCos, float* rowSin, float* rowCos)
+	{
+		for (size_t w = 0; w < frame.waveCount; w++)
+		{
+			const Wave& wave = frame.waves[w];
+			double base = static_cast<double>(wave.frequency) * frame.time - static_cast<double>(wave.density) * wave.phi;
+			double columnStep = static_cast<double>(wave.density) * wave.A;
+			double rowStep = static_cast<double>(wave.density) * wave.B;
+			for (size_t c = 0; c < frame.columns; c++)
+			{
+				double a = base - columnStep * frame.originX[c];
+				columnSin[w * frame.columns + c] = static_cast<float>(wave.amplitude * std::sin(a));
+				columnCos[w * frame.columns + c] = static_cast<float>(wave.amplitude * std::cos(a));
+			}
+			for (size_t r = 0; r < frame.rows; r++)
+			{
+				double b = -rowStep * frame.originY[r * frame.columns];
+				rowSin[w * frame.rows + r] = static_cast<float>(std::sin(b));
+				rowCos[w * frame.rows + r] = static_cast<float>(std::cos(b));
+			}
+		}
+	}
+
+	/**
+	 * @brief 可分离求值表与逐顶点直接求值之间位移差的上界
+	 * @param frame 帧数据（使用 originX/originY/columns/rows/waves/time/velocityX/velocityInterval）
+	 * @return 像素
+	 * @details 逐项累计直接求值中各次float运算的舍入上界：A·x、B·y、两次加法和 k·distance 各不超过 distance 相关项的 2^-24 倍，
+	 * f·t 和最后的减法各不超过 |f·t| + k·distance 的 2^-24 倍；sin 的导数不超过1，位移差不超过 amplitude 乘以相位误差
+	 */
+	float waveTableTolerance(const Frame& frame)
+	{
+		if (frame.waveCount == 0 || frame.columns == 0 || frame.rows == 0)
+		{
+			return 0.0f;
+		}
+		double maxX = 0.0;
+		double maxY = 0.0;
+		for (size_t c = 0; c < frame.columns; c++)
+		{
+			maxX = std::max(maxX, std::fabs(static_cast<double>(frame.originX[c])));
+		}
+		for (size_t r = 0; r < frame.rows; r++)
+		{
+			maxY = std::max(maxY, std::fabs(static_cast<double>(frame.originY[r * frame.columns])));
+		}
+		const double unit = std::ldexp(1.0, -24);
+		double tolerance = 0.0;
+		for (size_t w = 0; w < frame.waveCount; w++)
+		{
+			const Wave& wave = frame.waves[w];
+			double distance = std::fabs(wave.A) * maxX + std::fabs(wave.B) * maxY + std::fabs(wave.phi);
+			double phase = std::fabs(static_cast<double>(wave.frequency) * frame.time) + std::fabs(wave.density) * distance;
+			double phaseError = unit * (2.0 * phase + 4.0 * std::fabs(wave.density) * distance);
+			double scale = 1.0;
+			if (frame.velocityX != nullptr)
+			{
+				scale = std::max(scale, std::fabs(static_cast<double>(wave.frequency) * frame.velocityInterval));
+			}
+			tolerance += std::fabs(wave.amplitude) * phaseError * scale;
+		}
+		return static_cast<float>(tolerance);
+	}
+
+	/**
+	 * @brief 构建单个固定波纹的径向几何缓存
+	 * @param originX 顶点原始X坐标
+	 * @param originY 顶点原始Y坐标
+	 * @param count 顶点数量
+	 * @param ripple 固定波纹参数
+	 * @param phase 输出：density·distance
+	 * @param dirX 输出：顶点相对波纹中心的单位方向X分量
+	 * @param dirY 输出：顶点相对波纹中心的单位方向Y分量
+	 */
+	void buildRippleCache(const float* originX, const float* originY, size_t count, const Ripple& ripple, float* phase, float* dirX, float* dirY)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			float dx = originX[i] - ripple.x;
+			float dy = originY[i] - ripple.y;
+			float distance = std::sqrt(dx * dx + dy * dy);
+			phase[i] = ripple.density * distance;
+			if (distance > 0.0f)
+			{
+				dirX[i] = dx / distance;
+				dirY[i] = dy / distance;
+			}
+			else
+			{
+				dirX[i] = 1.0f;
+				dirY[i] = 0.0f;
+			}
+		}
+	}
+
+	/**
+	 * @brief 按几何缓存构建单个固定波纹的增量相量
+	 * @param phase 几何缓存中的 density·distance
+	 * @param count 顶点数量
+	 * @param angle frequency·time，以双精度传入
+	 * @param phasorCos 输出：cos(angle - phase)
+	 * @param phasorSin 输出：sin(angle - phase)
+	 * @details 以双精度求值，此后每帧只需旋转 frequency·Δt，见 advanceFixedRipplePhasors
+	 */
+	void buildRipplePhasors(const float* phase, size_t count, double angle, float* phasorCos, float* phasorSin)
+	{
+		// 先把 angle 约减到一个周期内，避免长时间运行后与 float 相位相减时丢失精度
+		const double twoPi = 6.283185307179586;
+		angle -= std::floor(angle / twoPi) * twoPi;
+		for (size_t i = 0; i < count; i++)
+		{
+			double value = angle - phase[i];
+			phasorCos[i] = static_cast<float>(std::cos(value));
+			phasorSin[i] = static_cast<float>(std::sin(value));
+		}
+	}
+
+	/**
+	 * @brief 只把区间内的增量相量旋转到本帧，不累加位移
+	 * @param frame 帧数据（使用 fixedRipplePhasorCos/fixedRipplePhasorSin/fixedRippleRotation/fixedRipplePhasorRenormalize）
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 用于本帧跳过计算的顶点，保证每个顶点的相量每帧都恰好旋转一次；运算顺序与 accumulateFixedRipples 相同
+	 */
+	void advanceFixedRipplePhasors(const Frame& frame, size_t begin, size_t end)
+	{
+		if (frame.fixedRipplePhasorCos == nullptr)
+		{
+			return;
+		}
+		for (size_t r = 0; r < frame.fixedRippleCount; r++)
+		{
+			float rotationCos = frame.fixedRippleRotation[2 * r];
+			float rotationSin = frame.fixedRippleRotation[2 * r + 1];
+			float* phasorCos = frame.fixedRipplePhasorCos + r * frame.vertexCount;
+			float* phasorSin = frame.fixedRipplePhasorSin + r * frame.vertexCount;
+			for (size_t i = begin; i < end; i++)
+			{
+				float c = phasorCos[i] * rotationCos - phasorSin[i] * rotationSin;
+				float s = phasorSin[i] * rotationCos + phasorCos[i] * rotationSin;
+				if (frame.fixedRipplePhasorRenormalize)
+				{
+					float scale = 1.5f - 0.5f * (c * c + s * s);
+					c *= scale;
+					s *= scale;
+				}
+				phasorCos[i] = c;
+				phasorSin[i] = s;
+			}
+		}
+	}
+
+	/**
+	 * @brief 计算点击波纹位移超过阈值的环形区域
+	 * @param ripple 点击波纹参数
+	 * @param epsilon 位移阈值（像素）
+	 * @param annulus 输出：环形区域
+	 * @param velocityInterval 大于0时同时要求圆环外位移对时间的导数乘以该间隔不超过阈值
+	 * @return 波纹在任何位置的位移都不超过阈值时返回false
+	 */
+	bool clickRippleAnnulus(const ClickRipple& ripple, float epsilon, Annulus& annulus, float velocityInterval)
+	{
+		float peak = std::abs(ripple.amplitude) / (ripple.elapsed + 1.0f);
+		if (velocityInterval > 0.0f)
+		{
+			peak *= std::max(1.0f, (1.41422f * std::abs(ripple.frequency) + 1.0f / (ripple.elapsed + 1.0f)) * velocityInterval);
+		}
+		if (peak <= epsilon)
+		{
+			return false;
+		}
+		if (epsilon <= 0.0f || ripple.density <= 0.0f)
+		{
+			annulus.innerRadius = 0.0f;
+			annulus.outerRadius = HUGE_VALF;
+			return true;
+		}
+		float reach = std::log(peak / epsilon);
+		float center = ripple.elapsed * ripple.frequency;
+		annulus.innerRadius = std::max(0.0f, (center - reach) / ripple.density);
+		annulus.outerRadius = (center + reach) / ripple.density;
+		return annulus.outerRadius >= 0.0f;
+	}
+
+	/**
+	 * @brief 累加直线波纹位移
+	 * @param isa 指令集路径
+	 * @param frame 帧数据
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details frame 中提供了可分离求值表时使用查表路径，否则逐顶点计算三角函数
+	 */
+	void accumulateWaves(Isa isa, const Frame& frame, size_t begin, size_t end)
+	{
+		if (frame.waveCount == 0)
+		{
+			return;
+		}
+		if (frame.waveColumnSin != nullptr)
+		{
+			switch (isa)
+			{
+#if defined(WATER_KERNEL_X86)
+			case Isa::AVX2:
+				Avx2::accumulateSeparableWaves(frame, begin, end);
+				break;
+			case Isa::SSE2:
+				Sse2::accumulateSeparableWaves(frame, begin, end);
+				break;
+#endif
+			default:
+				Scalar::accumulateSeparableWaves(frame, begin, end);
+				break;
+			}
+			return;
+		}
+		switch (isa)
+		{
+#if defined(WATER_KERNEL_X86)
+		case Isa::AVX2:
+			Avx2::accumulateWaves(frame, begin, end);
+			break;
+		case Isa::SSE2:
+			Sse2::accumulateWaves(frame, begin, end);
+			break;
+#endif
+		default:
+			if (frame.precision == Precision::Fast)
+			{
+				Portable::accumulateWaves(frame, begin, end);
+			}
+			else
+			{
+				Scalar::accumulateWaves(frame, begin, end);
+			}
+			break;
+		}
+	}
+
+	/**
+	 * @brief 累加固定波纹位移
+	 * @param isa 指令集路径
+	 * @param frame 帧数据
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details frame 中提供了几何缓存时直接读取距离和方向，否则逐顶点计算
+	 */
+	void accumulateFixedRipples(Isa isa, const Frame& frame, size_t begin, size_t end)
+	{
+		if (frame.fixedRippleCount == 0)
+		{
+			return;
+		}
+		if (frame.fixedRipplePhasorCos != nullptr)
+		{
+			// 增量相量只用于 Fast 精度，标量路径同样使用多项式路径的实现
+			switch (isa)
+			{
+#if defined(WATER_KERNEL_X86)
+			case Isa::AVX2:
+				Avx2::accumulatePhasorFixedRipples(frame, begin, end);
+				break;
+			case Isa::SSE2:
+				Sse2::accumulatePhasorFixedRipples(frame, begin, end);
+				break;
+#endif
+			default:
+				Portable::accumulatePhasorFixedRipples(frame, begin, end);
+				break;
+			}
+			return;
+		}
+		if (frame.fixedRipplePhase != nullptr)
+		{
+			switch (isa)
+			{
+#if defined(WATER_KERNEL_X86)
+			case Isa::AVX2:
+				Avx2::accumulateCachedFixedRipples(frame, begin, end);
+				break;
+			case Isa::SSE2:
+				Sse2::accumulateCachedFixedRipples(frame, begin, end);
+				break;
+#endif
+			default:
+				if (frame.precision == Precision::Fast)
+				{
+					Portable::accumulateCachedFixedRipples(frame, begin, end);
+				}
+				else
+				{
+					Scalar::accumulateCachedFixedRipples(frame, begin, end);
+				}
+				break;
+			}
+			return;
+		}
+		switch (isa)
+		{
+#if defined(WATER_KERNEL_X86)
+		case Isa::AVX2:
+			Avx2::accumulateFixedRipples(frame, begin, end);
+			break;
+		case Isa::SSE2:
+			Sse2::accumulateFixedRipples(frame, begin, end);
+			break;
+#endif
+		default:
+			if (frame.precision == Precision::Fast)
+			{
+				Portable::accumulateFixedRipples(frame, begin, end);
+			}
+			else
+			{
+				Scalar::accumulateFixedRipples(frame, begin, end);
+			}
+			break;
+		}
+	}
+
+	/**
+	 * @brief 累加点击波纹位移
+	 * @param isa 指令集路径
+	 * @param frame 帧数据
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details clickRippleEpsilon 大于0且网格规则时，每个波纹只访问与其有效圆环相交的行和列区间，
+	 * 被跳过的顶点上该波纹的位移不超过 clickRippleEpsilon
+	 */
+	void accumulateClickRipples(Isa isa, const Frame& frame, size_t begin, size_t end)
+	{
+		if (frame.clickRippleCount == 0 || begin >= end)
+		{
+			return;
+		}
+		if (frame.clickRippleEpsilon > 0.0f && frame.columns > 0 && frame.rows * frame.columns == frame.vertexCount)
+		{
+			accumulateCulledClickRipples(isa, frame, begin, end);
+			return;
+		}
+		switch (isa)
+		{
+#if defined(WATER_KERNEL_X86)
+		case Isa::AVX2:
+			Avx2::accumulateClickRipples(frame, begin, end);
+			break;
+		case Isa::SSE2:
+			Sse2::accumulateClickRipples(frame, begin, end);
+			break;
+#endif
+		default:
+			if (frame.precision == Precision::Fast)
+			{
+				Portable::accumulateClickRipples(frame, begin, end);
+			}
+			else
+			{
+				Scalar::accumulateClickRipples(frame, begin, end);
+			}
+			break;
+		}
+	}
+
+	/**
+	 * @brief 推进高度场一步中的单个边缘顶点
+	 * @details 区域外的邻居按高度0处理
+	 */
+	static void stepHeightFieldEdge(const HeightFieldStep& step, size_t i, size_t column)
+	{
+		size_t columns = step.columns;
+		size_t count = columns * step.rows;
+		const float* h = step.current;
+		float center = h[i];
+		float left = column > 0 ? h[i - 1] : 0.0f;
+		float right = column + 1 < columns ? h[i + 1] : 0.0f;
+		float up = i >= columns ? h[i - columns] : 0.0f;
+		float down = i + columns < count ? h[i + columns] : 0.0f;
+		float velocity = (center - step.previous[i]) * step.damping;
+		step.previous[i] = center + velocity + step.coefficientX * (left + right - 2.0f * center) + step.coefficientY * (up + down - 2.0f * center);
+	}
+
+	/**
+	 * @brief 推进高度场一步
+	 * @param step 高度场数据
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 只写区间内的顶点，只读 current，不同区间可以并行处理
+	 */
+	void stepHeightField(const HeightFieldStep& step, size_t begin, size_t end)
+	{
+		size_t columns = step.columns;
+		size_t rows = step.rows;
+		if (columns == 0 || begin >= end)
+		{
+			return;
+		}
+		const float* h = step.current;
+		size_t i = begin;
+		while (i < end)
+		{
+			size_t row = i / columns;
+			size_t rowEnd = std::min(end, (row + 1) * columns);
+			if (row == 0 || row + 1 >= rows)
+			{
+				for (; i < rowEnd; i++)
+				{
+					stepHeightFieldEdge(step, i, i - row * columns);
+				}
+				continue;
+			}
+			// 内部行：只有首尾两列需要边界处理，其余顶点四个邻居都存在
+			size_t first = row * columns;
+			if (i == first)
+			{
+				stepHeightFieldEdge(step, i, 0);
+				i++;
+			}
+			size_t interiorEnd = std::min(rowEnd, first + columns - 1);
+			for (; i < interiorEnd; i++)
+			{
+				float center = h[i];
+				float velocity = (center - step.previous[i]) * step.damping;
+				step.previous[i] = center + velocity + step.coefficientX * (h[i - 1] + h[i + 1] - 2.0f * center) + step.coefficientY * (h[i - columns] + h[i + columns] - 2.0f * center);
+			}
+			for (; i < rowEnd; i++)
+			{
+				stepHeightFieldEdge(step, i, i - first);
+			}
+		}
+	}
+
+	/**
+	 * @brief 求高度场在一个顶点处的梯度
+	 * @details 内部顶点用中心差分，边缘顶点用单侧差分，间距取自顶点原始坐标
+	 */
+	static void heightFieldGradient(const Frame& frame, const float* h, size_t i, size_t column, size_t row, float& gradientX, float& gradientY)
+	{
+		size_t left = column > 0 ? i - 1 : i;
+		size_t right = column + 1 < frame.columns ? i + 1 : i;
+		size_t up = row > 0 ? i - frame.columns : i;
+		size_t down = row + 1 < frame.rows ? i + frame.columns : i;
+		float spanX = frame.originX[right] - frame.originX[left];
+		float spanY = frame.originY[down] - frame.originY[up];
+		gradientX = spanX > 0.0f ? (h[right] - h[left]) / spanX : 0.0f;
+		gradientY = spanY > 0.0f ? (h[down] - h[up]) / spanY : 0.0f;
+	}
+
+	/**
+	 * @brief 累加高度场位移
+	 * @param frame 帧数据（使用 originX/originY/columns/rows/heightField）
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 位移为高度的负梯度（中心差分，边缘单侧差分），波峰处顶点向外推开；
+	 * frame 提供了 velocityX/velocityY 时由相邻两步高度场的梯度之差求出速度
+	 */
+	void accumulateHeightField(const Frame& frame, size_t begin, size_t end)
+	{
+		if (frame.heightField == nullptr || frame.columns == 0)
+		{
+			return;
+		}
+		float velocityScale = frame.heightFieldRate * frame.velocityInterval;
+		size_t row = begin / frame.columns;
+		size_t column = begin % frame.columns;
+		for (size_t i = begin; i < end; i++)
+		{
+			float gradientX, gradientY;
+			heightFieldGradient(frame, frame.heightField, i, column, row, gradientX, gradientY);
+			frame.offsetX[i] -= gradientX;
+			frame.offsetY[i] -= gradientY;
+			if (frame.velocityX != nullptr && frame.heightFieldPrevious != nullptr)
+			{
+				float previousX, previousY;
+				heightFieldGradient(frame, frame.heightFieldPrevious, i, column, row, previousX, previousY);
+				frame.velocityX[i] -= (gradientX - previousX) * velocityScale;
+				frame.velocityY[i] -= (gradientY - previousY) * velocityScale;
+			}
+			if (++column == frame.columns)
+			{
+				column = 0;
+				++row;
+			}
+		}
+	}
+
+	/**
+	 * @brief 清零区间内的位移
+	 * @param frame 帧数据（使用 offsetX/offsetY，提供了 velocityX/velocityY 时同时清零速度）
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 */
+	void resetDisplacement(const Frame& frame, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			frame.offsetX[i] = 0.0f;
+			frame.offsetY[i] = 0.0f;
+		}
+		if (frame.velocityX != nullptr)
+		{
+			std::fill(frame.velocityX + begin, frame.velocityX + end, 0.0f);
+			std::fill(frame.velocityY + begin, frame.velocityY + end, 0.0f);
+		}
+	}
+
+	/**
+	 * @brief 计算区间内的完整位移
+	 * @param isa 指令集路径
+	 * @param frame 帧数据
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 先由 resetDisplacement 清零，再依次累加直线波纹、固定波纹、点击波纹和高度场；
+	 * frame 提供了 velocityX/velocityY 时在同一遍计算中求出位移对时间的解析导数
+	 */
+	void displace(Isa isa, const Frame& frame, size_t begin, size_t end)
+	{
+		resetDisplacement(frame, begin, end);
+		accumulateWaves(isa, frame, begin, end);
+		accumulateFixedRipples(isa, frame, begin, end);
+		accumulateClickRipples(isa, frame, begin, end);
+		accumulateHeightField(frame, begin, end);
+	}
+
+	/**
+	 * @brief 约束单个边缘顶点的一个偏移分量
+	 * @param offset 偏移数组
+	 * @param velocity 对应的速度数组，可以为空
+	 * @param i 顶点下标
+	 * @param origin 顶点原始坐标
+	 * @param leading 首列/首行为true（位置不超过0），末列/末行为false（偏移不小于0）
+	 */
+	static void clampOffset(float* offset, float* velocity, size_t i, float origin, bool leading)
+	{
+		bool clamp = leading ? origin + offset[i] > 0.0f : origin + offset[i] < origin;
+		if (clamp)
+		{
+			offset[i] = leading ? -origin : 0.0f;
+			if (velocity != nullptr)
+			{
+				velocity[i] = 0.0f;
+			}
+		}
+	}
+
+	/**
+	 * @brief 应用边界约束
+	 * @param frame 帧数据（使用 originX/originY/offsetX/offsetY/columns/rows，不规则布局使用 boundaryVertices/boundarySides）
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 修正偏移使边缘顶点不向绘制区域内部移动：首列、首行不超过0，末列、末行不小于原始位置。
+	 * 与原实现一致，第二行的首个顶点也按首行处理；被约束的分量不再随波纹运动，其速度同时清零。
+	 * 只访问区间内的边缘顶点，内部顶点不做任何判断；不规则布局在边缘顶点列表中二分查找区间的起点
+	 */
+	void applyBoundary(const Frame& frame, size_t begin, size_t end)
+	{
+		size_t columns = frame.columns;
+		if (begin >= end)
+		{
+			return;
+		}
+		if (columns == 0)
+		{
+			const unsigned int* vertices = frame.boundaryVertices;
+			const unsigned int* verticesEnd = vertices + frame.boundaryVertexCount;
+			for (const unsigned int* iter = std::lower_bound(vertices, verticesEnd, begin); iter != verticesEnd && *iter < end; ++iter)
+			{
+				size_t i = *iter;
+				unsigned char sides = frame.boundarySides[iter - vertices];
+				if (sides & (BoundaryLeft | BoundaryRight))
+				{
+					clampOffset(frame.offsetX, frame.velocityX, i, frame.originX[i], (sides & BoundaryLeft) != 0);
+				}
+				if (sides & (BoundaryTop | BoundaryBottom))
+				{
+					clampOffset(frame.offsetY, frame.velocityY, i, frame.originY[i], (sides & BoundaryTop) != 0);
+				}
+			}
+			return;
+		}
+		size_t lastRow = columns * (frame.rows - 1);
+		// 首列与末列：每行只访问两个顶点
+		for (size_t row = begin / columns, rowEnd = (end - 1) / columns; row <= rowEnd; row++)
+		{
+			size_t first = row * columns;
+			if (first >= begin)
+			{
+				clampOffset(frame.offsetX, frame.velocityX, first, frame.originX[first], true);
+			}
+			size_t last = first + columns - 1;
+			if (columns > 1 && last >= begin && last < end)
+			{
+				clampOffset(frame.offsetX, frame.velocityX, last, frame.originX[last], false);
+			}
+		}
+		// 首行（含第二行的首个顶点）与末行
+		for (size_t i = begin, firstEnd = std::min(end, columns + 1); i < firstEnd; i++)
+		{
+			clampOffset(frame.offsetY, frame.velocityY, i, frame.originY[i], true);
+		}
+		for (size_t i = std::max(begin, std::max(lastRow, columns + 1)); i < end; i++)
+		{
+			clampOffset(frame.offsetY, frame.velocityY, i, frame.originY[i], false);
+		}
+	}
+
+	/**
+	 * @brief 帧间差分光照
+	 * @details Fast 在编译期确定，循环内不再判断精度
+	 */
+	template <bool Fast>
+	static void frameDeltaLighting(const Frame& frame, float lightX, float lightY, size_t begin, size_t end)
+	{
+		const Light& light = frame.light;
+		for (size_t i = begin; i < end; i++)
+		{
+			float x = frame.originX[i] + frame.offsetX[i];
+			float y = frame.originY[i] + frame.offsetY[i];
+
+			float dx = x - frame.positionX[i];
+			float dy = y - frame.positionY[i];
+
+			float distance = std::sqrt(dx * dx + dy * dy);
+
+			float alpha = light.defaultAlpha;
+			if (distance > light.minDistance)
+			{
+				if (Fast)
+				{
+					alpha = distance > 0.0f ? (distance - light.minDistance) / distance * (dx * lightX + dy * lightY) / light.decay + light.defaultAlpha : alpha;
+				}
+				else
+				{
+					alpha = (distance - light.minDistance) * std::cos(std::atan2(-dy, dx) - light.angle) / light.decay + light.defaultAlpha;
+				}
+			}
+
+			float lastAlpha = frame.alpha[i];
+			alpha = std::min(std::max(alpha, lastAlpha - 0.1f), lastAlpha + 0.1f);
+			alpha = std::min(std::max(alpha, light.minAlpha), 1.0f);
+
+			frame.positionX[i] = x;
+			frame.positionY[i] = y;
+			frame.alpha[i] = alpha;
+		}
+	}
+
+	/**
+	 * @brief 计算顶点新位置和透明度
+	 * @param frame 帧数据（使用 originX/originY/offsetX/offsetY/positionX/positionY/alpha/light）
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 由新旧位置之差计算透明度：位移超过 minDistance 时按位移方向与光照角度的夹角增减，
+	 * 每帧变化不超过0.1并限制在 [minAlpha, 1]，随后把新位置写回 positionX/positionY。
+	 * frame 提供了 velocityX/velocityY 时改用解析光照：以速度乘以 velocityInterval 代替新旧位置之差，
+	 * 夹角余弦由与光照方向的点积求出，不读取上一帧的位置和透明度，结果与帧率无关。
+	 * 帧间差分光照在 Fast 精度下同样用点积代替 cos(atan2(-dy, dx) - angle)。
+	 * 速度数组可以与 positionX/positionY 是同一块内存，每个顶点先读速度再写位置
+	 */
+	void applyLighting(const Frame& frame, size_t begin, size_t end)
+	{
+		const Light& light = frame.light;
+		// 与 cos(atan2(-dy, dx) - angle)·distance 相同：位移与光照方向 (cos angle, -sin angle) 的点积
+		float lightX = std::cos(light.angle);
+		float lightY = -std::sin(light.angle);
+		if (frame.velocityX != nullptr)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				float dx = frame.velocityX[i];
+				float dy = frame.velocityY[i];
+				float distance = std::sqrt(dx * dx + dy * dy);
+
+				float alpha = light.defaultAlpha;
+				if (distance > light.minDistance && distance > 0.0f)
+				{
+					alpha = (distance - light.minDistance) / distance * (dx * lightX + dy * lightY) / light.decay + light.defaultAlpha;
+				}
+				alpha = std::min(std::max(alpha, light.minAlpha), 1.0f);
+
+				frame.positionX[i] = frame.originX[i] + frame.offsetX[i];
+				frame.positionY[i] = frame.originY[i] + frame.offsetY[i];
+				frame.alpha[i] = alpha;
+			}
+			return;
+		}
+		if (frame.precision == Precision::Fast)
+		{
+			frameDeltaLighting<true>(frame, lightX, lightY, begin, end);
+		}
+		else
+		{
+			frameDeltaLighting<false>(frame, lightX, lightY, begin, end);
+		}
+	}
+
+	/**
+	 * @brief 完成区间内的一帧更新
+	 * @param isa 指令集路径
+	 * @param frame 帧数据
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 依次执行 displace、applyBoundary 和 applyLighting
+	 */
+	void update(Isa isa, const Frame& frame, size_t begin, size_t end)
+	{
+		displace(isa, frame, begin, end);
+		applyBoundary(frame, begin, end);
+		applyLighting(frame, begin, end);
+	}
+}
@@ -0,0 +1,399 @@
+﻿#pragma once
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WATER_KERNEL_X86 1
+#endif
+
+/**
+ * @namespace WaterKernel
+ * @brief 顶点位移计算内核（SoA布局）
+ * @details 顶点坐标以分离的 x/y 浮点数组存储，内核按顶点区间 [begin, end) 把各类波纹的位移累加到偏移数组中。
+ * 提供三条实现路径，运行时按CPU能力选择：
+ * - Scalar：标量实现，按 Frame::precision 使用标准库函数（Precise）或与SIMD路径相同的多项式（Fast）
+ * - SSE2：4路并行，使用多项式近似的 sin/cos/exp
+ * - AVX2：8路并行，与SSE2路径使用完全相同的运算序列（不使用FMA）
+ *
+ * 精度说明：多项式 sin/cos 绝对误差约 5e-7（相位 |x| <= 1e5 弧度内），exp 相对误差约 2e-7，
+ * Fast 精度下方向直接取 dx/distance 而不经过 atan2 再求三角函数，同一相位的余弦只计算一次；
+ * 与 Precise 标量路径相比每个顶点的位移差值不超过 kTolerance 像素（使用可分离求值表时再加上 waveTableTolerance）、透明度差值不超过 kAlphaTolerance
+ * （按预设参数及振幅 <= 100 估算，可用 WaterKernelBenchmark --mode accuracy 验证）。
+ * SSE2、AVX2与 Fast 标量路径之间结果逐位一致（编译器不把乘加合并为FMA时），区间尾部不足一个向量宽度的顶点使用同一套多项式逐个计算，
+ * 因此结果与区间如何划分无关。
+ */
+namespace WaterKernel
+{
+	/**
+	 * @enum Isa
+	 * @brief 内核指令集路径
+	 */
+	enum class Isa
+	{
+		Scalar,		///< 标量参考实现
+		SSE2,		///< SSE2 4路SIMD
+		AVX2,		///< AVX2 8路SIMD
+	};
+
+	/**
+	 * @enum Precision
+	 * @brief 超越函数的精度档位
+	 */
+	enum class Precision
+	{
+		Precise,	///< 标准库 sin/cos/exp/atan2，不提供可分离求值表时与原逐顶点算法的公式完全相同，只有 Scalar 路径支持
+		Fast,		///< 多项式近似，去掉冗余的三角函数；SIMD路径始终使用此档位
+	};
+
+	/// Fast 精度与 Precise 精度之间允许的最大位移差（像素），使用可分离求值表时再加上 waveTableTolerance
+	constexpr float kTolerance = 1e-3f;
+
+	/// Fast 精度与 Precise 精度之间允许的最大透明度差
+	constexpr float kAlphaTolerance = 1e-4f;
+
+	/**
+	 * @struct Wave
+	 * @brief 直线波纹的内核参数
+	 */
+	struct Wave
+	{
+		float A = 0.0f;				///< 法向量X分量
+		float B = 0.0f;				///< 法向量Y分量
+		float amplitude = 0.0f;		///< 振幅
+		float frequency = 0.0f;		///< 频率
+		float density = 0.0f;		///< 密度
+		float phi = 0.0f;			///< 相位偏移
+	};
+
+	/**
+	 * @struct Ripple
+	 * @brief 固定波纹的内核参数
+	 */
+	struct Ripple
+	{
+		float x = 0.0f;				///< 中心X坐标
+		float y = 0.0f;				///< 中心Y坐标
+		float amplitude = 0.0f;		///< 振幅
+		float frequency = 0.0f;		///< 频率
+		float density = 0.0f;		///< 密度
+	};
+
+	/**
+	 * @struct ClickRipple
+	 * @brief 点击波纹的内核参数
+	 */
+	struct ClickRipple
+	{
+		float x = 0.0f;				///< 中心X坐标
+		float y = 0.0f;				///< 中心Y坐标
+		float amplitude = 0.0f;		///< 振幅
+		float frequency = 0.0f;		///< 频率
+		float density = 0.0f;		///< 密度
+		float elapsed = 0.0f;		///< 已经过的时间（time - startTime）
+	};
+
+	/**
+	 * @struct Light
+	 * @brief 光照阶段的内核参数
+	 */
+	struct Light
+	{
+		float minDistance = 0.0f;	///< 最小位移阈值
+		float defaultAlpha = 1.0f;	///< 默认透明度
+		float minAlpha = 0.0f;		///< 最小透明度
+		float decay = 10.0f;		///< 透明度衰减系数
+		float angle = 0.0f;			///< 光照角度（弧度制）
+	};
+
+	/**
+	 * @struct Frame
+	 * @brief 单帧内核输入输出
+	 * @details 参数数组必须是连续存储的，指针在内核调用期间保持有效
+	 */
+	struct Frame
+	{
+		const float* originX = nullptr;				///< 顶点原始X坐标
+		const float* originY = nullptr;				///< 顶点原始Y坐标
+		float* offsetX = nullptr;					///< 输出：X方向位移（在原值上累加）
+		float* offsetY = nullptr;					///< 输出：Y方向位移（在原值上累加）
+		float time = 0.0f;							///< 当前时间（秒）
+		const Wave* waves = nullptr;				///< 直线波纹数组
+		size_t waveCount = 0;						///< 直线波纹数量
+		const Ripple* fixedRipples = nullptr;		///< 固定波纹数组
+		size_t fixedRippleCount = 0;				///< 固定波纹数量
+		const ClickRipple* clickRipples = nullptr;	///< 点击波纹数组
+		size_t clickRippleCount = 0;				///< 点击波纹数量
+
+		size_t columns = 0;							///< 网格每行顶点数（规则网格，顶点按行存储），0表示不规则的顶点布局
+		size_t rows = 0;							///< 网格行数
+		const unsigned int* boundaryVertices = nullptr;	///< 不规则布局的边缘顶点下标（升序），规则网格不使用
+		const unsigned char* boundarySides = nullptr;	///< 各边缘顶点所在的边，BoundarySide 的组合
+		size_t boundaryVertexCount = 0;				///< 边缘顶点数量
+		const float* waveColumnSin = nullptr;		///< 可分离求值表：amplitude·sin(列相位)，waveCount × columns
+		const float* waveColumnCos = nullptr;		///< 可分离求值表：amplitude·cos(列相位)，waveCount × columns
+		const float* waveRowSin = nullptr;			///< 可分离求值表：sin(行相位)，waveCount × rows
+		const float* waveRowCos = nullptr;			///< 可分离求值表：cos(行相位)，waveCount × rows
+
+		size_t vertexCount = 0;						///< 顶点总数（几何缓存中每个波纹的步长）
+		const float* fixedRipplePhase = nullptr;	///< 固定波纹几何缓存：density·distance，fixedRippleCount × vertexCount
+		const float* fixedRippleDirX = nullptr;		///< 固定波纹几何缓存：单位方向X分量
+		const float* fixedRippleDirY = nullptr;		///< 固定波纹几何缓存：单位方向Y分量
+		float* fixedRipplePhasorCos = nullptr;		///< 增量相量：cos(frequency·time - density·distance)，布局同几何缓存，计算时原地旋转到本帧，为空时不使用
+		float* fixedRipplePhasorSin = nullptr;		///< 增量相量：对应的正弦
+		const float* fixedRippleRotation = nullptr;	///< 每个固定波纹本帧的旋转量 cos(frequency·Δt)、sin(frequency·Δt)，2 × fixedRippleCount
+		bool fixedRipplePhasorRenormalize = false;	///< 旋转后是否把相量的模修正回1
+
+		float clickRippleEpsilon = 0.0f;			///< 点击波纹裁剪阈值（像素），0表示不裁剪
+		Precision precision = Precision::Precise;	///< Scalar 路径和光照阶段使用的精度档位
+
+		float* positionX = nullptr;					///< 顶点X坐标：输入为上一帧结果，光照阶段后为当前帧结果
+		float* positionY = nullptr;					///< 顶点Y坐标：同上
+		float* alpha = nullptr;						///< 顶点透明度：同上
+		Light light;								///< 光照参数
+
+		float* velocityX = nullptr;					///< 输出：X方向位移对时间的导数乘以 velocityInterval（在原值上累加），为空时不计算
+		float* velocityY = nullptr;					///< 输出：Y方向，同上
+		float velocityInterval = 0.0f;				///< 把速度换算为位移的时间间隔（秒）
+
+		const float* heightField = nullptr;			///< 高度场（与顶点一一对应，规则网格），为空时不计算
+		const float* heightFieldPrevious = nullptr;	///< 上一步的高度场，用于求速度
+		float heightFieldRate = 0.0f;				///< 高度场每秒的步数
+	};
+
+	/**
+	 * @enum BoundarySide
+	 * @brief 不规则布局中边缘顶点所在的边
+	 */
+	enum BoundarySide : unsigned char
+	{
+		BoundaryLeft = 1,		///< 首列（X不超过0）
+		BoundaryRight = 2,		///< 末列（X偏移不小于0）
+		BoundaryTop = 4,		///< 首行（Y不超过0）
+		BoundaryBottom = 8,		///< 末行（Y偏移不小于0）
+	};
+
+	/**
+	 * @struct HeightFieldStep
+	 * @brief 高度场单步推进的输入输出
+	 * @details 二维波动方程的显式有限差分：h' = h + (h - h⁻)·damping + cx·(左右邻居 - 2h) + cy·(上下邻居 - 2h)，
+	 * 网格外的高度视为0（固定边界），能量最终衰减为0。新高度只依赖同一顶点的上一步高度，
+	 * 因此直接写回 previous，推进后交换 current 和 previous 两个缓冲区
+	 */
+	struct HeightFieldStep
+	{
+		const float* current = nullptr;				///< 当前高度
+		float* previous = nullptr;					///< 输入为上一步高度，输出为下一步高度
+		size_t columns = 0;							///< 每行顶点数
+		size_t rows = 0;							///< 行数
+		float coefficientX = 0.0f;					///< (波速·步长/列间距)²
+		float coefficientY = 0.0f;					///< (波速·步长/行间距)²
+		float damping = 1.0f;						///< 每步的速度保留系数
+	};
+
+	/**
+	 * @struct Annulus
+	 * @brief 点击波纹的有效环形区域
+	 */
+	struct Annulus
+	{
+		float innerRadius = 0.0f;					///< 内半径
+		float outerRadius = 0.0f;					///< 外半径
+	};
+
+	/**
+	 * @brief 检测当前CPU支持的最优指令集路径
+	 * @return 可用的最优路径
+	 */
+	Isa detectIsa();
+
+	/**
+	 * @brief 判断指定路径在当前CPU上是否可用
+	 * @param isa 指令集路径
+	 * @return 可用返回true
+	 */
+	bool isIsaSupported(Isa isa);
+
+	/**
+	 * @brief 获取指令集路径名称
+	 * @param isa 指令集路径
+	 * @return 名称字符串（"scalar"/"sse2"/"avx2"）
+	 */
+	const char* isaName(Isa isa);
+
+	/**
+	 * @brief 构建直线波纹的可分离求值表
+	 * @param frame 帧数据（使用 originX/originY/columns/rows/waves/time）
+	 * @param columnSin 输出：amplitude·sin(列相位)，waveCount × columns
+	 * @param columnCos 输出：amplitude·cos(列相位)，waveCount × columns
+	 * @param rowSin 输出：sin(行相位)，waveCount × rows
+	 * @param rowCos 输出：cos(行相位)，waveCount × rows
+	 * @details 规则网格上同一列顶点的x相同、同一行顶点的y相同，相位 f·t - k·(A·x + B·y + φ)
+	 * 可拆为列项 a = f·t - k·φ - k·A·x 与行项 b = -k·B·y，再由 sin(a+b) = sin a·cos b + cos a·sin b
+	 * 把每帧每个波纹的三角函数调用从 顶点数 次降到 行数+列数 次，顶点上只剩乘加。
+	 * 表在double精度下计算；与逐顶点直接求值的差异来自直接求值时相位参数的float舍入，
+	 * 约为 amplitude × |相位| × 6e-8 像素，上界见 waveTableTolerance。
+	 */
+	void buildWaveTables(const Frame& frame, float* columnSin, float* columnCos, float* rowSin, float* rowCos);
+
+	/**
+	 * @brief 可分离求值表与逐顶点直接求值之间位移差的上界
+	 * @param frame 帧数据（使用 originX/originY/columns/rows/waves/time/velocityX/velocityInterval）
+	 * @return 像素
+	 * @details 直接求值在float下计算相位 f·t - k·(A·x + B·y + φ)，每次运算的舍入误差不超过所得值的 2^-24 倍，
+	 * 相位的绝对误差随 |f·t| 线性增大（预设参数下约 3e-6 像素每秒），超出 kTolerance 后原公式本身的舍入占主导；
+	 * 表在double下计算，不含这部分舍入。提供 velocityX 时同时覆盖 velocityInterval 内的速度位移差。
+	 * 使用可分离求值表的 Fast 路径与 Precise 路径之间的位移差上限为 kTolerance 加上此值
+	 */
+	float waveTableTolerance(const Frame& frame);
+
+	/**
+	 * @brief 构建单个固定波纹的径向几何缓存
+	 * @param originX 顶点原始X坐标
+	 * @param originY 顶点原始Y坐标
+	 * @param count 顶点数量
+	 * @param ripple 固定波纹参数
+	 * @param phase 输出：density·distance
+	 * @param dirX 输出：顶点相对波纹中心的单位方向X分量
+	 * @param dirY 输出：顶点相对波纹中心的单位方向Y分量
+	 * @details 顶点原始位置和波纹中心都不随时间变化，缓存后每帧每个顶点只需一次余弦；
+	 * 相位与逐顶点直接求值时的float运算完全相同，圆心处方向取 (1, 0)
+	 */
+	void buildRippleCache(const float* originX, const float* originY, size_t count, const Ripple& ripple, float* phase, float* dirX, float* dirY);
+
+	/**
+	 * @brief 按几何缓存构建单个固定波纹的增量相量
+	 * @param phase 几何缓存中的 density·distance
+	 * @param count 顶点数量
+	 * @param angle frequency·time，以双精度传入
+	 * @param phasorCos 输出：cos(angle - phase)
+	 * @param phasorSin 输出：sin(angle - phase)
+	 * @details 以双精度求值，此后每帧只需旋转 frequency·Δt，见 advanceFixedRipplePhasors
+	 */
+	void buildRipplePhasors(const float* phase, size_t count, double angle, float* phasorCos, float* phasorSin);
+
+	/**
+	 * @brief 只把区间内的增量相量旋转到本帧，不累加位移
+	 * @param frame 帧数据（使用 fixedRipplePhasorCos/fixedRipplePhasorSin/fixedRippleRotation/fixedRipplePhasorRenormalize）
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 用于本帧跳过计算的顶点，保证每个顶点的相量每帧都恰好旋转一次
+	 */
+	void advanceFixedRipplePhasors(const Frame& frame, size_t begin, size_t end);
+
+	/**
+	 * @brief 计算点击波纹位移超过阈值的环形区域
+	 * @param ripple 点击波纹参数
+	 * @param epsilon 位移阈值（像素）
+	 * @param annulus 输出：环形区域
+	 * @return 波纹在任何位置的位移都不超过阈值时返回false
+	 * @param velocityInterval 大于0时同时要求圆环外位移对时间的导数乘以该间隔不超过阈值
+	 * @details 位移幅度不超过 amplitude·exp(-r)/(elapsed+1)，其中 r = |elapsed·frequency - distance·density|，
+	 * 因此只有 r <= ln(amplitude/((elapsed+1)·epsilon)) 的圆环内需要计算；density 不为正时外半径为无穷大。
+	 * 位移对时间的导数不超过 amplitude·exp(-r)/(elapsed+1)·(√2·|frequency| + 1/(elapsed+1))，按同样方式计入
+	 */
+	bool clickRippleAnnulus(const ClickRipple& ripple, float epsilon, Annulus& annulus, float velocityInterval = 0.0f);
+
+	/**
+	 * @brief 清零区间内的位移
+	 * @param frame 帧数据（使用 offsetX/offsetY，提供了 velocityX/velocityY 时同时清零速度）
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 */
+	void resetDisplacement(const Frame& frame, size_t begin, size_t end);
+
+	/**
+	 * @brief 累加直线波纹位移
+	 * @param isa 指令集路径
+	 * @param frame 帧数据
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details frame 中提供了可分离求值表时使用查表路径，否则逐顶点计算三角函数
+	 */
+	void accumulateWaves(Isa isa, const Frame& frame, size_t begin, size_t end);
+
+	/**
+	 * @brief 累加固定波纹位移
+	 * @param isa 指令集路径
+	 * @param frame 帧数据
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details frame 中提供了几何缓存时直接读取距离和方向，否则逐顶点计算；
+	 * 同时提供了增量相量时把相量旋转到本帧后直接使用，不计算三角函数
+	 */
+	void accumulateFixedRipples(Isa isa, const Frame& frame, size_t begin, size_t end);
+
+	/**
+	 * @brief 累加点击波纹位移
+	 * @param isa 指令集路径
+	 * @param frame 帧数据
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details clickRippleEpsilon 大于0且网格规则时，每个波纹只访问与其有效圆环相交的行和列区间，
+	 * 被跳过的顶点上该波纹的位移不超过 clickRippleEpsilon
+	 */
+	void accumulateClickRipples(Isa isa, const Frame& frame, size_t begin, size_t end);
+
+	/**
+	 * @brief 推进高度场一步
+	 * @param step 高度场数据
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 只写区间内的顶点，只读 current，不同区间可以并行处理
+	 */
+	void stepHeightField(const HeightFieldStep& step, size_t begin, size_t end);
+
+	/**
+	 * @brief 累加高度场位移
+	 * @param frame 帧数据（使用 originX/originY/columns/rows/heightField）
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 位移为高度的负梯度（中心差分，边缘单侧差分），波峰处顶点向外推开；
+	 * frame 提供了 velocityX/velocityY 时由相邻两步高度场的梯度之差求出速度
+	 */
+	void accumulateHeightField(const Frame& frame, size_t begin, size_t end);
+
+	/**
+	 * @brief 计算区间内的完整位移
+	 * @param isa 指令集路径
+	 * @param frame 帧数据
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 先由 resetDisplacement 清零，再依次累加直线波纹、固定波纹、点击波纹和高度场；
+	 * frame 提供了 velocityX/velocityY 时在同一遍计算中求出位移对时间的解析导数
+	 */
+	void displace(Isa isa, const Frame& frame, size_t begin, size_t end);
+
+	/**
+	 * @brief 应用边界约束
+	 * @param frame 帧数据（使用 originX/originY/offsetX/offsetY/columns/rows，不规则布局使用 boundaryVertices/boundarySides）
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 修正偏移使边缘顶点不向绘制区域内部移动：首列、首行不超过0，末列、末行不小于原始位置。
+	 * 与原实现一致，第二行的首个顶点也按首行处理；被约束的分量不再随波纹运动，其速度同时清零。
+	 * 只访问区间内的边缘顶点，内部顶点不做任何判断；不规则布局在边缘顶点列表中二分查找区间的起点
+	 */
+	void applyBoundary(const Frame& frame, size_t begin, size_t end);
+
+	/**
+	 * @brief 计算顶点新位置和透明度
+	 * @param frame 帧数据（使用 originX/originY/offsetX/offsetY/positionX/positionY/alpha/light）
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 由新旧位置之差计算透明度：位移超过 minDistance 时按位移方向与光照角度的夹角增减，
+	 * 每帧变化不超过0.1并限制在 [minAlpha, 1]，随后把新位置写回 positionX/positionY。
+	 * frame 提供了 velocityX/velocityY 时改用解析光照：以速度乘以 velocityInterval 代替新旧位置之差，
+	 * 夹角余弦由与光照方向的点积求出，不读取上一帧的位置和透明度，结果与帧率无关。
+	 * 帧间差分光照在 Fast 精度下同样用点积代替 cos(atan2(-dy, dx) - angle)。
+	 * 速度数组可以与 positionX/positionY 是同一块内存，每个顶点先读速度再写位置
+	 */
+	void applyLighting(const Frame& frame, size_t begin, size_t end);
+
+	/**
+	 * @brief 完成区间内的一帧更新
+	 * @param isa 指令集路径
+	 * @param frame 帧数据
+	 * @param begin 起始顶点下标
+	 * @param end 结束顶点下标（不含）
+	 * @details 依次执行 displace、applyBoundary 和 applyLighting
+	 */
+	void update(Isa isa, const Frame& frame, size_t begin, size_t end);
+}
@@ -0,0 +1,103 @@
+﻿#include "WaterKernel.h"
+
+#if defined(WATER_KERNEL_X86)
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+// 只开启AVX2而不开启FMA，保证与SSE2路径的运算结果逐位一致
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include "WaterKernelSimd.h"
+
+namespace
+{
+	/**
+	 * @struct Avx2Traits
+	 * @brief AVX2 8路向量操作
+	 */
+	struct Avx2Traits
+	{
+		using Float = __m256;
+		using Int = __m256i;
+		using Mask = __m256;
+		static constexpr size_t width = 8;
+
+		static Float load(const float* p) { return _mm256_loadu_ps(p); }
+		static void store(float* p, Float v) { _mm256_storeu_ps(p, v); }
+		static Float set(float v) { return _mm256_set1_ps(v); }
+		static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+		static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+		static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+		static Float div(Float a, Float b) { return _mm256_div_ps(a, b); }
+		static Float sqrt(Float a) { return _mm256_sqrt_ps(a); }
+		static Float min(Float a, Float b) { return _mm256_min_ps(a, b); }
+		static Float max(Float a, Float b) { return _mm256_max_ps(a, b); }
+		static Float abs(Float a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+		static Int roundToInt(Float a) { return _mm256_cvtps_epi32(a); }
+		static Float toFloat(Int a) { return _mm256_cvtepi32_ps(a); }
+		static Int intAdd(Int a, int b) { return _mm256_add_epi32(a, _mm256_set1_epi32(b)); }
+		static Int intAnd(Int a, int b) { return _mm256_and_si256(a, _mm256_set1_epi32(b)); }
+		static Int intXor(Int a, int b) { return _mm256_xor_si256(a, _mm256_set1_epi32(b)); }
+		template <int n> static Int intShl(Int a) { return _mm256_slli_epi32(a, n); }
+		static Float xorBits(Float a, Int b) { return _mm256_xor_ps(a, _mm256_castsi256_ps(b)); }
+		static Float fromBits(Int a) { return _mm256_castsi256_ps(a); }
+		static Mask greater(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+		static Float select(Mask m, Float a, Float b) { return _mm256_blendv_ps(b, a, m); }
+	};
+}
+
+namespace WaterKernel
+{
+	namespace Avx2
+	{
+		void accumulateWaves(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<Avx2Traits>::waves(frame, begin, end);
+		}
+
+		void accumulateSeparableWaves(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<Avx2Traits>::separableWaves(frame, begin, end);
+		}
+
+		void accumulateFixedRipples(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<Avx2Traits>::fixedRipples(frame, begin, end);
+		}
+
+		void accumulateCachedFixedRipples(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<Avx2Traits>::cachedFixedRipples(frame, begin, end);
+		}
+
+		void accumulatePhasorFixedRipples(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<Avx2Traits>::phasorFixedRipples(frame, begin, end);
+		}
+
+		void accumulateClickRipples(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<Avx2Traits>::clickRipples(frame, begin, end);
+		}
+
+		void accumulateClickRippleSpan(const Frame& frame, const ClickRipple& ripple, size_t begin, size_t end)
+		{
+			SimdKernels<Avx2Traits>::clickRippleSpan(frame, ripple, begin, end);
+		}
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
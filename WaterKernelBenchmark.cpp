@@ -0,0 +1,775 @@
+﻿/**
+ * @file WaterKernelBenchmark.cpp
+ * @brief WaterKernel 各阶段的无窗口基准测试
+ * @details 不依赖SDL，直接在SoA数组上分别计时直线波纹、固定波纹、点击波纹、边界约束和光照阶段，
+ * 波纹参数与 WaterEffect::applyPresetParams 的预设一致，绘制区域与示例程序相同（1600×900）。
+ * 每个配置先预热，再逐帧计时，结果以CSV（默认）或JSON输出到标准输出。
+ * Scalar 路径分别以 Precise 和 Fast 精度计时，SIMD路径只有 Fast 精度。
+ *
+ * 构建（Linux/macOS）：
+ *   g++ -O2 -std=c++17 -o WaterKernelBenchmark WaterKernelBenchmark.cpp WaterKernel.cpp WaterKernelPortable.cpp WaterKernelSSE2.cpp WaterKernelAVX2.cpp
+ *
+ * 用法：
+ *   WaterKernelBenchmark [--format csv|json] [--grids 50,100,200,400,800] [--ripples 0,1,4,16,64,256]
+ *                        [--isa scalar,sse2,avx2] [--frames 30] [--waves 2] [--mode timing|accuracy]
+ *
+ * 计时阶段：
+ * - waves / waves_direct：直线波纹（可分离求值，含每帧建表）/ 逐顶点直接求值
+ * - fixed_ripples / fixed_ripples_direct：固定波纹（径向几何缓存）/ 逐顶点直接求值
+ * - click_ripples / click_ripples_unculled：点击波纹（按 0.01 像素阈值裁剪）/ 不裁剪
+ * - boundary：边界约束
+ * - lighting：透明度计算
+ * - update / update_analytic：完整一帧（位移、边界约束和透明度），分别使用帧间差分光照和解析光照；
+ *   与 WaterField 相同，只有 Fast 精度使用可分离求值表
+ *
+ * 精度模式（--mode accuracy）：不计时，在 1~10000 秒内按对数间隔取样（覆盖预设参数下点击波纹的整个生命周期
+ * 和相位绝对值直到约 8e4 弧度的范围），每个取样时刻从相同的上一帧状态出发，比较各路径 Fast 精度（含可分离求值表）与
+ * Scalar 路径 Precise 精度（逐顶点直接求值）的完整一帧结果，输出顶点位置和透明度的最大差值；
+ * 超出 WaterKernel::kTolerance / kAlphaTolerance（Fast 精度使用可分离求值表，两者都加上随时间增大的 WaterKernel::waveTableTolerance，
+ * 透明度按 2/decay 倍）时返回值为1，约束状态不同的边缘顶点不比较透明度。此模式下网格和波纹数量默认为 50,200 和 0,4,16
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "WaterKernel.h"
+
+namespace
+{
+	constexpr float kPi = 3.14159265358979323846f;
+	constexpr int kCanvasWidth = 1600;
+	constexpr int kCanvasHeight = 900;
+	constexpr float kClickRippleLifeTime = 5.0f;
+	constexpr float kClickRippleEpsilon = 0.01f;
+	constexpr int kWarmupFrames = 3;
+	constexpr int kAccuracySamples = 64;
+
+	/**
+	 * @struct Options
+	 * @brief 命令行参数
+	 */
+	struct Options
+	{
+		bool json = false;
+		std::vector<int> grids = { 50, 100, 200, 400, 800 };
+		std::vector<int> ripples = { 0, 1, 4, 16, 64, 256 };
+		std::vector<WaterKernel::Isa> isas;
+		int frames = 30;
+		int waves = 2;
+		bool accuracy = false;
+		bool gridsSet = false;
+		bool ripplesSet = false;
+	};
+
+	/**
+	 * @struct Result
+	 * @brief 单个阶段的计时结果（微秒/帧）
+	 */
+	struct Result
+	{
+		WaterKernel::Isa isa = WaterKernel::Isa::Scalar;
+		WaterKernel::Precision precision = WaterKernel::Precision::Fast;
+		int grid = 0;
+		size_t vertices = 0;
+		int ripples = 0;
+		const char* stage = "";
+		double mean = 0.0;
+		double median = 0.0;
+		double min = 0.0;
+	};
+
+	/**
+	 * @brief 解析逗号分隔的整数列表
+	 * @param text 输入文本
+	 * @param values 输出
+	 * @return 格式正确返回true
+	 */
+	bool parseList(const char* text, std::vector<int>& values)
+	{
+		values.clear();
+		std::string item;
+		for (const char* p = text;; p++)
+		{
+			if (*p == ',' || *p == '\0')
+			{
+				char* end = nullptr;
+				long value = std::strtol(item.c_str(), &end, 10);
+				if (item.empty() || *end != '\0' || value < 0)
+				{
+					return false;
+				}
+				values.push_back(static_cast<int>(value));
+				item.clear();
+				if (*p == '\0')
+				{
+					break;
+				}
+			}
+			else
+			{
+				item += *p;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief 解析逗号分隔的指令集列表
+	 * @param text 输入文本
+	 * @param isas 输出（当前CPU不支持的路径会被忽略）
+	 * @return 格式正确返回true
+	 */
+	bool parseIsaList(const char* text, std::vector<WaterKernel::Isa>& isas)
+	{
+		isas.clear();
+		std::string list = std::string(text) + ",";
+		size_t start = 0;
+		for (size_t comma = list.find(','); comma != std::string::npos; start = comma + 1, comma = list.find(',', start))
+		{
+			std::string name = list.substr(start, comma - start);
+			bool found = false;
+			for (WaterKernel::Isa isa : { WaterKernel::Isa::Scalar, WaterKernel::Isa::SSE2, WaterKernel::Isa::AVX2 })
+			{
+				if (name == WaterKernel::isaName(isa))
+				{
+					found = true;
+					if (WaterKernel::isIsaSupported(isa))
+					{
+						isas.push_back(isa);
+					}
+					else
+					{
+						std::fprintf(stderr, "skipping %s: not supported by this CPU\n", name.c_str());
+					}
+				}
+			}
+			if (!found)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief 解析命令行参数
+	 * @param argc 参数数量
+	 * @param argv 参数数组
+	 * @param options 输出
+	 * @return 参数正确返回true
+	 */
+	bool parseOptions(int argc, char* argv[], Options& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const char* arg = argv[i];
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+			if (value == nullptr)
+			{
+				return false;
+			}
+			i++;
+			std::vector<int> list;
+			if (std::strcmp(arg, "--format") == 0)
+			{
+				if (std::strcmp(value, "json") != 0 && std::strcmp(value, "csv") != 0)
+				{
+					return false;
+				}
+				options.json = std::strcmp(value, "json") == 0;
+			}
+			else if (std::strcmp(arg, "--grids") == 0)
+			{
+				if (!parseList(value, options.grids) || std::count(options.grids.begin(), options.grids.end(), 0) > 0)
+				{
+					return false;
+				}
+				options.gridsSet = true;
+			}
+			else if (std::strcmp(arg, "--ripples") == 0)
+			{
+				if (!parseList(value, options.ripples))
+				{
+					return false;
+				}
+				options.ripplesSet = true;
+			}
+			else if (std::strcmp(arg, "--mode") == 0)
+			{
+				if (std::strcmp(value, "accuracy") != 0 && std::strcmp(value, "timing") != 0)
+				{
+					return false;
+				}
+				options.accuracy = std::strcmp(value, "accuracy") == 0;
+			}
+			else if (std::strcmp(arg, "--isa") == 0)
+			{
+				if (!parseIsaList(value, options.isas))
+				{
+					return false;
+				}
+			}
+			else if (std::strcmp(arg, "--frames") == 0 || std::strcmp(arg, "--waves") == 0)
+			{
+				if (!parseList(value, list) || list.size() != 1)
+				{
+					return false;
+				}
+				if (std::strcmp(arg, "--frames") == 0)
+				{
+					options.frames = list[0];
+				}
+				else
+				{
+					options.waves = list[0];
+				}
+			}
+			else
+			{
+				return false;
+			}
+		}
+		if (options.accuracy)
+		{
+			if (!options.gridsSet)
+			{
+				options.grids = { 50, 200 };
+			}
+			if (!options.ripplesSet)
+			{
+				options.ripples = { 0, 4, 16 };
+			}
+		}
+		if (options.isas.empty())
+		{
+			for (WaterKernel::Isa isa : { WaterKernel::Isa::Scalar, WaterKernel::Isa::SSE2, WaterKernel::Isa::AVX2 })
+			{
+				if (WaterKernel::isIsaSupported(isa))
+				{
+					options.isas.push_back(isa);
+				}
+			}
+		}
+		return options.frames > 0;
+	}
+
+	/**
+	 * @class Scene
+	 * @brief 单个网格尺寸和波纹数量下的内核输入
+	 * @details 顶点布局与 WaterEffect::initGrid 相同，波纹中心由固定种子的线性同余序列生成，结果可复现
+	 */
+	class Scene
+	{
+	public:
+		Scene(int gridSize, int rippleCount, int waveCount)
+		{
+			float cellW = static_cast<float>(kCanvasWidth) / gridSize;
+			float cellH = static_cast<float>(kCanvasHeight) / gridSize;
+			float rowY = 0.0f;
+			for (int y = 0; y <= gridSize; ++y)
+			{
+				if (y == gridSize)
+				{
+					rowY = static_cast<float>(kCanvasHeight);
+				}
+				float columnX = 0.0f;
+				for (int x = 0; x <= gridSize; ++x)
+				{
+					if (x == gridSize)
+					{
+						columnX = static_cast<float>(kCanvasWidth);
+					}
+					_originX.push_back(columnX);
+					_originY.push_back(rowY);
+					columnX += cellW;
+				}
+				rowY += cellH;
+			}
+			size_t count = _originX.size();
+			_offsetX.assign(count, 0.0f);
+			_offsetY.assign(count, 0.0f);
+			_positionX = _originX;
+			_positionY = _originY;
+			_alpha.assign(count, 0.9f);
+
+			for (int i = 0; i < waveCount; i++)
+			{
+				float angle = (i % 2 == 0 ? 5.0f : 7.0f) * kPi / 6.0f + 0.1f * (i / 2);
+				WaterKernel::Wave wave;
+				wave.A = std::cos(angle);
+				wave.B = -std::sin(angle);
+				wave.amplitude = i % 2 == 0 ? 5.0f : 8.0f;
+				wave.frequency = i % 2 == 0 ? 8.0f : 3.0f;
+				wave.density = i % 2 == 0 ? 0.02f : 0.01f;
+				wave.phi = i % 2 == 0 ? 1.0f : 0.0f;
+				_waves.push_back(wave);
+			}
+
+			for (int i = 0; i < rippleCount; i++)
+			{
+				WaterKernel::Ripple ripple;
+				ripple.x = _random() * kCanvasWidth;
+				ripple.y = _random() * kCanvasHeight;
+				ripple.amplitude = 15.0f;
+				ripple.frequency = 5.0f;
+				ripple.density = 0.015f;
+				_fixedRipples.push_back(ripple);
+
+				WaterKernel::ClickRipple click;
+				click.x = _random() * kCanvasWidth;
+				click.y = _random() * kCanvasHeight;
+				click.amplitude = 30.0f;
+				click.frequency = 10.0f;
+				click.density = 0.02f;
+				_clickRipples.push_back(click);
+				_clickRippleStart.push_back(_random() * kClickRippleLifeTime);
+			}
+
+			_fixedRipplePhase.resize(count * _fixedRipples.size());
+			_fixedRippleDirX.resize(count * _fixedRipples.size());
+			_fixedRippleDirY.resize(count * _fixedRipples.size());
+			for (size_t r = 0; r < _fixedRipples.size(); r++)
+			{
+				WaterKernel::buildRippleCache(_originX.data(), _originY.data(), count, _fixedRipples[r], _fixedRipplePhase.data() + r * count, _fixedRippleDirX.data() + r * count, _fixedRippleDirY.data() + r * count);
+			}
+
+			_waveColumnSin.resize(_waves.size() * (gridSize + 1));
+			_waveColumnCos.resize(_waves.size() * (gridSize + 1));
+			_waveRowSin.resize(_waves.size() * (gridSize + 1));
+			_waveRowCos.resize(_waves.size() * (gridSize + 1));
+
+			_frame.originX = _originX.data();
+			_frame.originY = _originY.data();
+			_frame.offsetX = _offsetX.data();
+			_frame.offsetY = _offsetY.data();
+			_frame.waves = _waves.data();
+			_frame.waveCount = _waves.size();
+			_frame.fixedRipples = _fixedRipples.data();
+			_frame.fixedRippleCount = _fixedRipples.size();
+			_frame.clickRipples = _clickRipples.data();
+			_frame.clickRippleCount = _clickRipples.size();
+			_frame.columns = gridSize + 1;
+			_frame.rows = gridSize + 1;
+			_frame.vertexCount = count;
+			_frame.positionX = _positionX.data();
+			_frame.positionY = _positionY.data();
+			_frame.alpha = _alpha.data();
+			_frame.light.defaultAlpha = 0.9f;
+			_frame.light.minAlpha = 0.85f;
+			_frame.light.decay = 10.0f;
+			_frame.light.angle = 5.0f * kPi / 4.0f;
+		}
+
+		/**
+		 * @brief 推进到指定时间并清零偏移
+		 * @param time 当前时间（秒）
+		 * @details 点击波纹按各自的起始时间在生命周期内循环，使活跃波纹数量保持不变
+		 */
+		void beginFrame(float time)
+		{
+			_frame.time = time;
+			for (size_t i = 0; i < _clickRipples.size(); i++)
+			{
+				_clickRipples[i].elapsed = std::fmod(time + _clickRippleStart[i], kClickRippleLifeTime);
+			}
+			std::fill(_offsetX.begin(), _offsetX.end(), 0.0f);
+			std::fill(_offsetY.begin(), _offsetY.end(), 0.0f);
+		}
+
+		/**
+		 * @brief 执行一个阶段
+		 * @param isa 指令集路径
+		 * @param precision 精度档位
+		 * @param stage 阶段名称
+		 */
+		void runStage(WaterKernel::Isa isa, WaterKernel::Precision precision, const std::string& stage)
+		{
+			WaterKernel::Frame frame = _frame;
+			frame.precision = precision;
+			size_t count = frame.vertexCount;
+			if (stage == "waves")
+			{
+				frame.waveColumnSin = _waveColumnSin.data();
+				frame.waveColumnCos = _waveColumnCos.data();
+				frame.waveRowSin = _waveRowSin.data();
+				frame.waveRowCos = _waveRowCos.data();
+				WaterKernel::buildWaveTables(frame, _waveColumnSin.data(), _waveColumnCos.data(), _waveRowSin.data(), _waveRowCos.data());
+				WaterKernel::accumulateWaves(isa, frame, 0, count);
+			}
+			else if (stage == "waves_direct")
+			{
+				WaterKernel::accumulateWaves(isa, frame, 0, count);
+			}
+			else if (stage == "fixed_ripples")
+			{
+				frame.fixedRipplePhase = _fixedRipplePhase.data();
+				frame.fixedRippleDirX = _fixedRippleDirX.data();
+				frame.fixedRippleDirY = _fixedRippleDirY.data();
+				WaterKernel::accumulateFixedRipples(isa, frame, 0, count);
+			}
+			else if (stage == "fixed_ripples_direct")
+			{
+				WaterKernel::accumulateFixedRipples(isa, frame, 0, count);
+			}
+			else if (stage == "click_ripples")
+			{
+				frame.clickRippleEpsilon = kClickRippleEpsilon;
+				WaterKernel::accumulateClickRipples(isa, frame, 0, count);
+			}
+			else if (stage == "click_ripples_unculled")
+			{
+				WaterKernel::accumulateClickRipples(isa, frame, 0, count);
+			}
+			else if (stage == "boundary")
+			{
+				WaterKernel::applyBoundary(frame, 0, count);
+			}
+			else if (stage == "lighting")
+			{
+				WaterKernel::applyLighting(frame, 0, count);
+			}
+			else if (stage == "update" || stage == "update_analytic")
+			{
+				// 与 WaterField 相同，Precise 精度下逐顶点计算直线波纹，精度模式因此以原公式为参照
+				if (precision == WaterKernel::Precision::Fast)
+				{
+					frame.waveColumnSin = _waveColumnSin.data();
+					frame.waveColumnCos = _waveColumnCos.data();
+					frame.waveRowSin = _waveRowSin.data();
+					frame.waveRowCos = _waveRowCos.data();
+					WaterKernel::buildWaveTables(frame, _waveColumnSin.data(), _waveColumnCos.data(), _waveRowSin.data(), _waveRowCos.data());
+				}
+				frame.fixedRipplePhase = _fixedRipplePhase.data();
+				frame.fixedRippleDirX = _fixedRippleDirX.data();
+				frame.fixedRippleDirY = _fixedRippleDirY.data();
+				frame.clickRippleEpsilon = kClickRippleEpsilon;
+				if (stage == "update_analytic")
+				{
+					frame.velocityX = _positionX.data();
+					frame.velocityY = _positionY.data();
+					frame.velocityInterval = 1.0f / 60.0f;
+				}
+				_waveTableTolerance = frame.waveColumnSin != nullptr ? WaterKernel::waveTableTolerance(frame) : 0.0f;
+				WaterKernel::update(isa, frame, 0, count);
+			}
+		}
+
+		/**
+		 * @brief 获取顶点数量
+		 * @return 顶点数量
+		 */
+		size_t vertexCount() const
+		{
+			return _originX.size();
+		}
+
+		/**
+		 * @brief 复制另一个场景的顶点位置和透明度
+		 * @param other 网格尺寸相同的场景
+		 */
+		void copyState(const Scene& other)
+		{
+			_positionX = other._positionX;
+			_positionY = other._positionY;
+			_alpha = other._alpha;
+		}
+
+		/**
+		 * @brief 与另一个场景比较顶点位置和透明度
+		 * @param other 网格尺寸相同的场景
+		 * @param positionError 输出：位置的最大差值（像素）
+		 * @param alphaError 输出：透明度的最大差值
+		 * @details 边界约束把被约束分量的速度清零，透明度在约束生效的位置不连续；
+		 * 两个场景中约束状态不同的边缘顶点只比较位置，不比较透明度
+		 */
+		void compare(const Scene& other, double& positionError, double& alphaError) const
+		{
+			for (size_t i = 0; i < _positionX.size(); i++)
+			{
+				positionError = std::max(positionError, static_cast<double>(std::fabs(_positionX[i] - other._positionX[i])));
+				positionError = std::max(positionError, static_cast<double>(std::fabs(_positionY[i] - other._positionY[i])));
+				if (_clamped(i) == other._clamped(i))
+				{
+					alphaError = std::max(alphaError, static_cast<double>(std::fabs(_alpha[i] - other._alpha[i])));
+				}
+			}
+		}
+
+		/**
+		 * @brief 获取上一次 runStage 相对 Precise 精度的容差
+		 * @param position 输出：位移容差（像素）
+		 * @param alpha 输出：透明度容差
+		 * @details 使用了可分离求值表时加上 WaterKernel::waveTableTolerance，透明度随位移差的变化不超过 2/decay 倍
+		 */
+		void tolerance(double& position, double& alpha) const
+		{
+			position = WaterKernel::kTolerance + _waveTableTolerance;
+			alpha = WaterKernel::kAlphaTolerance + 2.0 * _waveTableTolerance / _frame.light.decay;
+		}
+
+	private:
+		WaterKernel::Frame _frame;
+		std::vector<float> _originX, _originY, _offsetX, _offsetY;
+		std::vector<float> _positionX, _positionY, _alpha;
+		std::vector<WaterKernel::Wave> _waves;
+		std::vector<WaterKernel::Ripple> _fixedRipples;
+		std::vector<WaterKernel::ClickRipple> _clickRipples;
+		std::vector<float> _clickRippleStart;
+		std::vector<float> _fixedRipplePhase, _fixedRippleDirX, _fixedRippleDirY;
+		std::vector<float> _waveColumnSin, _waveColumnCos, _waveRowSin, _waveRowCos;
+		float _waveTableTolerance = 0.0f;
+		unsigned int _seed = 12345u;
+
+		/**
+		 * @brief 获取顶点被边界约束固定的分量
+		 * @param i 顶点下标
+		 * @return 位0为X分量，位1为Y分量；约束生效时位置恰好为0（首列、首行）或原始位置（末列、末行）
+		 */
+		int _clamped(size_t i) const
+		{
+			size_t columns = _frame.columns;
+			size_t column = i % columns;
+			int clamped = 0;
+			if ((column == 0 && _positionX[i] == 0.0f) || (column == columns - 1 && _positionX[i] == _originX[i]))
+			{
+				clamped |= 1;
+			}
+			if ((i <= columns && _positionY[i] == 0.0f) || (i >= columns * (_frame.rows - 1) && _positionY[i] == _originY[i]))
+			{
+				clamped |= 2;
+			}
+			return clamped;
+		}
+
+		/**
+		 * @brief 生成 [0, 1) 内的伪随机数
+		 * @return 伪随机数
+		 */
+		float _random()
+		{
+			_seed = _seed * 1664525u + 1013904223u;
+			return static_cast<float>(_seed >> 8) / 16777216.0f;
+		}
+	};
+
+	/**
+	 * @brief 对一个阶段计时
+	 * @param scene 内核输入
+	 * @param isa 指令集路径
+	 * @param precision 精度档位
+	 * @param stage 阶段名称
+	 * @param frames 计时帧数
+	 * @param result 输出：mean/median/min
+	 * @details 每帧前清零偏移（不计时），时间按60帧/秒推进；
+	 * 边界约束和光照阶段在同一帧先执行完整位移，使输入与实际运行时一致
+	 */
+	void measure(Scene& scene, WaterKernel::Isa isa, WaterKernel::Precision precision, const std::string& stage, int frames, Result& result)
+	{
+		bool needsDisplacement = stage == "boundary" || stage == "lighting";
+		std::vector<double> samples;
+		for (int f = -kWarmupFrames; f < frames; f++)
+		{
+			scene.beginFrame(1.0f + f / 60.0f);
+			if (needsDisplacement)
+			{
+				scene.runStage(isa, precision, "waves");
+				scene.runStage(isa, precision, "fixed_ripples");
+				scene.runStage(isa, precision, "click_ripples");
+				if (stage == "lighting")
+				{
+					scene.runStage(isa, precision, "boundary");
+				}
+			}
+			auto start = std::chrono::steady_clock::now();
+			scene.runStage(isa, precision, stage);
+			auto stop = std::chrono::steady_clock::now();
+			if (f >= 0)
+			{
+				samples.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+			}
+		}
+		std::sort(samples.begin(), samples.end());
+		double sum = 0.0;
+		for (double sample : samples)
+		{
+			sum += sample;
+		}
+		result.mean = sum / samples.size();
+		result.median = samples[samples.size() / 2];
+		result.min = samples.front();
+	}
+
+	/**
+	 * @brief 比较各路径 Fast 精度与 Scalar 路径 Precise 精度的完整一帧结果
+	 * @param options 命令行参数
+	 * @return 全部误差都在容差内返回true
+	 */
+	bool runAccuracy(const Options& options)
+	{
+		const char* stages[] = { "update", "update_analytic" };
+		bool passed = true;
+		if (options.json)
+		{
+			std::printf("{\n  \"tolerance\": %g,\n  \"alphaTolerance\": %g,\n  \"results\": [", WaterKernel::kTolerance, WaterKernel::kAlphaTolerance);
+		}
+		else
+		{
+			std::printf("isa,grid,vertices,ripples,stage,max_position_error,max_alpha_error,max_position_tolerance,max_alpha_tolerance,passed\n");
+		}
+		bool first = true;
+		for (int grid : options.grids)
+		{
+			for (int ripples : options.ripples)
+			{
+				for (WaterKernel::Isa isa : options.isas)
+				{
+					for (const char* stage : stages)
+					{
+						Scene reference(grid, ripples, options.waves);
+						Scene scene(grid, ripples, options.waves);
+						double positionError = 0.0;
+						double alphaError = 0.0;
+						double positionTolerance = 0.0;
+						double alphaTolerance = 0.0;
+						bool ok = true;
+						for (int sample = 0; sample < kAccuracySamples; sample++)
+						{
+							float time = std::pow(10.0f, 4.0f * sample / (kAccuracySamples - 1)) + 0.013f * sample;
+							scene.copyState(reference);
+							reference.beginFrame(time);
+							scene.beginFrame(time);
+							reference.runStage(WaterKernel::Isa::Scalar, WaterKernel::Precision::Precise, stage);
+							scene.runStage(isa, WaterKernel::Precision::Fast, stage);
+							// 可分离求值表的容差随时间增大，每个取样时刻分别判断
+							double samplePosition = 0.0;
+							double sampleAlpha = 0.0;
+							double allowedPosition = 0.0;
+							double allowedAlpha = 0.0;
+							scene.compare(reference, samplePosition, sampleAlpha);
+							scene.tolerance(allowedPosition, allowedAlpha);
+							ok = ok && samplePosition <= allowedPosition && sampleAlpha <= allowedAlpha;
+							positionError = std::max(positionError, samplePosition);
+							alphaError = std::max(alphaError, sampleAlpha);
+							positionTolerance = std::max(positionTolerance, allowedPosition);
+							alphaTolerance = std::max(alphaTolerance, allowedAlpha);
+						}
+						passed = passed && ok;
+						if (options.json)
+						{
+							std::printf("%s\n    { \"isa\": \"%s\", \"grid\": %d, \"vertices\": %zu, \"ripples\": %d, \"stage\": \"%s\", \"max_position_error\": %.3g, \"max_alpha_error\": %.3g, \"max_position_tolerance\": %.3g, \"max_alpha_tolerance\": %.3g, \"passed\": %s }",
+								first ? "" : ",", WaterKernel::isaName(isa), grid, scene.vertexCount(), ripples, stage, positionError, alphaError, positionTolerance, alphaTolerance, ok ? "true" : "false");
+						}
+						else
+						{
+							std::printf("%s,%d,%zu,%d,%s,%.3g,%.3g,%.3g,%.3g,%d\n",
+								WaterKernel::isaName(isa), grid, scene.vertexCount(), ripples, stage, positionError, alphaError, positionTolerance, alphaTolerance, ok ? 1 : 0);
+						}
+						first = false;
+						std::fflush(stdout);
+					}
+				}
+			}
+		}
+		if (options.json)
+		{
+			std::printf("\n  ]\n}\n");
+		}
+		return passed;
+	}
+
+	/**
+	 * @brief 输出用法说明
+	 */
+	void printUsage()
+	{
+		std::fprintf(stderr,
+			"usage: WaterKernelBenchmark [--format csv|json] [--grids 50,100,200,400,800] [--ripples 0,1,4,16,64,256]\n"
+			"                            [--isa scalar,sse2,avx2] [--frames 30] [--waves 2] [--mode timing|accuracy]\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printUsage();
+		return 1;
+	}
+	if (options.accuracy)
+	{
+		return runAccuracy(options) ? 0 : 1;
+	}
+
+	const char* stages[] = {
+		"waves", "waves_direct",
+		"fixed_ripples", "fixed_ripples_direct",
+		"click_ripples", "click_ripples_unculled",
+		"boundary", "lighting",
+		"update", "update_analytic",
+	};
+
+	if (options.json)
+	{
+		std::printf("{\n  \"detectedIsa\": \"%s\",\n  \"frames\": %d,\n  \"waves\": %d,\n  \"results\": [", WaterKernel::isaName(WaterKernel::detectIsa()), options.frames, options.waves);
+	}
+	else
+	{
+		std::printf("isa,precision,grid,vertices,ripples,stage,mean_us,median_us,min_us,median_ns_per_vertex\n");
+	}
+
+	bool first = true;
+	for (int grid : options.grids)
+	{
+		for (int ripples : options.ripples)
+		{
+			Scene scene(grid, ripples, options.waves);
+			for (WaterKernel::Isa isa : options.isas)
+			{
+				for (WaterKernel::Precision precision : { WaterKernel::Precision::Precise, WaterKernel::Precision::Fast })
+				{
+					// SIMD路径只有 Fast 精度
+					if (precision == WaterKernel::Precision::Precise && isa != WaterKernel::Isa::Scalar)
+					{
+						continue;
+					}
+					const char* precisionName = precision == WaterKernel::Precision::Precise ? "precise" : "fast";
+					for (const char* stage : stages)
+					{
+						Result result;
+						result.isa = isa;
+						result.precision = precision;
+						result.grid = grid;
+						result.vertices = scene.vertexCount();
+						result.ripples = ripples;
+						result.stage = stage;
+						measure(scene, isa, precision, stage, options.frames, result);
+						double perVertex = result.median * 1000.0 / result.vertices;
+						if (options.json)
+						{
+							std::printf("%s\n    { \"isa\": \"%s\", \"precision\": \"%s\", \"grid\": %d, \"vertices\": %zu, \"ripples\": %d, \"stage\": \"%s\", \"mean_us\": %.3f, \"median_us\": %.3f, \"min_us\": %.3f, \"median_ns_per_vertex\": %.4f }",
+								first ? "" : ",", WaterKernel::isaName(isa), precisionName, grid, result.vertices, ripples, stage, result.mean, result.median, result.min, perVertex);
+						}
+						else
+						{
+							std::printf("%s,%s,%d,%zu,%d,%s,%.3f,%.3f,%.3f,%.4f\n",
+								WaterKernel::isaName(isa), precisionName, grid, result.vertices, ripples, stage, result.mean, result.median, result.min, perVertex);
+						}
+						first = false;
+						std::fflush(stdout);
+					}
+				}
+			}
+		}
+	}
+
+	if (options.json)
+	{
+		std::printf("\n  ]\n}\n");
+	}
+	return 0;
+}
@@ -0,0 +1,42 @@
+﻿#include "WaterKernel.h"
+#include "WaterKernelSimd.h"
+
+/*
+ * Fast 精度的标量路径：用单通道的 ScalarPolyTraits 实例化SIMD内核模板，
+ * 与SIMD路径的运算序列和多项式完全相同，不依赖任何指令集，编译器可以自行向量化。
+ */
+namespace WaterKernel
+{
+	namespace Portable
+	{
+		void accumulateWaves(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<ScalarPolyTraits>::waves(frame, begin, end);
+		}
+
+		void accumulateFixedRipples(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<ScalarPolyTraits>::fixedRipples(frame, begin, end);
+		}
+
+		void accumulateCachedFixedRipples(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<ScalarPolyTraits>::cachedFixedRipples(frame, begin, end);
+		}
+
+		void accumulatePhasorFixedRipples(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<ScalarPolyTraits>::phasorFixedRipples(frame, begin, end);
+		}
+
+		void accumulateClickRipples(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<ScalarPolyTraits>::clickRipples(frame, begin, end);
+		}
+
+		void accumulateClickRippleSpan(const Frame& frame, const ClickRipple& ripple, size_t begin, size_t end)
+		{
+			SimdKernels<ScalarPolyTraits>::clickRippleSpan(frame, ripple, begin, end);
+		}
+	}
+}
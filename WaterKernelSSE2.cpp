@@ -0,0 +1,93 @@
+﻿#include "WaterKernel.h"
+
+#if defined(WATER_KERNEL_X86)
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <emmintrin.h>
+
+#if defined(__GNUC__) && !defined(__clang__) && !defined(__SSE2__)
+#pragma GCC target("sse2")
+#endif
+
+#include "WaterKernelSimd.h"
+
+namespace
+{
+	/**
+	 * @struct Sse2Traits
+	 * @brief SSE2 4路向量操作
+	 */
+	struct Sse2Traits
+	{
+		using Float = __m128;
+		using Int = __m128i;
+		using Mask = __m128;
+		static constexpr size_t width = 4;
+
+		static Float load(const float* p) { return _mm_loadu_ps(p); }
+		static void store(float* p, Float v) { _mm_storeu_ps(p, v); }
+		static Float set(float v) { return _mm_set1_ps(v); }
+		static Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+		static Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+		static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+		static Float div(Float a, Float b) { return _mm_div_ps(a, b); }
+		static Float sqrt(Float a) { return _mm_sqrt_ps(a); }
+		static Float min(Float a, Float b) { return _mm_min_ps(a, b); }
+		static Float max(Float a, Float b) { return _mm_max_ps(a, b); }
+		static Float abs(Float a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+		static Int roundToInt(Float a) { return _mm_cvtps_epi32(a); }
+		static Float toFloat(Int a) { return _mm_cvtepi32_ps(a); }
+		static Int intAdd(Int a, int b) { return _mm_add_epi32(a, _mm_set1_epi32(b)); }
+		static Int intAnd(Int a, int b) { return _mm_and_si128(a, _mm_set1_epi32(b)); }
+		static Int intXor(Int a, int b) { return _mm_xor_si128(a, _mm_set1_epi32(b)); }
+		template <int n> static Int intShl(Int a) { return _mm_slli_epi32(a, n); }
+		static Float xorBits(Float a, Int b) { return _mm_xor_ps(a, _mm_castsi128_ps(b)); }
+		static Float fromBits(Int a) { return _mm_castsi128_ps(a); }
+		static Mask greater(Float a, Float b) { return _mm_cmpgt_ps(a, b); }
+		static Float select(Mask m, Float a, Float b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+	};
+}
+
+namespace WaterKernel
+{
+	namespace Sse2
+	{
+		void accumulateWaves(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<Sse2Traits>::waves(frame, begin, end);
+		}
+
+		void accumulateSeparableWaves(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<Sse2Traits>::separableWaves(frame, begin, end);
+		}
+
+		void accumulateFixedRipples(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<Sse2Traits>::fixedRipples(frame, begin, end);
+		}
+
+		void accumulateCachedFixedRipples(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<Sse2Traits>::cachedFixedRipples(frame, begin, end);
+		}
+
+		void accumulatePhasorFixedRipples(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<Sse2Traits>::phasorFixedRipples(frame, begin, end);
+		}
+
+		void accumulateClickRipples(const Frame& frame, size_t begin, size_t end)
+		{
+			SimdKernels<Sse2Traits>::clickRipples(frame, begin, end);
+		}
+
+		void accumulateClickRippleSpan(const Frame& frame, const ClickRipple& ripple, size_t begin, size_t end)
+		{
+			SimdKernels<Sse2Traits>::clickRippleSpan(frame, ripple, begin, end);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,624 @@
+﻿#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "WaterKernel.h"
+
+/*
+ * SIMD内核的公共模板实现，只由 WaterKernelSSE2.cpp / WaterKernelAVX2.cpp / WaterKernelPortable.cpp 包含。
+ * 每个翻译单元以不同的目标指令集编译，因此全部内容放在匿名命名空间中，
+ * 避免链接器把AVX2编译出的同名实例合并到SSE2路径中。
+ */
+namespace
+{
+	/**
+	 * @struct ScalarPolyTraits
+	 * @brief 单通道的多项式路径
+	 * @details 与SIMD路径运算序列完全一致，用于处理区间尾部的顶点
+	 */
+	struct ScalarPolyTraits
+	{
+		using Float = float;
+		using Int = int32_t;
+		using Mask = bool;
+		static constexpr size_t width = 1;
+
+		static Float load(const float* p) { return *p; }
+		static void store(float* p, Float v) { *p = v; }
+		static Float set(float v) { return v; }
+		static Float add(Float a, Float b) { return a + b; }
+		static Float sub(Float a, Float b) { return a - b; }
+		static Float mul(Float a, Float b) { return a * b; }
+		static Float div(Float a, Float b) { return a / b; }
+		static Float sqrt(Float a) { return std::sqrt(a); }
+		static Float min(Float a, Float b) { return a < b ? a : b; }
+		static Float max(Float a, Float b) { return a > b ? a : b; }
+		static Float abs(Float a) { return std::fabs(a); }
+		static Int roundToInt(Float a) { return static_cast<Int>(std::lrint(a)); }
+		static Float toFloat(Int a) { return static_cast<Float>(a); }
+		static Int intAdd(Int a, int b) { return a + b; }
+		static Int intAnd(Int a, int b) { return a & b; }
+		static Int intXor(Int a, int b) { return a ^ b; }
+		template <int n> static Int intShl(Int a) { return static_cast<Int>(static_cast<uint32_t>(a) << n); }
+		static Float xorBits(Float a, Int b)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &a, sizeof(bits));
+			bits ^= static_cast<uint32_t>(b);
+			std::memcpy(&a, &bits, sizeof(bits));
+			return a;
+		}
+		static Float fromBits(Int a)
+		{
+			Float f;
+			std::memcpy(&f, &a, sizeof(f));
+			return f;
+		}
+		static Mask greater(Float a, Float b) { return a > b; }
+		static Float select(Mask m, Float a, Float b) { return m ? a : b; }
+	};
+
+	/**
+	 * @brief 多项式正弦
+	 * @details 按π做四段Cody-Waite规约后计算奇次多项式，|x| <= 1e5 时绝对误差约 5e-7
+	 */
+	template <class V>
+	inline typename V::Float polySin(typename V::Float d)
+	{
+		typename V::Int q = V::roundToInt(V::mul(d, V::set(0.318309886183790671538f)));
+		typename V::Float qf = V::toFloat(q);
+		d = V::add(d, V::mul(qf, V::set(-3.140625f)));
+		d = V::add(d, V::mul(qf, V::set(-0.0009670257568359375f)));
+		d = V::add(d, V::mul(qf, V::set(-6.2771141529083251953e-07f)));
+		d = V::add(d, V::mul(qf, V::set(-1.2154201256553420762e-10f)));
+
+		typename V::Float s = V::mul(d, d);
+		d = V::xorBits(d, V::template intShl<31>(V::intAnd(q, 1)));
+
+		typename V::Float u = V::set(2.6083159809786593541503e-06f);
+		u = V::add(V::mul(u, s), V::set(-0.0001981069071916863322258f));
+		u = V::add(V::mul(u, s), V::set(0.00833307858556509017944336f));
+		u = V::add(V::mul(u, s), V::set(-0.166666597127914428710938f));
+		return V::add(V::mul(s, V::mul(u, d)), d);
+	}
+
+	/**
+	 * @brief 多项式余弦
+	 * @details 规约到 x - q*π/2（q为奇数）后复用正弦多项式，误差与 polySin 相同
+	 */
+	template <class V>
+	inline typename V::Float polyCos(typename V::Float d)
+	{
+		typename V::Int q = V::roundToInt(V::sub(V::mul(d, V::set(0.318309886183790671538f)), V::set(0.5f)));
+		q = V::intAdd(V::template intShl<1>(q), 1);
+		typename V::Float qf = V::toFloat(q);
+		d = V::add(d, V::mul(qf, V::set(-3.140625f * 0.5f)));
+		d = V::add(d, V::mul(qf, V::set(-0.0009670257568359375f * 0.5f)));
+		d = V::add(d, V::mul(qf, V::set(-6.2771141529083251953e-07f * 0.5f)));
+		d = V::add(d, V::mul(qf, V::set(-1.2154201256553420762e-10f * 0.5f)));
+
+		typename V::Float s = V::mul(d, d);
+		d = V::xorBits(d, V::template intShl<30>(V::intXor(V::intAnd(q, 2), 2)));
+
+		typename V::Float u = V::set(2.6083159809786593541503e-06f);
+		u = V::add(V::mul(u, s), V::set(-0.0001981069071916863322258f));
+		u = V::add(V::mul(u, s), V::set(0.00833307858556509017944336f));
+		u = V::add(V::mul(u, s), V::set(-0.166666597127914428710938f));
+		return V::add(V::mul(s, V::mul(u, d)), d);
+	}
+
+	/**
+	 * @brief 多项式指数函数
+	 * @details 输入限制在 [-87, 88]，更小的输入返回约 1.6e-38（对位移贡献可忽略），相对误差约 2e-7
+	 */
+	template <class V>
+	inline typename V::Float polyExp(typename V::Float d)
+	{
+		d = V::min(V::max(d, V::set(-87.0f)), V::set(88.0f));
+		typename V::Int q = V::roundToInt(V::mul(d, V::set(1.442695040888963407359924681001892137f)));
+		typename V::Float qf = V::toFloat(q);
+		typename V::Float s = V::add(d, V::mul(qf, V::set(-0.693145751953125f)));
+		s = V::add(s, V::mul(qf, V::set(-1.428606765330187045e-06f)));
+
+		typename V::Float u = V::set(0.000198527617612853646278381f);
+		u = V::add(V::mul(u, s), V::set(0.00139304355252534151077271f));
+		u = V::add(V::mul(u, s), V::set(0.00833336077630519866943359f));
+		u = V::add(V::mul(u, s), V::set(0.0416664853692054748535156f));
+		u = V::add(V::mul(u, s), V::set(0.166666671633720397949219f));
+		u = V::add(V::mul(u, s), V::set(0.5f));
+		u = V::add(V::add(V::mul(V::mul(s, s), u), s), V::set(1.0f));
+
+		typename V::Float scale = V::fromBits(V::template intShl<23>(V::intAdd(q, 127)));
+		return V::mul(u, scale);
+	}
+
+	/**
+	 * @struct VelocityAccumulator
+	 * @brief V::width 个顶点的速度累加器
+	 * @details Enabled 在编译期确定：为false时不读写内存，各处理函数的导数计算在实例化时整体去除，
+	 * 顶点循环内没有是否累加速度的判断
+	 */
+	template <class V, bool Enabled>
+	struct VelocityAccumulator
+	{
+		static constexpr bool enabled = Enabled;
+		const WaterKernel::Frame& frame;
+		size_t i;
+		typename V::Float x;
+		typename V::Float y;
+
+		VelocityAccumulator(const WaterKernel::Frame& frame, size_t i)
+			: frame(frame), i(i), x(V::set(0.0f)), y(V::set(0.0f))
+		{
+			if (enabled)
+			{
+				x = V::load(frame.velocityX + i);
+				y = V::load(frame.velocityY + i);
+			}
+		}
+
+		void store()
+		{
+			if (enabled)
+			{
+				V::store(frame.velocityX + i, x);
+				V::store(frame.velocityY + i, y);
+			}
+		}
+	};
+
+	template <class V, bool Velocity>
+	inline void wavesAt(const WaterKernel::Frame& frame, size_t i)
+	{
+		typename V::Float x = V::load(frame.originX + i);
+		typename V::Float y = V::load(frame.originY + i);
+		typename V::Float ox = V::load(frame.offsetX + i);
+		typename V::Float oy = V::load(frame.offsetY + i);
+		VelocityAccumulator<V, Velocity> velocity(frame, i);
+		for (size_t w = 0; w < frame.waveCount; ++w)
+		{
+			const WaterKernel::Wave& wave = frame.waves[w];
+			typename V::Float A = V::set(wave.A);
+			typename V::Float B = V::set(wave.B);
+			typename V::Float distance = V::add(V::add(V::mul(A, x), V::mul(B, y)), V::set(wave.phi));
+			typename V::Float arg = V::sub(V::set(wave.frequency * frame.time), V::mul(V::set(wave.density), distance));
+			typename V::Float lineOffset = V::mul(V::set(wave.amplitude), polySin<V>(arg));
+			ox = V::add(ox, V::mul(lineOffset, A));
+			oy = V::add(oy, V::mul(lineOffset, B));
+			if (velocity.enabled)
+			{
+				typename V::Float lineVelocity = V::mul(V::set(wave.amplitude * wave.frequency * frame.velocityInterval), polyCos<V>(arg));
+				velocity.x = V::add(velocity.x, V::mul(lineVelocity, A));
+				velocity.y = V::add(velocity.y, V::mul(lineVelocity, B));
+			}
+		}
+		V::store(frame.offsetX + i, ox);
+		V::store(frame.offsetY + i, oy);
+		velocity.store();
+	}
+
+	/**
+	 * @brief 可分离求值：处理同一行内从 column 开始的 V::width 个顶点
+	 */
+	template <class V, bool Velocity>
+	inline void separableWavesAt(const WaterKernel::Frame& frame, size_t i, size_t row, size_t column)
+	{
+		typename V::Float ox = V::load(frame.offsetX + i);
+		typename V::Float oy = V::load(frame.offsetY + i);
+		VelocityAccumulator<V, Velocity> velocity(frame, i);
+		for (size_t w = 0; w < frame.waveCount; ++w)
+		{
+			typename V::Float columnSin = V::load(frame.waveColumnSin + w * frame.columns + column);
+			typename V::Float columnCos = V::load(frame.waveColumnCos + w * frame.columns + column);
+			typename V::Float rowSin = V::set(frame.waveRowSin[w * frame.rows + row]);
+			typename V::Float rowCos = V::set(frame.waveRowCos[w * frame.rows + row]);
+			typename V::Float lineOffset = V::add(V::mul(columnSin, rowCos), V::mul(columnCos, rowSin));
+			ox = V::add(ox, V::mul(lineOffset, V::set(frame.waves[w].A)));
+			oy = V::add(oy, V::mul(lineOffset, V::set(frame.waves[w].B)));
+			if (velocity.enabled)
+			{
+				// amplitude·cos(a+b) = amplitude·(cos a·cos b - sin a·sin b)
+				typename V::Float lineVelocity = V::sub(V::mul(columnCos, rowCos), V::mul(columnSin, rowSin));
+				lineVelocity = V::mul(lineVelocity, V::set(frame.waves[w].frequency * frame.velocityInterval));
+				velocity.x = V::add(velocity.x, V::mul(lineVelocity, V::set(frame.waves[w].A)));
+				velocity.y = V::add(velocity.y, V::mul(lineVelocity, V::set(frame.waves[w].B)));
+			}
+		}
+		V::store(frame.offsetX + i, ox);
+		V::store(frame.offsetY + i, oy);
+		velocity.store();
+	}
+
+	template <class V, bool Velocity>
+	inline void fixedRipplesAt(const WaterKernel::Frame& frame, size_t i)
+	{
+		typename V::Float x = V::load(frame.originX + i);
+		typename V::Float y = V::load(frame.originY + i);
+		typename V::Float ox = V::load(frame.offsetX + i);
+		typename V::Float oy = V::load(frame.offsetY + i);
+		const typename V::Float zero = V::set(0.0f);
+		const typename V::Float one = V::set(1.0f);
+		VelocityAccumulator<V, Velocity> velocity(frame, i);
+		for (size_t r = 0; r < frame.fixedRippleCount; ++r)
+		{
+			const WaterKernel::Ripple& ripple = frame.fixedRipples[r];
+			typename V::Float dx = V::sub(x, V::set(ripple.x));
+			typename V::Float dy = V::sub(y, V::set(ripple.y));
+			typename V::Float distance = V::sqrt(V::add(V::mul(dx, dx), V::mul(dy, dy)));
+			// 与 atan2(0, 0) = 0 保持一致：圆心处的方向取 (1, 0)
+			typename V::Mask valid = V::greater(distance, zero);
+			typename V::Float invDistance = V::div(one, V::select(valid, distance, one));
+			typename V::Float dirX = V::select(valid, V::mul(dx, invDistance), one);
+			typename V::Float dirY = V::select(valid, V::mul(dy, invDistance), zero);
+
+			typename V::Float arg = V::sub(V::set(ripple.frequency * frame.time), V::mul(V::set(ripple.density), distance));
+			typename V::Float value = V::mul(V::set(ripple.amplitude), polyCos<V>(arg));
+			ox = V::add(ox, V::mul(value, dirX));
+			oy = V::add(oy, V::mul(value, dirY));
+			if (velocity.enabled)
+			{
+				typename V::Float rippleVelocity = V::mul(V::set(-ripple.amplitude * ripple.frequency * frame.velocityInterval), polySin<V>(arg));
+				velocity.x = V::add(velocity.x, V::mul(rippleVelocity, dirX));
+				velocity.y = V::add(velocity.y, V::mul(rippleVelocity, dirY));
+			}
+		}
+		V::store(frame.offsetX + i, ox);
+		V::store(frame.offsetY + i, oy);
+		velocity.store();
+	}
+
+	template <class V, bool Velocity>
+	inline void cachedFixedRipplesAt(const WaterKernel::Frame& frame, size_t i)
+	{
+		typename V::Float ox = V::load(frame.offsetX + i);
+		typename V::Float oy = V::load(frame.offsetY + i);
+		VelocityAccumulator<V, Velocity> velocity(frame, i);
+		for (size_t r = 0; r < frame.fixedRippleCount; ++r)
+		{
+			const WaterKernel::Ripple& ripple = frame.fixedRipples[r];
+			size_t offset = r * frame.vertexCount + i;
+			typename V::Float arg = V::sub(V::set(ripple.frequency * frame.time), V::load(frame.fixedRipplePhase + offset));
+			typename V::Float value = V::mul(V::set(ripple.amplitude), polyCos<V>(arg));
+			ox = V::add(ox, V::mul(value, V::load(frame.fixedRippleDirX + offset)));
+			oy = V::add(oy, V::mul(value, V::load(frame.fixedRippleDirY + offset)));
+			if (velocity.enabled)
+			{
+				typename V::Float rippleVelocity = V::mul(V::set(-ripple.amplitude * ripple.frequency * frame.velocityInterval), polySin<V>(arg));
+				velocity.x = V::add(velocity.x, V::mul(rippleVelocity, V::load(frame.fixedRippleDirX + offset)));
+				velocity.y = V::add(velocity.y, V::mul(rippleVelocity, V::load(frame.fixedRippleDirY + offset)));
+			}
+		}
+		V::store(frame.offsetX + i, ox);
+		V::store(frame.offsetY + i, oy);
+		velocity.store();
+	}
+
+	/**
+	 * @brief 增量相量：把相量旋转到本帧后累加位移，Renormalize 为true时同时把相量的模修正回1
+	 */
+	template <class V, bool Velocity, bool Renormalize>
+	inline void phasorFixedRipplesAt(const WaterKernel::Frame& frame, size_t i)
+	{
+		typename V::Float ox = V::load(frame.offsetX + i);
+		typename V::Float oy = V::load(frame.offsetY + i);
+		VelocityAccumulator<V, Velocity> velocity(frame, i);
+		for (size_t r = 0; r < frame.fixedRippleCount; ++r)
+		{
+			const WaterKernel::Ripple& ripple = frame.fixedRipples[r];
+			size_t offset = r * frame.vertexCount + i;
+			typename V::Float phasorCos = V::load(frame.fixedRipplePhasorCos + offset);
+			typename V::Float phasorSin = V::load(frame.fixedRipplePhasorSin + offset);
+			typename V::Float rotationCos = V::set(frame.fixedRippleRotation[2 * r]);
+			typename V::Float rotationSin = V::set(frame.fixedRippleRotation[2 * r + 1]);
+			typename V::Float c = V::sub(V::mul(phasorCos, rotationCos), V::mul(phasorSin, rotationSin));
+			typename V::Float s = V::add(V::mul(phasorSin, rotationCos), V::mul(phasorCos, rotationSin));
+			if (Renormalize)
+			{
+				// 1/sqrt(c²+s²) 在1附近的一阶近似，每次修正后模的误差降为原来的平方量级
+				typename V::Float scale = V::sub(V::set(1.5f), V::mul(V::set(0.5f), V::add(V::mul(c, c), V::mul(s, s))));
+				c = V::mul(c, scale);
+				s = V::mul(s, scale);
+			}
+			V::store(frame.fixedRipplePhasorCos + offset, c);
+			V::store(frame.fixedRipplePhasorSin + offset, s);
+
+			typename V::Float value = V::mul(V::set(ripple.amplitude), c);
+			ox = V::add(ox, V::mul(value, V::load(frame.fixedRippleDirX + offset)));
+			oy = V::add(oy, V::mul(value, V::load(frame.fixedRippleDirY + offset)));
+			if (velocity.enabled)
+			{
+				typename V::Float rippleVelocity = V::mul(V::set(-ripple.amplitude * ripple.frequency * frame.velocityInterval), s);
+				velocity.x = V::add(velocity.x, V::mul(rippleVelocity, V::load(frame.fixedRippleDirX + offset)));
+				velocity.y = V::add(velocity.y, V::mul(rippleVelocity, V::load(frame.fixedRippleDirY + offset)));
+			}
+		}
+		V::store(frame.offsetX + i, ox);
+		V::store(frame.offsetY + i, oy);
+		velocity.store();
+	}
+
+	/**
+	 * @brief 把单个点击波纹对 V::width 个顶点的位移累加到 ox/oy，启用速度时同时累加位移对时间的导数
+	 */
+	template <class V, bool Velocity>
+	inline void addClickRipple(const WaterKernel::ClickRipple& ripple, typename V::Float x, typename V::Float y, typename V::Float& ox, typename V::Float& oy, VelocityAccumulator<V, Velocity>& velocity)
+	{
+		const typename V::Float zero = V::set(0.0f);
+		const typename V::Float one = V::set(1.0f);
+		typename V::Float dx = V::sub(x, V::set(ripple.x));
+		typename V::Float dy = V::sub(y, V::set(ripple.y));
+		typename V::Float distance = V::sqrt(V::add(V::mul(dx, dx), V::mul(dy, dy)));
+		typename V::Mask valid = V::greater(distance, zero);
+		typename V::Float invDistance = V::div(one, V::select(valid, distance, one));
+		typename V::Float dirX = V::select(valid, V::mul(dx, invDistance), one);
+		typename V::Float dirY = V::select(valid, V::mul(dy, invDistance), zero);
+
+		typename V::Float w = V::sub(V::set(ripple.elapsed * ripple.frequency), V::mul(distance, V::set(ripple.density)));
+		typename V::Float distanceToRipple = V::abs(w);
+		typename V::Float cosine = polyCos<V>(distanceToRipple);
+		typename V::Float decay = polyExp<V>(V::sub(zero, distanceToRipple));
+		typename V::Float value = V::mul(V::set(ripple.amplitude), cosine);
+		value = V::mul(value, decay);
+		value = V::mul(value, V::set(1.0f / (ripple.elapsed + 1.0f)));
+		ox = V::add(ox, V::mul(value, dirX));
+		oy = V::add(oy, V::mul(value, dirY));
+		if (velocity.enabled)
+		{
+			// d/dt [cos r·exp(-r)/(elapsed+1)]，r = |w|：-exp(-r)/(elapsed+1)·(sign(w)·frequency·(sin r + cos r) + cos r/(elapsed+1))
+			float attenuation = 1.0f / (ripple.elapsed + 1.0f);
+			typename V::Float signedFrequency = V::select(V::greater(w, zero), V::set(ripple.frequency), V::set(-ripple.frequency));
+			typename V::Float slope = V::add(V::mul(signedFrequency, V::add(polySin<V>(distanceToRipple), cosine)), V::mul(cosine, V::set(attenuation)));
+			typename V::Float rippleVelocity = V::mul(V::mul(V::set(-ripple.amplitude * velocity.frame.velocityInterval * attenuation), decay), slope);
+			velocity.x = V::add(velocity.x, V::mul(rippleVelocity, dirX));
+			velocity.y = V::add(velocity.y, V::mul(rippleVelocity, dirY));
+		}
+	}
+
+	template <class V, bool Velocity>
+	inline void clickRipplesAt(const WaterKernel::Frame& frame, size_t i)
+	{
+		typename V::Float x = V::load(frame.originX + i);
+		typename V::Float y = V::load(frame.originY + i);
+		typename V::Float ox = V::load(frame.offsetX + i);
+		typename V::Float oy = V::load(frame.offsetY + i);
+		VelocityAccumulator<V, Velocity> velocity(frame, i);
+		for (size_t r = 0; r < frame.clickRippleCount; ++r)
+		{
+			addClickRipple<V>(frame.clickRipples[r], x, y, ox, oy, velocity);
+		}
+		V::store(frame.offsetX + i, ox);
+		V::store(frame.offsetY + i, oy);
+		velocity.store();
+	}
+
+	template <class V, bool Velocity>
+	inline void clickRippleSpanAt(const WaterKernel::Frame& frame, const WaterKernel::ClickRipple& ripple, size_t i)
+	{
+		typename V::Float ox = V::load(frame.offsetX + i);
+		typename V::Float oy = V::load(frame.offsetY + i);
+		VelocityAccumulator<V, Velocity> velocity(frame, i);
+		addClickRipple<V>(ripple, V::load(frame.originX + i), V::load(frame.originY + i), ox, oy, velocity);
+		V::store(frame.offsetX + i, ox);
+		V::store(frame.offsetY + i, oy);
+		velocity.store();
+	}
+
+	inline size_t minIndex(size_t a, size_t b)
+	{
+		return a < b ? a : b;
+	}
+
+	/**
+	 * @struct SimdKernels
+	 * @brief 按向量宽度遍历区间，尾部交给单通道多项式路径
+	 * @details 每个入口按 frame 是否提供速度数组选择一次实例化版本，循环内不再判断
+	 */
+	template <class V>
+	struct SimdKernels
+	{
+		static void waves(const WaterKernel::Frame& frame, size_t begin, size_t end)
+		{
+			if (frame.velocityX != nullptr)
+			{
+				wavesLoop<true>(frame, begin, end);
+			}
+			else
+			{
+				wavesLoop<false>(frame, begin, end);
+			}
+		}
+
+		static void separableWaves(const WaterKernel::Frame& frame, size_t begin, size_t end)
+		{
+			if (frame.velocityX != nullptr)
+			{
+				separableWavesLoop<true>(frame, begin, end);
+			}
+			else
+			{
+				separableWavesLoop<false>(frame, begin, end);
+			}
+		}
+
+		static void fixedRipples(const WaterKernel::Frame& frame, size_t begin, size_t end)
+		{
+			if (frame.velocityX != nullptr)
+			{
+				fixedRipplesLoop<true>(frame, begin, end);
+			}
+			else
+			{
+				fixedRipplesLoop<false>(frame, begin, end);
+			}
+		}
+
+		static void cachedFixedRipples(const WaterKernel::Frame& frame, size_t begin, size_t end)
+		{
+			if (frame.velocityX != nullptr)
+			{
+				cachedFixedRipplesLoop<true>(frame, begin, end);
+			}
+			else
+			{
+				cachedFixedRipplesLoop<false>(frame, begin, end);
+			}
+		}
+
+		static void phasorFixedRipples(const WaterKernel::Frame& frame, size_t begin, size_t end)
+		{
+			bool velocity = frame.velocityX != nullptr;
+			if (frame.fixedRipplePhasorRenormalize)
+			{
+				if (velocity)
+				{
+					phasorFixedRipplesLoop<true, true>(frame, begin, end);
+				}
+				else
+				{
+					phasorFixedRipplesLoop<false, true>(frame, begin, end);
+				}
+			}
+			else
+			{
+				if (velocity)
+				{
+					phasorFixedRipplesLoop<true, false>(frame, begin, end);
+				}
+				else
+				{
+					phasorFixedRipplesLoop<false, false>(frame, begin, end);
+				}
+			}
+		}
+
+		static void clickRipples(const WaterKernel::Frame& frame, size_t begin, size_t end)
+		{
+			if (frame.velocityX != nullptr)
+			{
+				clickRipplesLoop<true>(frame, begin, end);
+			}
+			else
+			{
+				clickRipplesLoop<false>(frame, begin, end);
+			}
+		}
+
+		static void clickRippleSpan(const WaterKernel::Frame& frame, const WaterKernel::ClickRipple& ripple, size_t begin, size_t end)
+		{
+			if (frame.velocityX != nullptr)
+			{
+				clickRippleSpanLoop<true>(frame, ripple, begin, end);
+			}
+			else
+			{
+				clickRippleSpanLoop<false>(frame, ripple, begin, end);
+			}
+		}
+
+	private:
+		template <bool Velocity>
+		static void wavesLoop(const WaterKernel::Frame& frame, size_t begin, size_t end)
+		{
+			size_t i = begin;
+			for (; i + V::width <= end; i += V::width)
+			{
+				wavesAt<V, Velocity>(frame, i);
+			}
+			for (; i < end; ++i)
+			{
+				wavesAt<ScalarPolyTraits, Velocity>(frame, i);
+			}
+		}
+
+		template <bool Velocity>
+		static void separableWavesLoop(const WaterKernel::Frame& frame, size_t begin, size_t end)
+		{
+			// 按行遍历，行内各列的表项连续，行项广播
+			size_t i = begin;
+			while (i < end)
+			{
+				size_t row = i / frame.columns;
+				size_t column = i - row * frame.columns;
+				size_t rowEnd = minIndex(end, (row + 1) * frame.columns);
+				for (; i + V::width <= rowEnd; i += V::width, column += V::width)
+				{
+					separableWavesAt<V, Velocity>(frame, i, row, column);
+				}
+				for (; i < rowEnd; ++i, ++column)
+				{
+					separableWavesAt<ScalarPolyTraits, Velocity>(frame, i, row, column);
+				}
+			}
+		}
+
+		template <bool Velocity>
+		static void fixedRipplesLoop(const WaterKernel::Frame& frame, size_t begin, size_t end)
+		{
+			size_t i = begin;
+			for (; i + V::width <= end; i += V::width)
+			{
+				fixedRipplesAt<V, Velocity>(frame, i);
+			}
+			for (; i < end; ++i)
+			{
+				fixedRipplesAt<ScalarPolyTraits, Velocity>(frame, i);
+			}
+		}
+
+		template <bool Velocity>
+		static void cachedFixedRipplesLoop(const WaterKernel::Frame& frame, size_t begin, size_t end)
+		{
+			size_t i = begin;
+			for (; i + V::width <= end; i += V::width)
+			{
+				cachedFixedRipplesAt<V, Velocity>(frame, i);
+			}
+			for (; i < end; ++i)
+			{
+				cachedFixedRipplesAt<ScalarPolyTraits, Velocity>(frame, i);
+			}
+		}
+
+		template <bool Velocity, bool Renormalize>
+		static void phasorFixedRipplesLoop(const WaterKernel::Frame& frame, size_t begin, size_t end)
+		{
+			size_t i = begin;
+			for (; i + V::width <= end; i += V::width)
+			{
+				phasorFixedRipplesAt<V, Velocity, Renormalize>(frame, i);
+			}
+			for (; i < end; ++i)
+			{
+				phasorFixedRipplesAt<ScalarPolyTraits, Velocity, Renormalize>(frame, i);
+			}
+		}
+
+		template <bool Velocity>
+		static void clickRipplesLoop(const WaterKernel::Frame& frame, size_t begin, size_t end)
+		{
+			size_t i = begin;
+			for (; i + V::width <= end; i += V::width)
+			{
+				clickRipplesAt<V, Velocity>(frame, i);
+			}
+			for (; i < end; ++i)
+			{
+				clickRipplesAt<ScalarPolyTraits, Velocity>(frame, i);
+			}
+		}
+
+		template <bool Velocity>
+		static void clickRippleSpanLoop(const WaterKernel::Frame& frame, const WaterKernel::ClickRipple& ripple, size_t begin, size_t end)
+		{
+			size_t i = begin;
+			for (; i + V::width <= end; i += V::width)
+			{
+				clickRippleSpanAt<V, Velocity>(frame, ripple, i);
+			}
+			for (; i < end; ++i)
+			{
+				clickRippleSpanAt<ScalarPolyTraits, Velocity>(frame, ripple, i);
+			}
+		}
+	};
+}
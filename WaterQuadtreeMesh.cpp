@@ -0,0 +1,683 @@
+﻿#include <algorithm>
+#include <cmath>
+#include "WaterQuadtreeMesh.h"
+
+
+/// 各深度的第一个节点在细分掩码中的位序号（深度0、1、2分别有1、4、16个节点）
+static const int kDepthBitOffset[WaterQuadtreeMesh::kMaxLevels] = { 0, 1, 5 };
+
+/// 估计细分时先整体判断的块的边长（粗格子数），曲率上界在更大的区域上只会更大
+static const int kBlockCells = 4;
+
+/**
+ * @brief 按网格尺寸和细分层数重新生成最粗的网格
+ * @param gridSize 最细一级的网格尺寸，向上取整到 2^levels 的倍数
+ * @param levels 细分层数，限制在 [1, kMaxLevels]
+ * @param width 绘制区域宽度
+ * @param height 绘制区域高度
+ */
+void WaterQuadtreeMesh::reset(int gridSize, int levels, float width, float height)
+{
+	_levels = std::min(std::max(levels, 1), kMaxLevels);
+	_baseSize = 1 << _levels;
+	_baseColumns = (std::max(gridSize, 1) + _baseSize - 1) / _baseSize;
+	_latticeSize = _baseColumns * _baseSize;
+	setArea(width, height);
+
+	size_t cellCount = static_cast<size_t>(_baseColumns) * _baseColumns;
+	size_t latticeCount = (static_cast<size_t>(_latticeSize) + 1) * (_latticeSize + 1);
+	_requested.assign(cellCount, 0);
+	_masks.assign(cellCount, 0);
+	_previousMasks.clear();
+	_cellTriangles.resize(cellCount);
+	_dirty.assign(cellCount, 1);
+	_slots.assign(latticeCount, kNoVertex);
+	_nextSlots.assign(latticeCount, kNoVertex);
+	for (size_t cell = 0; cell < cellCount; cell++)
+	{
+		_cellTriangles[cell].clear();
+		_triangulateNode(cell, 0, 0, 0, _cellTriangles[cell]);
+	}
+	_rebuildVertices(false);
+}
+
+/**
+ * @brief 修改绘制区域尺寸
+ * @param width 新的绘制区域宽度
+ * @param height 新的绘制区域高度
+ * @details 拓扑不变，顶点原始坐标需要重新由 fillOrigins 生成；下次 refine 按新尺寸估计误差
+ */
+void WaterQuadtreeMesh::setArea(float width, float height)
+{
+	_width = width;
+	_height = height;
+	_cellWidth = _latticeSize > 0 ? width / _latticeSize : 0.0f;
+	_cellHeight = _latticeSize > 0 ? height / _latticeSize : 0.0f;
+}
+
+/**
+ * @brief 按当前波纹重新细分
+ * @param frame 内核输入，只使用直线波纹、固定波纹和点击波纹的参数
+ * @param tolerance 允许的线性插值误差（像素）
+ * @param lookahead 细分结果需要覆盖的时长（秒），点击波纹的波前按这段时间内扫过的范围细分
+ * @return 顶点或三角面发生变化时返回true，此时 getRemap 给出新旧顶点的对应关系
+ * @details 细分结果与上次相同时只做误差估计，开销与粗格子数量成正比；
+ * 点击波纹只对其波前附近和中心附近的格子逐个估计，其余格子计入一个很小的常数
+ */
+bool WaterQuadtreeMesh::refine(const WaterKernel::Frame& frame, float tolerance, float lookahead)
+{
+	if (_latticeSize == 0)
+	{
+		return false;
+	}
+	// 直线波纹 A·cos(k·d) 的二阶导数不超过 A·k²，固定波纹远处同样如此，两者对所有格子相同
+	float global = 0.0f;
+	for (size_t i = 0; i < frame.waveCount; i++)
+	{
+		global += std::abs(frame.waves[i].amplitude) * frame.waves[i].density * frame.waves[i].density;
+	}
+	for (size_t i = 0; i < frame.fixedRippleCount; i++)
+	{
+		global += std::abs(frame.fixedRipples[i].amplitude) * frame.fixedRipples[i].density * frame.fixedRipples[i].density;
+	}
+	_prepareClickBounds(frame, tolerance, lookahead);
+
+	// 先按 kBlockCells×kBlockCells 个粗格子组成的块估计，整块都不需要细分时跳过其中的格子
+	bool requestChanged = false;
+	float baseWidth = _baseSize * _cellWidth;
+	float baseHeight = _baseSize * _cellHeight;
+	float baseScale = (baseWidth * baseWidth + baseHeight * baseHeight) * 0.125f;
+	for (int blockY = 0; blockY < _baseColumns; blockY += kBlockCells)
+	{
+		int blockBottom = std::min(blockY + kBlockCells, _baseColumns);
+		for (int blockX = 0; blockX < _baseColumns; blockX += kBlockCells)
+		{
+			int blockRight = std::min(blockX + kBlockCells, _baseColumns);
+			bool coarse = global * baseScale <= tolerance
+				&& _curvature(frame, blockX * baseWidth, blockY * baseHeight, blockRight * baseWidth, blockBottom * baseHeight, global) * baseScale <= tolerance;
+			for (int y = blockY; y < blockBottom; y++)
+			{
+				for (int x = blockX; x < blockRight; x++)
+				{
+					size_t cell = static_cast<size_t>(y) * _baseColumns + x;
+					uint32_t mask = 0;
+					if (!coarse)
+					{
+						_requestNode(frame, global, tolerance, cell, 0, 0, 0, mask);
+					}
+					if (mask != _requested[cell])
+					{
+						_requested[cell] = mask;
+						requestChanged = true;
+					}
+				}
+			}
+		}
+	}
+	if (!requestChanged)
+	{
+		return false;
+	}
+
+	_previousMasks = _masks;
+	_masks = _requested;
+	bool split = true;
+	while (split)
+	{
+		split = false;
+		for (size_t cell = 0; cell < _masks.size(); cell++)
+		{
+			split = _balanceNode(cell, 0, 0, 0) || split;
+		}
+	}
+
+	// 叶子的边中点取决于上下左右邻居的细分，掩码变化的粗格子连同邻居一起重新三角化
+	bool changed = false;
+	std::fill(_dirty.begin(), _dirty.end(), 0);
+	for (int y = 0; y < _baseColumns; y++)
+	{
+		for (int x = 0; x < _baseColumns; x++)
+		{
+			size_t cell = static_cast<size_t>(y) * _baseColumns + x;
+			if (_masks[cell] == _previousMasks[cell])
+			{
+				continue;
+			}
+			changed = true;
+			_dirty[cell] = 1;
+			if (x > 0)
+			{
+				_dirty[cell - 1] = 1;
+			}
+			if (x + 1 < _baseColumns)
+			{
+				_dirty[cell + 1] = 1;
+			}
+			if (y > 0)
+			{
+				_dirty[cell - _baseColumns] = 1;
+			}
+			if (y + 1 < _baseColumns)
+			{
+				_dirty[cell + _baseColumns] = 1;
+			}
+		}
+	}
+	if (!changed)
+	{
+		return false;
+	}
+	for (size_t cell = 0; cell < _dirty.size(); cell++)
+	{
+		if (_dirty[cell] != 0)
+		{
+			_cellTriangles[cell].clear();
+			_triangulateNode(cell, 0, 0, 0, _cellTriangles[cell]);
+		}
+	}
+	_rebuildVertices(true);
+	return true;
+}
+
+/**
+ * @brief 获取最细一级的网格尺寸
+ * @return 每行的最细格子数，未初始化时返回0
+ */
+int WaterQuadtreeMesh::getLatticeSize() const
+{
+	return _latticeSize;
+}
+
+/**
+ * @brief 获取顶点数量
+ * @return 顶点数量
+ */
+size_t WaterQuadtreeMesh::getVertexCount() const
+{
+	return _vertexIds.size();
+}
+
+/**
+ * @brief 获取叶子格子数量
+ * @return 数量
+ */
+size_t WaterQuadtreeMesh::getLeafCount() const
+{
+	return _leafCount;
+}
+
+/**
+ * @brief 获取三角面索引
+ * @return 每三个下标组成一个三角面，按粗格子的行优先顺序排列
+ */
+const std::vector<unsigned int>& WaterQuadtreeMesh::getIndices() const
+{
+	return _indices;
+}
+
+/**
+ * @brief 获取新旧顶点的对应关系
+ * @return 长度为 getVertexCount()，只在 refine 返回true之后到下一次 refine 或 reset 之前有效
+ */
+const std::vector<WaterQuadtreeMesh::Remap>& WaterQuadtreeMesh::getRemap() const
+{
+	return _remap;
+}
+
+/**
+ * @brief 生成顶点原始坐标
+ * @param originX 输出：长度为 getVertexCount() 的X坐标
+ * @param originY 输出：长度为 getVertexCount() 的Y坐标
+ * @details 首末行列分别位于绘制区域的边缘
+ */
+void WaterQuadtreeMesh::fillOrigins(float* originX, float* originY) const
+{
+	// 与均匀网格相同，坐标逐格累加，格点坐标与同尺寸的均匀网格逐位一致
+	unsigned int columns = static_cast<unsigned int>(_latticeSize) + 1;
+	std::vector<float> columnX(columns);
+	std::vector<float> rowY(columns);
+	float x = 0.0f;
+	float y = 0.0f;
+	for (unsigned int k = 0; k < columns; k++)
+	{
+		columnX[k] = k + 1 == columns ? _width : x;
+		rowY[k] = k + 1 == columns ? _height : y;
+		x += _cellWidth;
+		y += _cellHeight;
+	}
+	// 顶点按格点编号升序排列，逐行推进，不做除法
+	unsigned int row = 0;
+	unsigned int rowStart = 0;
+	for (size_t i = 0; i < _vertexIds.size(); i++)
+	{
+		while (_vertexIds[i] >= rowStart + columns)
+		{
+			row++;
+			rowStart += columns;
+		}
+		originX[i] = columnX[_vertexIds[i] - rowStart];
+		originY[i] = rowY[row];
+	}
+}
+
+/**
+ * @brief 获取位于绘制区域边缘的顶点
+ * @return 顶点下标（升序）
+ */
+const std::vector<unsigned int>& WaterQuadtreeMesh::getBoundaryVertices() const
+{
+	return _boundaryVertices;
+}
+
+/**
+ * @brief 获取边缘顶点所在的边
+ * @return 与 getBoundaryVertices 一一对应的 WaterKernel::BoundarySide 组合
+ */
+const std::vector<unsigned char>& WaterQuadtreeMesh::getBoundarySides() const
+{
+	return _boundarySides;
+}
+
+/**
+ * @brief 获取节点在细分掩码中的位
+ * @param depth 节点深度（0为粗格子本身）
+ * @param x 节点在粗格子内的列号（以该深度的节点为单位）
+ * @param y 节点在粗格子内的行号
+ * @return 位序号
+ */
+int WaterQuadtreeMesh::_nodeBit(int depth, int x, int y)
+{
+	return kDepthBitOffset[depth] + (y << depth) + x;
+}
+
+/**
+ * @brief 获取包含最细格子的叶子深度
+ * @param masks 细分掩码
+ * @param x 最细格子的列号
+ * @param y 最细格子的行号
+ * @return 叶子深度，格子在网格之外时返回-1
+ */
+int WaterQuadtreeMesh::_depthAt(const std::vector<uint32_t>& masks, int x, int y) const
+{
+	if (x < 0 || y < 0 || x >= _latticeSize || y >= _latticeSize)
+	{
+		return -1;
+	}
+	int cellX = x >> _levels;
+	int cellY = y >> _levels;
+	uint32_t mask = masks[static_cast<size_t>(cellY) * _baseColumns + cellX];
+	int localX = x - (cellX << _levels);
+	int localY = y - (cellY << _levels);
+	int depth = 0;
+	while (depth < _levels)
+	{
+		int shift = _levels - depth;
+		if (((mask >> _nodeBit(depth, localX >> shift, localY >> shift)) & 1u) == 0)
+		{
+			break;
+		}
+		depth++;
+	}
+	return depth;
+}
+
+/**
+ * @brief 估计一个格子内位移的曲率上界
+ * @param frame 内核输入
+ * @param x0 格子左边界
+ * @param y0 格子上边界
+ * @param x1 格子右边界
+ * @param y1 格子下边界
+ * @param global 对所有格子相同的部分（直线波纹和固定波纹的远场）
+ * @return 位移对位置的二阶导数上界（1/像素）
+ * @details 径向波纹的位移为 幅度×cos(相位)×单位方向，距中心 r 处二阶导数不超过 幅度×(k + 2/r)²，
+ * 其中 k 为密度；点击波纹的幅度按格子内离波前最近处的 exp(-|elapsed·frequency - k·r|)/(elapsed+1) 计算，
+ * 包络与余弦之积的二阶导数再多一倍，波前取覆盖时长内扫过的整个范围
+ */
+float WaterQuadtreeMesh::_curvature(const WaterKernel::Frame& frame, float x0, float y0, float x1, float y1, float global) const
+{
+	float curvature = global;
+	for (size_t i = 0; i < frame.fixedRippleCount; i++)
+	{
+		const WaterKernel::Ripple& ripple = frame.fixedRipples[i];
+		float dx = std::max(std::max(x0 - ripple.x, ripple.x - x1), 0.0f);
+		float dy = std::max(std::max(y0 - ripple.y, ripple.y - y1), 0.0f);
+		float nearest = std::sqrt(dx * dx + dy * dy);
+		float density = std::abs(ripple.density);
+		float radial = density + 2.0f / std::max(nearest, 1e-3f);
+		// 远场部分 A·k² 已计入 global
+		curvature += std::abs(ripple.amplitude) * (radial * radial - density * density);
+	}
+	for (const ClickBound& bound : _clickBounds)
+	{
+		float dx = std::max(std::max(x0 - bound.x, bound.x - x1), 0.0f);
+		float dy = std::max(std::max(y0 - bound.y, bound.y - y1), 0.0f);
+		float farX = std::max(std::abs(bound.x - x0), std::abs(bound.x - x1));
+		float farY = std::max(std::abs(bound.y - y0), std::abs(bound.y - y1));
+		float nearest2 = dx * dx + dy * dy;
+		float farthest2 = farX * farX + farY * farY;
+		if (bound.culled)
+		{
+			// 只比较距离的平方，远离波前和中心的格子不做开方和指数运算
+			float outer = bound.frontHigh + bound.bandWidth;
+			float inner = bound.frontLow - bound.bandWidth;
+			bool nearCenter = nearest2 <= bound.nearRadius * bound.nearRadius;
+			bool nearFront = nearest2 <= outer * outer && (inner <= 0.0f || farthest2 >= inner * inner);
+			if (!nearCenter && !nearFront)
+			{
+				curvature += _clickFloor;
+				continue;
+			}
+		}
+		float nearest = std::sqrt(nearest2);
+		float farthest = std::sqrt(farthest2);
+		float gap = nearest > bound.frontHigh ? nearest - bound.frontHigh : (farthest < bound.frontLow ? bound.frontLow - farthest : 0.0f);
+		float local = bound.envelope * std::exp(-bound.density * gap);
+		float radial = bound.density + 2.0f / std::max(nearest, 1e-3f);
+		curvature += 2.0f * local * radial * radial;
+	}
+	return curvature;
+}
+
+/**
+ * @brief 准备本次细分的点击波纹参数
+ * @param frame 内核输入
+ * @param tolerance 允许的线性插值误差（像素）
+ * @param lookahead 细分结果需要覆盖的时长（秒）
+ * @details 距中心超过 2/k 时 (k + 2/r)² 不超过 4k²，波前两侧 bandWidth 之外的曲率因此不超过 floor；
+ * floor 取最细一级细分判断所需曲率的 1/(8×波纹数)，被跳过的波纹合计只使估计略微偏大
+ */
+void WaterQuadtreeMesh::_prepareClickBounds(const WaterKernel::Frame& frame, float tolerance, float lookahead)
+{
+	float threshold = 2.0f * tolerance / std::max(_cellWidth * _cellWidth + _cellHeight * _cellHeight, 1e-6f);
+	_clickFloor = frame.clickRippleCount > 0 ? threshold / (8.0f * frame.clickRippleCount) : 0.0f;
+	_clickBounds.clear();
+	for (size_t i = 0; i < frame.clickRippleCount; i++)
+	{
+		const WaterKernel::ClickRipple& ripple = frame.clickRipples[i];
+		if (ripple.elapsed + lookahead + 1.0f <= 0.0f)
+		{
+			continue;
+		}
+		float elapsed = ripple.elapsed + 1.0f > 0.0f ? ripple.elapsed : 0.0f;
+		ClickBound bound;
+		bound.x = ripple.x;
+		bound.y = ripple.y;
+		bound.density = std::abs(ripple.density);
+		bound.envelope = std::abs(ripple.amplitude) / (elapsed + 1.0f);
+		float speed = ripple.density != 0.0f ? ripple.frequency / ripple.density : 0.0f;
+		bound.frontLow = std::min(elapsed * speed, (elapsed + lookahead) * speed);
+		bound.frontHigh = std::max(elapsed * speed, (elapsed + lookahead) * speed);
+		bound.culled = bound.density > 0.0f && _clickFloor > 0.0f;
+		if (bound.culled)
+		{
+			float peak = 8.0f * bound.envelope * bound.density * bound.density;
+			bound.nearRadius = 2.0f / bound.density;
+			bound.bandWidth = peak > _clickFloor ? std::log(peak / _clickFloor) / bound.density : 0.0f;
+		}
+		_clickBounds.push_back(bound);
+	}
+}
+
+/**
+ * @brief 按误差估计递归标记需要细分的节点
+ * @param frame 内核输入
+ * @param global 曲率中对所有格子相同的部分
+ * @param tolerance 允许的线性插值误差（像素）
+ * @param cell 粗格子下标
+ * @param depth 节点深度
+ * @param x 节点在粗格子内的列号
+ * @param y 节点在粗格子内的行号
+ * @param mask 输入输出：细分掩码
+ * @details 二阶导数不超过 M 的函数在边长为 w×h 的格子上线性插值的误差不超过 M·(w²+h²)/8
+ */
+void WaterQuadtreeMesh::_requestNode(const WaterKernel::Frame& frame, float global, float tolerance, size_t cell, int depth, int x, int y, uint32_t& mask) const
+{
+	if (depth >= _levels)
+	{
+		return;
+	}
+	int size = _baseSize >> depth;
+	int left = static_cast<int>(cell % _baseColumns) * _baseSize + x * size;
+	int top = static_cast<int>(cell / _baseColumns) * _baseSize + y * size;
+	float width = size * _cellWidth;
+	float height = size * _cellHeight;
+	float x0 = left * _cellWidth;
+	float y0 = top * _cellHeight;
+	float scale = (width * width + height * height) * 0.125f;
+	// 各项曲率都非负，只看对所有格子相同的部分已经超过容差时不必逐个波纹估计
+	if (global * scale <= tolerance && _curvature(frame, x0, y0, x0 + width, y0 + height, global) * scale <= tolerance)
+	{
+		return;
+	}
+	mask |= 1u << _nodeBit(depth, x, y);
+	for (int child = 0; child < 4; child++)
+	{
+		_requestNode(frame, global, tolerance, cell, depth + 1, x * 2 + (child & 1), y * 2 + (child >> 1), mask);
+	}
+}
+
+/**
+ * @brief 细分与邻居相差超过一级的叶子
+ * @param cell 粗格子下标
+ * @param depth 节点深度
+ * @param x 节点在粗格子内的列号
+ * @param y 节点在粗格子内的行号
+ * @return 有叶子被细分时返回true
+ */
+bool WaterQuadtreeMesh::_balanceNode(size_t cell, int depth, int x, int y)
+{
+	uint32_t bit = depth < _levels ? 1u << _nodeBit(depth, x, y) : 0;
+	if ((_masks[cell] & bit) != 0)
+	{
+		bool split = false;
+		for (int child = 0; child < 4; child++)
+		{
+			split = _balanceNode(cell, depth + 1, x * 2 + (child & 1), y * 2 + (child >> 1)) || split;
+		}
+		return split;
+	}
+	// 最细的两级叶子不可能与邻居相差两级以上
+	if (depth + 2 > _levels)
+	{
+		return false;
+	}
+	int size = _baseSize >> depth;
+	int half = size / 2;
+	int left = static_cast<int>(cell % _baseColumns) * _baseSize + x * size;
+	int top = static_cast<int>(cell / _baseColumns) * _baseSize + y * size;
+	// 每条边外侧的两个半边各取一个最细格子：邻居的同尺寸节点细分到 depth+2 时必然覆盖其中之一
+	const int samples[8][2] = {
+		{ left, top - 1 }, { left + half, top - 1 },
+		{ left + size, top }, { left + size, top + half },
+		{ left, top + size }, { left + half, top + size },
+		{ left - 1, top }, { left - 1, top + half },
+	};
+	for (const auto& sample : samples)
+	{
+		if (_depthAt(_masks, sample[0], sample[1]) >= depth + 2)
+		{
+			_masks[cell] |= bit;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief 生成一个节点下所有叶子的三角面
+ * @param cell 粗格子下标
+ * @param depth 节点深度
+ * @param x 节点在粗格子内的列号
+ * @param y 节点在粗格子内的行号
+ * @param triangles 输出：三角面（格点编号）
+ * @details 四条边都不与更细的邻居相接时与均匀网格相同，切成两个三角面；
+ * 否则按左上、上中、右上、右中、右下、下中、左下、左中的顺序取存在的格点，与格子中心组成扇形
+ */
+void WaterQuadtreeMesh::_triangulateNode(size_t cell, int depth, int x, int y, std::vector<unsigned int>& triangles)
+{
+	if (depth < _levels && (_masks[cell] & (1u << _nodeBit(depth, x, y))) != 0)
+	{
+		for (int child = 0; child < 4; child++)
+		{
+			_triangulateNode(cell, depth + 1, x * 2 + (child & 1), y * 2 + (child >> 1), triangles);
+		}
+		return;
+	}
+	unsigned int columns = static_cast<unsigned int>(_latticeSize) + 1;
+	int size = _baseSize >> depth;
+	int half = size / 2;
+	int left = static_cast<int>(cell % _baseColumns) * _baseSize + x * size;
+	int top = static_cast<int>(cell / _baseColumns) * _baseSize + y * size;
+	auto vertex = [columns](int column, int row)
+		{
+			return static_cast<unsigned int>(row) * columns + static_cast<unsigned int>(column);
+		};
+	unsigned int topLeft = vertex(left, top);
+	unsigned int topRight = vertex(left + size, top);
+	unsigned int bottomLeft = vertex(left, top + size);
+	unsigned int bottomRight = vertex(left + size, top + size);
+
+	bool middles[4] = {};
+	if (size >= 2)
+	{
+		middles[0] = _depthAt(_masks, left, top - 1) > depth;
+		middles[1] = _depthAt(_masks, left + size, top) > depth;
+		middles[2] = _depthAt(_masks, left, top + size) > depth;
+		middles[3] = _depthAt(_masks, left - 1, top) > depth;
+	}
+	if (!middles[0] && !middles[1] && !middles[2] && !middles[3])
+	{
+		triangles.insert(triangles.end(), { topLeft, topRight, bottomLeft, topRight, bottomRight, bottomLeft });
+		return;
+	}
+	unsigned int ring[8];
+	int count = 0;
+	ring[count++] = topLeft;
+	if (middles[0])
+	{
+		ring[count++] = vertex(left + half, top);
+	}
+	ring[count++] = topRight;
+	if (middles[1])
+	{
+		ring[count++] = vertex(left + size, top + half);
+	}
+	ring[count++] = bottomRight;
+	if (middles[2])
+	{
+		ring[count++] = vertex(left + half, top + size);
+	}
+	ring[count++] = bottomLeft;
+	if (middles[3])
+	{
+		ring[count++] = vertex(left, top + half);
+	}
+	unsigned int center = vertex(left + half, top + half);
+	for (int i = 0; i < count; i++)
+	{
+		triangles.insert(triangles.end(), { center, ring[i], ring[(i + 1) % count] });
+	}
+}
+
+/**
+ * @brief 按各粗格子的三角面重新生成顶点、索引和边缘顶点
+ * @param remap 是否生成新旧顶点的对应关系
+ * @details 开销与格点数和索引数成正比，只在细分变化时调用
+ */
+void WaterQuadtreeMesh::_rebuildVertices(bool remap)
+{
+	std::fill(_nextSlots.begin(), _nextSlots.end(), kNoVertex);
+	size_t indexCount = 0;
+	for (const auto& triangles : _cellTriangles)
+	{
+		for (unsigned int id : triangles)
+		{
+			_nextSlots[id] = 0;
+		}
+		indexCount += triangles.size();
+	}
+	// 按格点编号的顺序分配顶点下标，同时记录位于边缘的顶点
+	unsigned int columns = static_cast<unsigned int>(_latticeSize) + 1;
+	_vertexIds.clear();
+	_boundaryVertices.clear();
+	_boundarySides.clear();
+	for (unsigned int y = 0, id = 0; y < columns; y++)
+	{
+		for (unsigned int x = 0; x < columns; x++, id++)
+		{
+			if (_nextSlots[id] == kNoVertex)
+			{
+				continue;
+			}
+			unsigned int slot = static_cast<unsigned int>(_vertexIds.size());
+			_nextSlots[id] = slot;
+			_vertexIds.push_back(id);
+			unsigned char sides = 0;
+			sides |= x == 0 ? WaterKernel::BoundaryLeft : 0;
+			sides |= x == columns - 1 ? WaterKernel::BoundaryRight : 0;
+			// 与均匀网格的边界约束一致，第二行的首个格点也按首行处理
+			sides |= y == 0 || id == columns ? WaterKernel::BoundaryTop : 0;
+			sides |= y == columns - 1 ? WaterKernel::BoundaryBottom : 0;
+			if (sides != 0)
+			{
+				_boundaryVertices.push_back(slot);
+				_boundarySides.push_back(sides);
+			}
+		}
+	}
+
+	_remap.clear();
+	if (remap)
+	{
+		_remap.resize(_vertexIds.size());
+		for (size_t i = 0; i < _vertexIds.size(); i++)
+		{
+			Remap& entry = _remap[i];
+			unsigned int id = _vertexIds[i];
+			unsigned int previous = _slots[id];
+			if (previous != kNoVertex)
+			{
+				std::fill(std::begin(entry.corners), std::end(entry.corners), previous);
+				entry.kept = true;
+				continue;
+			}
+			// 新格点位于上一个网格的某个叶子内（或其边上），叶子的四角都是上一个网格的顶点
+			int x = static_cast<int>(id % columns);
+			int y = static_cast<int>(id / columns);
+			int cellX = std::min(x, _latticeSize - 1);
+			int cellY = std::min(y, _latticeSize - 1);
+			int size = _baseSize >> _depthAt(_previousMasks, cellX, cellY);
+			int left = cellX - cellX % size;
+			int top = cellY - cellY % size;
+			entry.corners[0] = _slots[static_cast<unsigned int>(top) * columns + left];
+			entry.corners[1] = _slots[static_cast<unsigned int>(top) * columns + left + size];
+			entry.corners[2] = _slots[static_cast<unsigned int>(top + size) * columns + left];
+			entry.corners[3] = _slots[static_cast<unsigned int>(top + size) * columns + left + size];
+			entry.u = static_cast<float>(x - left) / size;
+			entry.v = static_cast<float>(y - top) / size;
+			entry.kept = false;
+		}
+	}
+	_slots.swap(_nextSlots);
+
+	_indices.clear();
+	_indices.reserve(indexCount);
+	for (const auto& triangles : _cellTriangles)
+	{
+		for (unsigned int id : triangles)
+		{
+			_indices.push_back(_slots[id]);
+		}
+	}
+
+	// 每细分一个节点增加三个叶子
+	_leafCount = _masks.size();
+	for (uint32_t mask : _masks)
+	{
+		for (; mask != 0; mask &= mask - 1)
+		{
+			_leafCount += 3;
+		}
+	}
+}
@@ -0,0 +1,240 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include "WaterKernel.h"
+
+
+/**
+ * @class WaterQuadtreeMesh
+ * @brief 按波纹分布自适应细分的网格拓扑
+ * @details 最细一级是 latticeSize×latticeSize 个格子的规则格点，粗网格的每个格子边长为 2^levels 个最细格子，
+ * 各自以四叉树向下细分。格子按位移曲率的上界估计线性插值误差，超过容差时细分：
+ * 直线波纹和固定波纹远处的曲率对所有格子相同，决定开阔水面的细分层数；固定波纹中心附近方向场的曲率和
+ * 点击波纹波前附近的曲率随距离衰减，只细分附近的格子。相邻叶子的层数最多相差一级（2:1平衡），
+ * 与更细的邻居相接的边加入边中点，并以格子中心为扇心三角化，网格没有T形接缝。
+ * 每个粗格子的三角面单独保存，细分变化时只重新三角化掩码变化的粗格子及其上下左右的邻居；
+ * 顶点为三角面用到的格点，按格点编号（行优先）排列
+ */
+class WaterQuadtreeMesh
+{
+public:
+
+	/// 支持的最大细分层数（每个粗格子的细分掩码保存在一个32位整数中）
+	static constexpr int kMaxLevels = 3;
+
+	/// 格点未被使用时的顶点下标
+	static constexpr unsigned int kNoVertex = 0xFFFFFFFFu;
+
+	/**
+	 * @struct Remap
+	 * @brief 新顶点在上一个网格中的对应位置
+	 * @details 保留下来的顶点四个角都是自身原来的下标且权重为0；新增的顶点位于上一个网格的某个叶子格子内，
+	 * 由其四角按双线性插值初始化，画面与细分之前一致
+	 */
+	struct Remap
+	{
+		unsigned int corners[4] = {};		///< 上一个网格中叶子格子四角的顶点下标（左上、右上、左下、右下）
+		float u = 0.0f;						///< 格子内的水平插值权重
+		float v = 0.0f;						///< 格子内的竖直插值权重
+		bool kept = false;					///< 顶点在上一个网格中已经存在
+	};
+
+	/**
+	 * @brief 按网格尺寸和细分层数重新生成最粗的网格
+	 * @param gridSize 最细一级的网格尺寸，向上取整到 2^levels 的倍数
+	 * @param levels 细分层数，限制在 [1, kMaxLevels]
+	 * @param width 绘制区域宽度
+	 * @param height 绘制区域高度
+	 */
+	void reset(int gridSize, int levels, float width, float height);
+
+	/**
+	 * @brief 修改绘制区域尺寸
+	 * @param width 新的绘制区域宽度
+	 * @param height 新的绘制区域高度
+	 * @details 拓扑不变，顶点原始坐标需要重新由 fillOrigins 生成；下次 refine 按新尺寸估计误差
+	 */
+	void setArea(float width, float height);
+
+	/**
+	 * @brief 按当前波纹重新细分
+	 * @param frame 内核输入，只使用直线波纹、固定波纹和点击波纹的参数
+	 * @param tolerance 允许的线性插值误差（像素）
+	 * @param lookahead 细分结果需要覆盖的时长（秒），点击波纹的波前按这段时间内扫过的范围细分
+	 * @return 顶点或三角面发生变化时返回true，此时 getRemap 给出新旧顶点的对应关系
+	 * @details 细分结果与上次相同时只做误差估计，开销与粗格子数量成正比；
+	 * 点击波纹只对其波前附近和中心附近的格子逐个估计，其余格子计入一个很小的常数
+	 */
+	bool refine(const WaterKernel::Frame& frame, float tolerance, float lookahead);
+
+	/**
+	 * @brief 获取最细一级的网格尺寸
+	 * @return 每行的最细格子数，未初始化时返回0
+	 */
+	int getLatticeSize() const;
+
+	/**
+	 * @brief 获取顶点数量
+	 * @return 顶点数量
+	 */
+	size_t getVertexCount() const;
+
+	/**
+	 * @brief 获取叶子格子数量
+	 * @return 数量
+	 */
+	size_t getLeafCount() const;
+
+	/**
+	 * @brief 获取三角面索引
+	 * @return 每三个下标组成一个三角面，按粗格子的行优先顺序排列
+	 */
+	const std::vector<unsigned int>& getIndices() const;
+
+	/**
+	 * @brief 获取新旧顶点的对应关系
+	 * @return 长度为 getVertexCount()，只在 refine 返回true之后到下一次 refine 或 reset 之前有效
+	 */
+	const std::vector<Remap>& getRemap() const;
+
+	/**
+	 * @brief 生成顶点原始坐标
+	 * @param originX 输出：长度为 getVertexCount() 的X坐标
+	 * @param originY 输出：长度为 getVertexCount() 的Y坐标
+	 * @details 首末行列分别位于绘制区域的边缘
+	 */
+	void fillOrigins(float* originX, float* originY) const;
+
+	/**
+	 * @brief 获取位于绘制区域边缘的顶点
+	 * @return 顶点下标（升序）
+	 */
+	const std::vector<unsigned int>& getBoundaryVertices() const;
+
+	/**
+	 * @brief 获取边缘顶点所在的边
+	 * @return 与 getBoundaryVertices 一一对应的 WaterKernel::BoundarySide 组合
+	 */
+	const std::vector<unsigned char>& getBoundarySides() const;
+
+private:
+	int _levels = 0;										///< 细分层数
+	int _baseSize = 1;										///< 粗格子的边长（最细格子数）
+	int _latticeSize = 0;									///< 最细一级每行的格子数
+	int _baseColumns = 0;									///< 每行的粗格子数
+	float _cellWidth = 0.0f;								///< 最细格子的宽度
+	float _cellHeight = 0.0f;								///< 最细格子的高度
+	float _width = 0.0f;									///< 绘制区域宽度
+	float _height = 0.0f;									///< 绘制区域高度
+
+	std::vector<uint32_t> _requested;						///< 按误差估计得到的各粗格子细分掩码（平衡之前）
+	std::vector<uint32_t> _masks;							///< 平衡之后的细分掩码，每个内部节点一位
+	std::vector<uint32_t> _previousMasks;					///< 上一个网格的细分掩码，用于定位新顶点
+	std::vector<std::vector<unsigned int>> _cellTriangles;	///< 各粗格子的三角面（格点编号）
+	std::vector<unsigned char> _dirty;						///< 需要重新三角化的粗格子
+	size_t _leafCount = 0;									///< 叶子格子数量
+
+	std::vector<unsigned int> _vertexIds;					///< 各顶点的格点编号（升序）
+	std::vector<unsigned int> _slots;						///< 格点编号到顶点下标，未使用的格点为 kNoVertex
+	std::vector<unsigned int> _nextSlots;					///< 生成新顶点时使用的格点映射
+	std::vector<unsigned int> _indices;						///< 三角面索引（顶点下标）
+	std::vector<Remap> _remap;								///< 新旧顶点的对应关系
+	std::vector<unsigned int> _boundaryVertices;			///< 边缘顶点下标
+	std::vector<unsigned char> _boundarySides;				///< 边缘顶点所在的边
+
+	/**
+	 * @struct ClickBound
+	 * @brief 一次细分中点击波纹的曲率估计参数
+	 */
+	struct ClickBound
+	{
+		float x = 0.0f;						///< 中心X坐标
+		float y = 0.0f;						///< 中心Y坐标
+		float density = 0.0f;				///< 密度的绝对值
+		float envelope = 0.0f;				///< 波前处的位移幅度上界
+		float frontLow = 0.0f;				///< 覆盖时长内波前半径的下限
+		float frontHigh = 0.0f;				///< 覆盖时长内波前半径的上限
+		float nearRadius = 0.0f;			///< 此半径以内总是逐格估计（中心附近方向场的曲率）
+		float bandWidth = 0.0f;				///< 波前两侧逐格估计的宽度，之外的曲率不超过 floor
+		bool culled = false;				///< 是否只在波前和中心附近逐格估计
+	};
+	std::vector<ClickBound> _clickBounds;					///< 本次细分的点击波纹参数
+	float _clickFloor = 0.0f;								///< 被跳过的点击波纹各自计入的曲率
+
+	/**
+	 * @brief 获取节点在细分掩码中的位
+	 * @param depth 节点深度（0为粗格子本身）
+	 * @param x 节点在粗格子内的列号（以该深度的节点为单位）
+	 * @param y 节点在粗格子内的行号
+	 * @return 位序号
+	 */
+	static int _nodeBit(int depth, int x, int y);
+
+	/**
+	 * @brief 获取包含最细格子的叶子深度
+	 * @param masks 细分掩码
+	 * @param x 最细格子的列号
+	 * @param y 最细格子的行号
+	 * @return 叶子深度，格子在网格之外时返回-1
+	 */
+	int _depthAt(const std::vector<uint32_t>& masks, int x, int y) const;
+
+	/**
+	 * @brief 估计一个格子内位移的曲率上界
+	 * @param frame 内核输入
+	 * @param x0 格子左边界
+	 * @param y0 格子上边界
+	 * @param x1 格子右边界
+	 * @param y1 格子下边界
+	 * @param global 对所有格子相同的部分（直线波纹和固定波纹的远场）
+	 * @return 位移对位置的二阶导数上界（1/像素）
+	 */
+	float _curvature(const WaterKernel::Frame& frame, float x0, float y0, float x1, float y1, float global) const;
+
+	/**
+	 * @brief 准备本次细分的点击波纹参数
+	 * @param frame 内核输入
+	 * @param tolerance 允许的线性插值误差（像素）
+	 * @param lookahead 细分结果需要覆盖的时长（秒）
+	 */
+	void _prepareClickBounds(const WaterKernel::Frame& frame, float tolerance, float lookahead);
+
+	/**
+	 * @brief 按误差估计递归标记需要细分的节点
+	 * @param frame 内核输入
+	 * @param global 曲率中对所有格子相同的部分
+	 * @param tolerance 允许的线性插值误差（像素）
+	 * @param cell 粗格子下标
+	 * @param depth 节点深度
+	 * @param x 节点在粗格子内的列号
+	 * @param y 节点在粗格子内的行号
+	 * @param mask 输入输出：细分掩码
+	 */
+	void _requestNode(const WaterKernel::Frame& frame, float global, float tolerance, size_t cell, int depth, int x, int y, uint32_t& mask) const;
+
+	/**
+	 * @brief 细分与邻居相差超过一级的叶子
+	 * @param cell 粗格子下标
+	 * @param depth 节点深度
+	 * @param x 节点在粗格子内的列号
+	 * @param y 节点在粗格子内的行号
+	 * @return 有叶子被细分时返回true
+	 */
+	bool _balanceNode(size_t cell, int depth, int x, int y);
+
+	/**
+	 * @brief 生成一个节点下所有叶子的三角面
+	 * @param cell 粗格子下标
+	 * @param depth 节点深度
+	 * @param x 节点在粗格子内的列号
+	 * @param y 节点在粗格子内的行号
+	 * @param triangles 输出：三角面（格点编号）
+	 */
+	void _triangulateNode(size_t cell, int depth, int x, int y, std::vector<unsigned int>& triangles);
+
+	/**
+	 * @brief 按各粗格子的三角面重新生成顶点、索引和边缘顶点
+	 * @param remap 是否生成新旧顶点的对应关系
+	 */
+	void _rebuildVertices(bool remap);
+};
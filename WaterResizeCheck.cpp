@@ -0,0 +1,239 @@
+﻿/**
+ * @file WaterResizeCheck.cpp
+ * @brief 检查反复调整绘制区域尺寸时不分配内存
+ * @details 不依赖SDL，替换全局 operator new 统计分配次数：按预设波纹参数 initGrid 后先预热几帧，
+ * 再交替调用 WaterField::resize（宽高每次在原尺寸附近变化）和 update，期间按固定间隔添加点击波纹（高度场模式下为冲击）。
+ * 预热之后发生任何分配都返回1，结果以CSV输出到标准输出。
+ *
+ * 构建（Linux/macOS）：
+ *   g++ -O2 -std=c++17 -o WaterResizeCheck WaterResizeCheck.cpp WaterField.cpp WaterStats.cpp WaterKernel.cpp
+ *       WaterKernelPortable.cpp WaterKernelSSE2.cpp WaterKernelAVX2.cpp WaterThreadPool.cpp WaterQuadtreeMesh.cpp -lpthread
+ *
+ * 用法：
+ *   WaterResizeCheck [--grid 200] [--cycles 500] [--threads 1] [--engine analytic|heightfield]
+ */
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+#include "WaterField.h"
+
+namespace
+{
+	constexpr float kWidth = 1600.0f;
+	constexpr float kHeight = 900.0f;
+	constexpr int kWarmupFrames = 5;
+	constexpr int kClickInterval = 10;
+
+	std::atomic<bool> counting(false);
+	std::atomic<size_t> allocationCount(0);
+	std::atomic<size_t> allocationBytes(0);
+
+	/**
+	 * @brief 统计一次分配并分配内存
+	 * @param size 字节数
+	 * @return 内存，失败时返回nullptr
+	 */
+	void* countedAllocate(std::size_t size)
+	{
+		if (counting.load(std::memory_order_relaxed))
+		{
+			allocationCount.fetch_add(1, std::memory_order_relaxed);
+			allocationBytes.fetch_add(size, std::memory_order_relaxed);
+		}
+		return std::malloc(size != 0 ? size : 1);
+	}
+
+	/**
+	 * @struct Options
+	 * @brief 命令行参数
+	 */
+	struct Options
+	{
+		int grid = 200;
+		int cycles = 500;
+		int threads = 1;
+		WaterClickRippleEngine engine = WaterClickRippleEngine::Analytic;
+	};
+
+	/**
+	 * @brief 解析正整数
+	 * @param text 输入文本
+	 * @param value 输出
+	 * @return 格式正确返回true
+	 */
+	bool parsePositive(const char* text, int& value)
+	{
+		char* end = nullptr;
+		long parsed = std::strtol(text, &end, 10);
+		if (*text == '\0' || *end != '\0' || parsed <= 0)
+		{
+			return false;
+		}
+		value = static_cast<int>(parsed);
+		return true;
+	}
+
+	/**
+	 * @brief 解析命令行参数
+	 * @param argc 参数数量
+	 * @param argv 参数数组
+	 * @param options 输出
+	 * @return 参数正确返回true
+	 */
+	bool parseOptions(int argc, char* argv[], Options& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const char* arg = argv[i];
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+			if (value == nullptr)
+			{
+				return false;
+			}
+			i++;
+			if (std::strcmp(arg, "--grid") == 0)
+			{
+				if (!parsePositive(value, options.grid))
+				{
+					return false;
+				}
+			}
+			else if (std::strcmp(arg, "--cycles") == 0)
+			{
+				if (!parsePositive(value, options.cycles))
+				{
+					return false;
+				}
+			}
+			else if (std::strcmp(arg, "--threads") == 0)
+			{
+				if (!parsePositive(value, options.threads))
+				{
+					return false;
+				}
+			}
+			else if (std::strcmp(arg, "--engine") == 0)
+			{
+				if (std::strcmp(value, "analytic") != 0 && std::strcmp(value, "heightfield") != 0)
+				{
+					return false;
+				}
+				options.engine = std::strcmp(value, "analytic") == 0 ? WaterClickRippleEngine::Analytic : WaterClickRippleEngine::HeightField;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief 输出用法说明
+	 */
+	void printUsage()
+	{
+		std::fprintf(stderr, "usage: WaterResizeCheck [--grid 200] [--cycles 500] [--threads 1] [--engine analytic|heightfield]\n");
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	void* memory = countedAllocate(size);
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return countedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	WaterField field;
+	field.applyPresetParams();
+	field.setThreadCount(options.threads);
+	field.setClickRippleEngine(options.engine);
+	field.initGrid(options.grid, kWidth, kHeight);
+
+	// 输出缓冲区按初始网格分配一次，resize 不改变顶点数量
+	size_t vertexCount = field.getVertexCount();
+	std::vector<float> x(vertexCount);
+	std::vector<float> y(vertexCount);
+	std::vector<float> alpha(vertexCount);
+	WaterVertexSpan output;
+	output.x = x.data();
+	output.y = y.data();
+	output.alpha = alpha.data();
+
+	float time = 1.0f;
+	for (int frame = 0; frame < kWarmupFrames; frame++, time += 1.0f / 60.0f)
+	{
+		field.addDefaultClickRipple(kWidth * 0.5f, kHeight * 0.5f, time);
+		field.update(time, output);
+	}
+
+	counting.store(true);
+	for (int cycle = 0; cycle < options.cycles; cycle++, time += 1.0f / 60.0f)
+	{
+		// 宽高交替变大变小，幅度在 ±16 像素内循环
+		float delta = static_cast<float>(cycle % 17) * (cycle % 2 == 0 ? 1.0f : -1.0f);
+		field.resize(kWidth + delta, kHeight - delta);
+		if (cycle % kClickInterval == 0)
+		{
+			field.addDefaultClickRipple(kWidth * (cycle % 7) / 7.0f, kHeight * (cycle % 5) / 5.0f, time);
+		}
+		field.update(time, output);
+	}
+	counting.store(false);
+
+	size_t count = allocationCount.load();
+	std::printf("grid,vertices,threads,engine,cycles,allocations,bytes\n");
+	std::printf("%d,%zu,%d,%s,%d,%zu,%zu\n", options.grid, vertexCount, options.threads,
+		options.engine == WaterClickRippleEngine::Analytic ? "analytic" : "heightfield", options.cycles, count, allocationBytes.load());
+	return count == 0 ? 0 : 1;
+}
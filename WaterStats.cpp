@@ -0,0 +1,60 @@
+﻿#include <algorithm>
+#include "WaterStats.h"
+
+
+/**
+ * @brief 添加一个样本
+ * @param ms 耗时（毫秒）
+ */
+void WaterTimingWindow::push(float ms)
+{
+	_samples[_next] = ms;
+	_next = (_next + 1) % kCapacity;
+	_count = std::min(_count + 1, kCapacity);
+}
+
+/**
+ * @brief 清空全部样本
+ */
+void WaterTimingWindow::clear()
+{
+	_next = 0;
+	_count = 0;
+}
+
+/**
+ * @brief 获取样本数量
+ * @return 不超过 kCapacity
+ */
+size_t WaterTimingWindow::size() const
+{
+	return _count;
+}
+
+/**
+ * @brief 汇总窗口内的样本
+ * @return 最小值、平均值和第99百分位，没有样本时全为0
+ * @details 在栈上的副本中选出百分位，不修改窗口，不分配内存
+ */
+WaterTiming WaterTimingWindow::summarize() const
+{
+	WaterTiming timing;
+	if (_count == 0)
+	{
+		return timing;
+	}
+	// 未写满时有效样本位于前 _count 个位置，写满后全部有效，与写入位置无关
+	std::array<float, kCapacity> sorted = _samples;
+	float sum = 0.0f;
+	timing.minMs = sorted[0];
+	for (size_t i = 0; i < _count; i++)
+	{
+		sum += sorted[i];
+		timing.minMs = std::min(timing.minMs, sorted[i]);
+	}
+	timing.avgMs = sum / static_cast<float>(_count);
+	size_t rank = (_count * 99 + 99) / 100 - 1;
+	std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + _count);
+	timing.p99Ms = sorted[rank];
+	return timing;
+}
@@ -0,0 +1,101 @@
+﻿#pragma once
+#include <array>
+#include <cstddef>
+
+
+/// 性能统计的编译期开关，定义为0时移除全部计时代码和统计数据，getStats 返回全零
+#ifndef WATER_EFFECT_STATS
+#define WATER_EFFECT_STATS 1
+#endif
+
+
+/**
+ * @struct WaterTiming
+ * @brief 一项耗时在统计窗口内的汇总（毫秒）
+ */
+struct WaterTiming
+{
+	float minMs = 0.0f;					///< 最小值
+	float avgMs = 0.0f;					///< 平均值
+	float p99Ms = 0.0f;					///< 第99百分位
+};
+
+/**
+ * @struct WaterStats
+ * @brief 最近若干帧的性能统计
+ * @details 各更新阶段的耗时为所有行带耗时之和（多线程时大于实际经过的时间），没有模拟的帧记为0；
+ * update 和 submit 为调用线程上实际经过的时间
+ */
+struct WaterStats
+{
+	WaterTiming waves;									///< 直线波纹（含偏移清零）
+	WaterTiming fixedRipples;							///< 固定波纹
+	WaterTiming clickRipples;							///< 点击波纹和高度场
+	WaterTiming boundary;								///< 边界约束
+	WaterTiming lighting;								///< 光照
+	WaterTiming update;									///< 整个 update 调用
+	WaterTiming submit;									///< 提交几何体
+	size_t frameCount = 0;								///< 统计窗口内的帧数
+
+	size_t vertexCount = 0;								///< 网格顶点数
+	size_t indexCount = 0;								///< 最近一次提交的索引数
+	size_t activeClickRipples = 0;						///< 当前的点击波纹数量
+	unsigned long long droppedClickRipples = 0;			///< 因缓冲池已满而被丢弃或替换的点击波纹累计数量
+	size_t uploadedBytes = 0;							///< 最近一次提交的顶点和索引字节数
+	unsigned long long totalUploadedBytes = 0;			///< 累计提交的字节数
+};
+
+/**
+ * @enum WaterStage
+ * @brief 统计的计时项
+ */
+enum class WaterStage
+{
+	Waves,
+	FixedRipples,
+	ClickRipples,
+	Boundary,
+	Lighting,
+	Update,
+	Submit,
+	Count,
+};
+
+/**
+ * @class WaterTimingWindow
+ * @brief 固定容量的耗时滚动窗口
+ * @details 保存最近 kCapacity 个样本，写入不分配内存，超出容量时覆盖最早的样本
+ */
+class WaterTimingWindow
+{
+public:
+	static constexpr size_t kCapacity = 120;	///< 窗口容量（帧）
+
+	/**
+	 * @brief 添加一个样本
+	 * @param ms 耗时（毫秒）
+	 */
+	void push(float ms);
+
+	/**
+	 * @brief 清空全部样本
+	 */
+	void clear();
+
+	/**
+	 * @brief 获取样本数量
+	 * @return 不超过 kCapacity
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief 汇总窗口内的样本
+	 * @return 最小值、平均值和第99百分位，没有样本时全为0
+	 */
+	WaterTiming summarize() const;
+
+private:
+	std::array<float, kCapacity> _samples = {};
+	size_t _next = 0;
+	size_t _count = 0;
+};
@@ -0,0 +1,219 @@
+﻿#include "WaterThreadPool.h"
+
+/**
+ * @brief 创建线程池
+ * @param threadCount 参与计算的线程总数（含调用线程，至少为1）
+ */
+WaterThreadPool::WaterThreadPool(int threadCount)
+{
+	_threadCount = threadCount < 1 ? 1 : threadCount;
+	_queues.reset(new Queue[_threadCount]);
+	for (int i = 1; i < _threadCount; ++i)
+	{
+		_threads.emplace_back(&WaterThreadPool::_workerLoop, this, i);
+	}
+}
+
+/**
+ * @brief 通知所有工作线程退出并等待其结束
+ */
+WaterThreadPool::~WaterThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_quit = true;
+	}
+	_wakeCondition.notify_all();
+	for (auto& thread : _threads)
+	{
+		thread.join();
+	}
+}
+
+/**
+ * @brief 获取参与计算的线程总数
+ * @return 线程数（含调用线程）
+ */
+int WaterThreadPool::getThreadCount() const
+{
+	return _threadCount;
+}
+
+/**
+ * @brief 并行执行一组任务并等待全部完成
+ * @param taskCount 任务数量
+ * @param task 任务函数，参数为任务编号 [0, taskCount)
+ * @note 不可重入，同一时刻只能有一个线程调用
+ */
+void WaterThreadPool::run(size_t taskCount, const std::function<void(size_t)>& task)
+{
+	if (taskCount == 0)
+	{
+		return;
+	}
+	if (_threads.empty() || taskCount == 1)
+	{
+		for (size_t i = 0; i < taskCount; ++i)
+		{
+			task(i);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		size_t begin = 0;
+		for (int i = 0; i < _threadCount; ++i)
+		{
+			size_t end = taskCount * (i + 1) / _threadCount;
+			_queues[i].next.store(begin, std::memory_order_relaxed);
+			_queues[i].end = end;
+			begin = end;
+		}
+		_task = &task;
+		_busyWorkers = static_cast<int>(_threads.size());
+		++_generation;
+	}
+	_wakeCondition.notify_all();
+
+	_work(0);
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_doneCondition.wait(lock, [this] { return _busyWorkers == 0; });
+	_task = nullptr;
+}
+
+/**
+ * @brief 工作线程主循环
+ * @param index 线程编号（从1开始，0号为调用线程）
+ */
+void WaterThreadPool::_workerLoop(int index)
+{
+	unsigned long long seenGeneration = 0;
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true)
+	{
+		_wakeCondition.wait(lock, [&] { return _quit || _generation != seenGeneration; });
+		if (_quit)
+		{
+			return;
+		}
+		seenGeneration = _generation;
+		lock.unlock();
+
+		_work(index);
+
+		lock.lock();
+		if (--_busyWorkers == 0)
+		{
+			_doneCondition.notify_one();
+		}
+	}
+}
+
+/**
+ * @brief 先处理本地队列，再依次从其他队列窃取任务
+ * @param index 线程编号
+ */
+void WaterThreadPool::_work(int index)
+{
+	for (int k = 0; k < _threadCount; ++k)
+	{
+		Queue& queue = _queues[(index + k) % _threadCount];
+		while (true)
+		{
+			size_t taskIndex = queue.next.fetch_add(1, std::memory_order_relaxed);
+			if (taskIndex >= queue.end)
+			{
+				break;
+			}
+			(*_task)(taskIndex);
+		}
+	}
+}
+
+/**
+ * @brief 创建后台线程
+ */
+WaterBackgroundWorker::WaterBackgroundWorker()
+{
+	_thread = std::thread(&WaterBackgroundWorker::_workerLoop, this);
+}
+
+/**
+ * @brief 等待进行中的任务完成，通知后台线程退出并等待其结束
+ */
+WaterBackgroundWorker::~WaterBackgroundWorker()
+{
+	wait();
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_quit = true;
+	}
+	_wakeCondition.notify_one();
+	_thread.join();
+}
+
+/**
+ * @brief 在后台线程开始执行任务
+ * @param job 任务函数，执行完成前必须保持有效
+ * @details 上一个任务尚未完成时先等待其完成
+ */
+void WaterBackgroundWorker::start(const std::function<void()>& job)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_doneCondition.wait(lock, [this] { return !_busy; });
+	_job = &job;
+	_busy = true;
+	lock.unlock();
+	_wakeCondition.notify_one();
+}
+
+/**
+ * @brief 等待进行中的任务完成
+ * @details 没有进行中的任务或在任务内部调用时立即返回
+ */
+void WaterBackgroundWorker::wait()
+{
+	if (std::this_thread::get_id() == _thread.get_id())
+	{
+		return;
+	}
+	std::unique_lock<std::mutex> lock(_mutex);
+	_doneCondition.wait(lock, [this] { return !_busy; });
+}
+
+/**
+ * @brief 判断是否有进行中的任务
+ * @return 已提交且尚未完成时返回true
+ */
+bool WaterBackgroundWorker::isBusy() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _busy;
+}
+
+/**
+ * @brief 后台线程主循环
+ */
+void WaterBackgroundWorker::_workerLoop()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true)
+	{
+		_wakeCondition.wait(lock, [this] { return _quit || _job != nullptr; });
+		if (_quit)
+		{
+			return;
+		}
+		const std::function<void()>* job = _job;
+		_job = nullptr;
+		lock.unlock();
+
+		(*job)();
+
+		lock.lock();
+		_busy = false;
+		_doneCondition.notify_all();
+	}
+}
@@ -0,0 +1,141 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class WaterThreadPool
+ * @brief 常驻工作线程池
+ * @details 每次 run 把任务编号平均分配给各线程的本地队列，线程处理完自己的队列后
+ * 会从其他线程的队列中窃取剩余任务，避免个别耗时的任务（例如点击波纹附近的网格带）拖慢整帧。
+ * 调用线程本身也作为0号线程参与计算，run 返回时所有任务均已完成。
+ */
+class WaterThreadPool
+{
+public:
+
+	/**
+	 * @brief 创建线程池
+	 * @param threadCount 参与计算的线程总数（含调用线程，至少为1）
+	 */
+	explicit WaterThreadPool(int threadCount);
+
+	/**
+	 * @brief 通知所有工作线程退出并等待其结束
+	 */
+	~WaterThreadPool();
+
+	WaterThreadPool(const WaterThreadPool&) = delete;
+	WaterThreadPool& operator=(const WaterThreadPool&) = delete;
+
+	/**
+	 * @brief 获取参与计算的线程总数
+	 * @return 线程数（含调用线程）
+	 */
+	int getThreadCount() const;
+
+	/**
+	 * @brief 并行执行一组任务并等待全部完成
+	 * @param taskCount 任务数量
+	 * @param task 任务函数，参数为任务编号 [0, taskCount)
+	 * @note 不可重入，同一时刻只能有一个线程调用
+	 */
+	void run(size_t taskCount, const std::function<void(size_t)>& task);
+
+private:
+	/**
+	 * @struct Queue
+	 * @brief 单个线程的任务区间，独占一条缓存行
+	 */
+	struct alignas(64) Queue
+	{
+		std::atomic<size_t> next{ 0 };
+		size_t end = 0;
+	};
+
+	int _threadCount = 1;
+	std::vector<std::thread> _threads;
+	std::unique_ptr<Queue[]> _queues;
+
+	std::mutex _mutex;
+	std::condition_variable _wakeCondition;
+	std::condition_variable _doneCondition;
+	unsigned long long _generation = 0;
+	int _busyWorkers = 0;
+	bool _quit = false;
+	const std::function<void(size_t)>* _task = nullptr;
+
+	/**
+	 * @brief 工作线程主循环
+	 * @param index 线程编号（从1开始，0号为调用线程）
+	 */
+	void _workerLoop(int index);
+
+	/**
+	 * @brief 先处理本地队列，再依次从其他队列窃取任务
+	 * @param index 线程编号
+	 */
+	void _work(int index);
+};
+
+
+/**
+ * @class WaterBackgroundWorker
+ * @brief 依次执行单个后台任务的常驻线程
+ * @details start 把任务交给后台线程后立即返回，wait 等待其完成；任务函数由调用方持有，
+ * 每次提交只传递指针，不产生内存分配
+ */
+class WaterBackgroundWorker
+{
+public:
+
+	/**
+	 * @brief 创建后台线程
+	 */
+	WaterBackgroundWorker();
+
+	/**
+	 * @brief 等待进行中的任务完成，通知后台线程退出并等待其结束
+	 */
+	~WaterBackgroundWorker();
+
+	WaterBackgroundWorker(const WaterBackgroundWorker&) = delete;
+	WaterBackgroundWorker& operator=(const WaterBackgroundWorker&) = delete;
+
+	/**
+	 * @brief 在后台线程开始执行任务
+	 * @param job 任务函数，执行完成前必须保持有效
+	 * @details 上一个任务尚未完成时先等待其完成
+	 */
+	void start(const std::function<void()>& job);
+
+	/**
+	 * @brief 等待进行中的任务完成
+	 * @details 没有进行中的任务或在任务内部调用时立即返回
+	 */
+	void wait();
+
+	/**
+	 * @brief 判断是否有进行中的任务
+	 * @return 已提交且尚未完成时返回true
+	 */
+	bool isBusy() const;
+
+private:
+	std::thread _thread;
+	mutable std::mutex _mutex;
+	std::condition_variable _wakeCondition;
+	std::condition_variable _doneCondition;
+	const std::function<void()>* _job = nullptr;
+	bool _busy = false;
+	bool _quit = false;
+
+	/**
+	 * @brief 后台线程主循环
+	 */
+	void _workerLoop();
+};
@@ -0,0 +1,581 @@
+﻿#include <cstdio>
+#include <cstring>
+#include "WaterTrace.h"
+
+
+namespace
+{
+	const uint8_t kTraceMagic[4] = { 'S', 'W', 'T', 'R' };
+	/// 版本2增加了 Pipelined 记录，版本3增加了 Quadtree 记录；读取时接受不高于当前版本的轨迹
+	constexpr uint32_t kTraceVersion = 3;
+
+	/**
+	 * @brief 追加一个32位无符号整数（小端）
+	 */
+	void writeUint(std::vector<uint8_t>& data, uint32_t value)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			data.push_back(static_cast<uint8_t>(value >> (i * 8)));
+		}
+	}
+
+	/**
+	 * @brief 追加一个浮点数（按位写入，保证重放逐位相同）
+	 */
+	void writeFloat(std::vector<uint8_t>& data, float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		writeUint(data, bits);
+	}
+
+	/**
+	 * @struct Reader
+	 * @brief 顺序读取轨迹数据，越界后 ok 为false
+	 */
+	struct Reader
+	{
+		const std::vector<uint8_t>& data;
+		size_t& position;
+		bool ok = true;
+
+		uint8_t readByte()
+		{
+			if (position + 1 > data.size())
+			{
+				ok = false;
+				return 0;
+			}
+			return data[position++];
+		}
+
+		uint32_t readUint()
+		{
+			if (position + 4 > data.size())
+			{
+				ok = false;
+				return 0;
+			}
+			uint32_t value = 0;
+			for (int i = 0; i < 4; i++)
+			{
+				value |= static_cast<uint32_t>(data[position++]) << (i * 8);
+			}
+			return value;
+		}
+
+		float readFloat()
+		{
+			uint32_t bits = readUint();
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+	};
+}
+
+/**
+ * @brief 创建空轨迹
+ */
+WaterTraceRecorder::WaterTraceRecorder()
+{
+	_data.assign(kTraceMagic, kTraceMagic + sizeof(kTraceMagic));
+	writeUint(_data, kTraceVersion);
+}
+
+/**
+ * @brief 添加一条记录
+ * @param record 记录
+ */
+void WaterTraceRecorder::record(const WaterTraceRecord& record)
+{
+	_data.push_back(static_cast<uint8_t>(record.event));
+	switch (record.event)
+	{
+	case WaterTraceEvent::Settings:
+		writeUint(_data, static_cast<uint32_t>(record.settings.maxClickRipple));
+		_data.push_back(static_cast<uint8_t>(record.settings.clickRippleOverflow));
+		writeFloat(_data, record.settings.clickRippleEpsilon);
+		writeFloat(_data, record.settings.tileEpsilon);
+		writeFloat(_data, record.settings.simulationRate);
+		_data.push_back(static_cast<uint8_t>(record.settings.clickRippleEngine));
+		_data.push_back(static_cast<uint8_t>(record.settings.precision));
+		break;
+	case WaterTraceEvent::Light:
+		writeFloat(_data, record.light.minDistance);
+		writeFloat(_data, record.light.defaultAlpha);
+		writeFloat(_data, record.light.minAlpha);
+		writeFloat(_data, record.light.decay);
+		writeFloat(_data, record.light.angle);
+		_data.push_back(static_cast<uint8_t>(record.light.mode));
+		writeFloat(_data, record.light.referenceInterval);
+		break;
+	case WaterTraceEvent::DefaultClickRipple:
+		writeFloat(_data, record.clickRipple.rippleParams.amplitude);
+		writeFloat(_data, record.clickRipple.rippleParams.frequency);
+		writeFloat(_data, record.clickRipple.rippleParams.density);
+		writeFloat(_data, record.clickRipple.rippleParams.pos.x);
+		writeFloat(_data, record.clickRipple.rippleParams.pos.y);
+		writeFloat(_data, record.clickRipple.startTime);
+		writeFloat(_data, record.clickRipple.lifeTime);
+		break;
+	case WaterTraceEvent::HeightField:
+		writeFloat(_data, record.heightField.speed);
+		writeFloat(_data, record.heightField.damping);
+		writeFloat(_data, record.heightField.impulseRadius);
+		break;
+	case WaterTraceEvent::Wave:
+		writeFloat(_data, record.wave.amplitude);
+		writeFloat(_data, record.wave.frequency);
+		writeFloat(_data, record.wave.density);
+		writeFloat(_data, record.wave.angle);
+		writeFloat(_data, record.wave.phi);
+		break;
+	case WaterTraceEvent::FixedRipple:
+		writeFloat(_data, record.ripple.amplitude);
+		writeFloat(_data, record.ripple.frequency);
+		writeFloat(_data, record.ripple.density);
+		writeFloat(_data, record.ripple.pos.x);
+		writeFloat(_data, record.ripple.pos.y);
+		break;
+	case WaterTraceEvent::InitGrid:
+		writeUint(_data, static_cast<uint32_t>(record.gridSize));
+		writeFloat(_data, record.width);
+		writeFloat(_data, record.height);
+		break;
+	case WaterTraceEvent::Resize:
+		writeFloat(_data, record.width);
+		writeFloat(_data, record.height);
+		break;
+	case WaterTraceEvent::Click:
+		writeFloat(_data, record.pos.x);
+		writeFloat(_data, record.pos.y);
+		writeFloat(_data, record.time);
+		break;
+	case WaterTraceEvent::Impulse:
+		writeFloat(_data, record.pos.x);
+		writeFloat(_data, record.pos.y);
+		writeFloat(_data, record.amplitude);
+		writeFloat(_data, record.radius);
+		break;
+	case WaterTraceEvent::Frame:
+		writeFloat(_data, record.time);
+		break;
+	case WaterTraceEvent::Pipelined:
+		_data.push_back(record.pipelined ? 1 : 0);
+		break;
+	case WaterTraceEvent::Quadtree:
+		_data.push_back(record.quadtree.enabled ? 1 : 0);
+		writeUint(_data, static_cast<uint32_t>(record.quadtree.levels));
+		writeFloat(_data, record.quadtree.tolerance);
+		writeFloat(_data, record.quadtree.refineInterval);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief 记录当前的全部波纹参数
+ * @param field 水波纹对象
+ * @details 依次写入 ClearParams、Settings、Light、DefaultClickRipple、HeightField 以及每个直线波纹和固定波纹；
+ * 重放时会清除已有的点击波纹，应在网格初始化后、开始点击前调用
+ */
+void WaterTraceRecorder::recordParams(const WaterField& field)
+{
+	const WaterEffectParams& params = field.getParams();
+	WaterTraceRecord entry;
+	entry.event = WaterTraceEvent::ClearParams;
+	record(entry);
+	recordSettings(field);
+
+	entry.event = WaterTraceEvent::Light;
+	entry.light = params.light;
+	record(entry);
+	entry.event = WaterTraceEvent::DefaultClickRipple;
+	entry.clickRipple = params.defaultClickRipple;
+	record(entry);
+	entry.event = WaterTraceEvent::HeightField;
+	entry.heightField = params.heightField;
+	record(entry);
+	for (auto& iter : params.waves)
+	{
+		entry.event = WaterTraceEvent::Wave;
+		entry.wave = iter.basicParams;
+		record(entry);
+	}
+	for (auto& iter : params.fixedRipples)
+	{
+		entry.event = WaterTraceEvent::FixedRipple;
+		entry.ripple = iter;
+		record(entry);
+	}
+}
+
+/**
+ * @brief 记录当前的模拟设置
+ * @param field 水波纹对象
+ * @details 只写入 Settings，不影响已有的波纹；修改点击波纹模拟方式、模拟频率等设置后调用
+ */
+void WaterTraceRecorder::recordSettings(const WaterField& field)
+{
+	const WaterEffectParams& params = field.getParams();
+	WaterTraceRecord entry;
+	entry.event = WaterTraceEvent::Settings;
+	entry.settings.maxClickRipple = params.maxClickRipple;
+	entry.settings.clickRippleOverflow = params.clickRippleOverflow;
+	entry.settings.clickRippleEpsilon = params.clickRippleEpsilon;
+	entry.settings.tileEpsilon = params.tileEpsilon;
+	entry.settings.simulationRate = field.getSimulationRate();
+	entry.settings.clickRippleEngine = field.getClickRippleEngine();
+	entry.settings.precision = field.getPrecision();
+	record(entry);
+}
+
+/**
+ * @brief 记录网格初始化
+ * @param gridSize 网格尺寸
+ * @param width 绘制区域宽度
+ * @param height 绘制区域高度
+ */
+void WaterTraceRecorder::recordInitGrid(int gridSize, float width, float height)
+{
+	WaterTraceRecord entry;
+	entry.event = WaterTraceEvent::InitGrid;
+	entry.gridSize = gridSize;
+	entry.width = width;
+	entry.height = height;
+	record(entry);
+}
+
+/**
+ * @brief 记录绘制区域尺寸变化
+ * @param width 新的绘制区域宽度
+ * @param height 新的绘制区域高度
+ */
+void WaterTraceRecorder::recordResize(float width, float height)
+{
+	WaterTraceRecord entry;
+	entry.event = WaterTraceEvent::Resize;
+	entry.width = width;
+	entry.height = height;
+	record(entry);
+}
+
+/**
+ * @brief 记录默认点击波纹
+ * @param x X坐标
+ * @param y Y坐标
+ * @param time 起始时间（秒）
+ */
+void WaterTraceRecorder::recordClick(float x, float y, float time)
+{
+	WaterTraceRecord entry;
+	entry.event = WaterTraceEvent::Click;
+	entry.pos = { x, y };
+	entry.time = time;
+	record(entry);
+}
+
+/**
+ * @brief 记录高度场冲击
+ * @param x X坐标
+ * @param y Y坐标
+ * @param amplitude 振幅
+ * @param radius 半径
+ */
+void WaterTraceRecorder::recordImpulse(float x, float y, float amplitude, float radius)
+{
+	WaterTraceRecord entry;
+	entry.event = WaterTraceEvent::Impulse;
+	entry.pos = { x, y };
+	entry.amplitude = amplitude;
+	entry.radius = radius;
+	record(entry);
+}
+
+/**
+ * @brief 记录一帧
+ * @param time 传给 renderEffect 的时间（秒）
+ */
+void WaterTraceRecorder::recordFrame(float time)
+{
+	WaterTraceRecord entry;
+	entry.event = WaterTraceEvent::Frame;
+	entry.time = time;
+	record(entry);
+}
+
+/**
+ * @brief 记录流水线模式的切换
+ * @param enabled 是否启用
+ * @details 流水线模式使画面晚一帧，重放时必须在同一位置切换才能得到相同的输出
+ */
+void WaterTraceRecorder::recordPipelined(bool enabled)
+{
+	WaterTraceRecord entry;
+	entry.event = WaterTraceEvent::Pipelined;
+	entry.pipelined = enabled;
+	record(entry);
+}
+
+/**
+ * @brief 记录自适应网格参数的变化
+ * @param params 自适应网格参数
+ * @details 自适应网格改变顶点，重放时必须在同一位置切换才能得到相同的输出
+ */
+void WaterTraceRecorder::recordQuadtree(const WaterQuadtreeMeshParams& params)
+{
+	WaterTraceRecord entry;
+	entry.event = WaterTraceEvent::Quadtree;
+	entry.quadtree = params;
+	record(entry);
+}
+
+/**
+ * @brief 获取轨迹数据
+ * @return 二进制轨迹
+ */
+const std::vector<uint8_t>& WaterTraceRecorder::getData() const
+{
+	return _data;
+}
+
+/**
+ * @brief 保存到文件
+ * @param path 文件路径
+ * @return 写入成功返回true
+ */
+bool WaterTraceRecorder::save(const char* path) const
+{
+	FILE* file = std::fopen(path, "wb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+	bool ok = std::fwrite(_data.data(), 1, _data.size(), file) == _data.size();
+	return std::fclose(file) == 0 && ok;
+}
+
+/**
+ * @brief 从内存加载轨迹
+ * @param data 二进制轨迹
+ * @return 标识正确且版本不高于当前版本时返回true
+ */
+bool WaterTracePlayer::load(const std::vector<uint8_t>& data)
+{
+	_data = data;
+	_position = 0;
+	size_t headerSize = sizeof(kTraceMagic) + 4;
+	if (_data.size() < headerSize || std::memcmp(_data.data(), kTraceMagic, sizeof(kTraceMagic)) != 0)
+	{
+		_data.clear();
+		return false;
+	}
+	_position = sizeof(kTraceMagic);
+	Reader reader = { _data, _position };
+	uint32_t version = reader.readUint();
+	if (version == 0 || version > kTraceVersion)
+	{
+		_data.clear();
+		_position = 0;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief 从文件加载轨迹
+ * @param path 文件路径
+ * @return 读取成功、标识正确且版本不高于当前版本时返回true
+ */
+bool WaterTracePlayer::load(const char* path)
+{
+	FILE* file = std::fopen(path, "rb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+	std::vector<uint8_t> data;
+	uint8_t buffer[4096];
+	size_t count;
+	while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + count);
+	}
+	std::fclose(file);
+	return load(data);
+}
+
+/**
+ * @brief 回到第一条记录
+ */
+void WaterTracePlayer::rewind()
+{
+	_position = _data.empty() ? 0 : sizeof(kTraceMagic) + 4;
+}
+
+/**
+ * @brief 读取下一条记录
+ * @param record 输出
+ * @return 没有更多记录或数据不完整时返回false
+ */
+bool WaterTracePlayer::next(WaterTraceRecord& record)
+{
+	if (_position >= _data.size())
+	{
+		return false;
+	}
+	Reader reader = { _data, _position };
+	uint8_t event = reader.readByte();
+	if (event >= static_cast<uint8_t>(WaterTraceEvent::Count))
+	{
+		_position = _data.size();
+		return false;
+	}
+	record.event = static_cast<WaterTraceEvent>(event);
+	switch (record.event)
+	{
+	case WaterTraceEvent::Settings:
+		record.settings.maxClickRipple = static_cast<int>(reader.readUint());
+		record.settings.clickRippleOverflow = static_cast<WaterClickRippleOverflow>(reader.readByte());
+		record.settings.clickRippleEpsilon = reader.readFloat();
+		record.settings.tileEpsilon = reader.readFloat();
+		record.settings.simulationRate = reader.readFloat();
+		record.settings.clickRippleEngine = static_cast<WaterClickRippleEngine>(reader.readByte());
+		record.settings.precision = static_cast<WaterKernel::Precision>(reader.readByte());
+		break;
+	case WaterTraceEvent::Light:
+		record.light.minDistance = reader.readFloat();
+		record.light.defaultAlpha = reader.readFloat();
+		record.light.minAlpha = reader.readFloat();
+		record.light.decay = reader.readFloat();
+		record.light.angle = reader.readFloat();
+		record.light.mode = static_cast<WaterLightingMode>(reader.readByte());
+		record.light.referenceInterval = reader.readFloat();
+		break;
+	case WaterTraceEvent::DefaultClickRipple:
+		record.clickRipple.rippleParams.amplitude = reader.readFloat();
+		record.clickRipple.rippleParams.frequency = reader.readFloat();
+		record.clickRipple.rippleParams.density = reader.readFloat();
+		record.clickRipple.rippleParams.pos.x = reader.readFloat();
+		record.clickRipple.rippleParams.pos.y = reader.readFloat();
+		record.clickRipple.startTime = reader.readFloat();
+		record.clickRipple.lifeTime = reader.readFloat();
+		break;
+	case WaterTraceEvent::HeightField:
+		record.heightField.speed = reader.readFloat();
+		record.heightField.damping = reader.readFloat();
+		record.heightField.impulseRadius = reader.readFloat();
+		break;
+	case WaterTraceEvent::Wave:
+		record.wave.amplitude = reader.readFloat();
+		record.wave.frequency = reader.readFloat();
+		record.wave.density = reader.readFloat();
+		record.wave.angle = reader.readFloat();
+		record.wave.phi = reader.readFloat();
+		break;
+	case WaterTraceEvent::FixedRipple:
+		record.ripple.amplitude = reader.readFloat();
+		record.ripple.frequency = reader.readFloat();
+		record.ripple.density = reader.readFloat();
+		record.ripple.pos.x = reader.readFloat();
+		record.ripple.pos.y = reader.readFloat();
+		break;
+	case WaterTraceEvent::InitGrid:
+		record.gridSize = static_cast<int>(reader.readUint());
+		record.width = reader.readFloat();
+		record.height = reader.readFloat();
+		break;
+	case WaterTraceEvent::Resize:
+		record.width = reader.readFloat();
+		record.height = reader.readFloat();
+		break;
+	case WaterTraceEvent::Click:
+		record.pos.x = reader.readFloat();
+		record.pos.y = reader.readFloat();
+		record.time = reader.readFloat();
+		break;
+	case WaterTraceEvent::Impulse:
+		record.pos.x = reader.readFloat();
+		record.pos.y = reader.readFloat();
+		record.amplitude = reader.readFloat();
+		record.radius = reader.readFloat();
+		break;
+	case WaterTraceEvent::Frame:
+		record.time = reader.readFloat();
+		break;
+	case WaterTraceEvent::Pipelined:
+		record.pipelined = reader.readByte() != 0;
+		break;
+	case WaterTraceEvent::Quadtree:
+		record.quadtree.enabled = reader.readByte() != 0;
+		record.quadtree.levels = static_cast<int>(reader.readUint());
+		record.quadtree.tolerance = reader.readFloat();
+		record.quadtree.refineInterval = reader.readFloat();
+		break;
+	default:
+		break;
+	}
+	if (!reader.ok)
+	{
+		_position = _data.size();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief 把参数类和输入类记录应用到水波纹对象
+ * @param field 水波纹对象
+ * @param record 记录
+ * @return 已应用返回true；InitGrid、Resize、Frame 和 Pipelined 需要由调用方按所用的渲染适配层处理，返回false
+ */
+bool WaterTracePlayer::apply(WaterField& field, const WaterTraceRecord& record)
+{
+	switch (record.event)
+	{
+	case WaterTraceEvent::ClearParams:
+		field.clearParams();
+		return true;
+	case WaterTraceEvent::Settings:
+		field.setMaxClickRipple(record.settings.maxClickRipple);
+		field.setClickRippleOverflow(record.settings.clickRippleOverflow);
+		field.setClickRippleEpsilon(record.settings.clickRippleEpsilon);
+		field.setTileEpsilon(record.settings.tileEpsilon);
+		if (field.getSimulationRate() != record.settings.simulationRate)
+		{
+			field.setSimulationRate(record.settings.simulationRate);
+		}
+		field.setPrecision(record.settings.precision);
+		field.setClickRippleEngine(record.settings.clickRippleEngine);
+		return true;
+	case WaterTraceEvent::Light:
+		field.setLightParams(record.light);
+		return true;
+	case WaterTraceEvent::DefaultClickRipple:
+		field.setDefaultClickRippleParams(record.clickRipple);
+		return true;
+	case WaterTraceEvent::HeightField:
+		field.setHeightFieldParams(record.heightField);
+		return true;
+	case WaterTraceEvent::Wave:
+		field.addWave(record.wave);
+		return true;
+	case WaterTraceEvent::FixedRipple:
+		field.addFixedRipple(record.ripple);
+		return true;
+	case WaterTraceEvent::Click:
+		field.addDefaultClickRipple(record.pos.x, record.pos.y, record.time);
+		return true;
+	case WaterTraceEvent::Impulse:
+		field.addImpulse(record.pos.x, record.pos.y, record.amplitude, record.radius);
+		return true;
+	case WaterTraceEvent::Quadtree:
+		field.setQuadtreeMeshParams(record.quadtree);
+		return true;
+	default:
+		return false;
+	}
+}
@@ -0,0 +1,220 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include "WaterField.h"
+
+
+/**
+ * @enum WaterTraceEvent
+ * @brief 轨迹中的记录类型
+ */
+enum class WaterTraceEvent : uint8_t
+{
+	ClearParams,			///< clearParams()
+	Settings,				///< 波纹数量上限、裁剪阈值、模拟频率、点击波纹模拟方式和精度
+	Light,					///< setLightParams(light)
+	DefaultClickRipple,		///< setDefaultClickRippleParams(clickRipple)
+	HeightField,			///< setHeightFieldParams(heightField)
+	Wave,					///< addWave(wave)
+	FixedRipple,			///< addFixedRipple(ripple)
+	InitGrid,				///< initGrid(gridSize, width, height)
+	Resize,					///< resize(width, height)
+	Click,					///< addDefaultClickRipple(pos.x, pos.y, time)
+	Impulse,				///< addImpulse(pos.x, pos.y, amplitude, radius)
+	Frame,					///< 以 time 渲染一帧
+	Pipelined,				///< WaterEffect::setPipelined(pipelined)
+	Quadtree,				///< setQuadtreeMeshParams(quadtree)
+	Count,
+};
+
+/**
+ * @struct WaterTraceSettings
+ * @brief 不属于波纹列表的模拟设置
+ */
+struct WaterTraceSettings
+{
+	int maxClickRipple = 5;															///< 点击波纹数量上限
+	WaterClickRippleOverflow clickRippleOverflow = WaterClickRippleOverflow::DropNewest;	///< 点击波纹达到上限时的处理策略
+	float clickRippleEpsilon = 0.01f;												///< 点击波纹裁剪阈值
+	float tileEpsilon = 0.01f;														///< 分块跳过阈值
+	float simulationRate = 0.0f;													///< 模拟频率
+	WaterClickRippleEngine clickRippleEngine = WaterClickRippleEngine::Analytic;	///< 点击波纹模拟方式
+	WaterKernel::Precision precision = WaterKernel::Precision::Fast;				///< 内核精度
+};
+
+/**
+ * @struct WaterTraceRecord
+ * @brief 一条轨迹记录
+ * @details 只有与 event 对应的字段有效
+ */
+struct WaterTraceRecord
+{
+	WaterTraceEvent event = WaterTraceEvent::Frame;
+	float time = 0.0f;						///< Click、Frame 的时间（秒）
+	WaterPoint pos;							///< Click、Impulse 的位置
+	float amplitude = 0.0f;					///< Impulse 的振幅
+	float radius = 0.0f;					///< Impulse 的半径
+	int gridSize = 0;						///< InitGrid 的网格尺寸
+	float width = 0.0f;						///< InitGrid、Resize 的绘制区域宽度
+	float height = 0.0f;					///< InitGrid、Resize 的绘制区域高度
+	WaterTraceSettings settings;			///< Settings
+	WaterLightParams light;					///< Light
+	WaterClickRippleParams clickRipple;		///< DefaultClickRipple
+	WaterHeightFieldParams heightField;		///< HeightField
+	WaterWaveParams wave;					///< Wave
+	WaterRippleParams ripple;				///< FixedRipple
+	bool pipelined = false;					///< Pipelined
+	WaterQuadtreeMeshParams quadtree;		///< Quadtree
+};
+
+/**
+ * @class WaterTraceRecorder
+ * @brief 把参数变化、点击和帧时间记录为紧凑的二进制轨迹
+ * @details 轨迹以4字节标识和版本号开头，之后每条记录为1字节类型加上固定长度的小端数据（帧记录共5字节）。
+ * 与 WaterTracePlayer 配合，可以在无窗口的环境中按原始时间重放同样的输入，得到逐位相同的顶点输出
+ */
+class WaterTraceRecorder
+{
+public:
+
+	/**
+	 * @brief 创建空轨迹
+	 */
+	WaterTraceRecorder();
+
+	/**
+	 * @brief 添加一条记录
+	 * @param record 记录
+	 */
+	void record(const WaterTraceRecord& record);
+
+	/**
+	 * @brief 记录当前的全部波纹参数
+	 * @param field 水波纹对象
+	 * @details 依次写入 ClearParams、Settings、Light、DefaultClickRipple、HeightField 以及每个直线波纹和固定波纹；
+	 * 重放时会清除已有的点击波纹，应在网格初始化后、开始点击前调用
+	 */
+	void recordParams(const WaterField& field);
+
+	/**
+	 * @brief 记录当前的模拟设置
+	 * @param field 水波纹对象
+	 * @details 只写入 Settings，不影响已有的波纹；修改点击波纹模拟方式、模拟频率等设置后调用
+	 */
+	void recordSettings(const WaterField& field);
+
+	/**
+	 * @brief 记录网格初始化
+	 * @param gridSize 网格尺寸
+	 * @param width 绘制区域宽度
+	 * @param height 绘制区域高度
+	 */
+	void recordInitGrid(int gridSize, float width, float height);
+
+	/**
+	 * @brief 记录绘制区域尺寸变化
+	 * @param width 新的绘制区域宽度
+	 * @param height 新的绘制区域高度
+	 */
+	void recordResize(float width, float height);
+
+	/**
+	 * @brief 记录默认点击波纹
+	 * @param x X坐标
+	 * @param y Y坐标
+	 * @param time 起始时间（秒）
+	 */
+	void recordClick(float x, float y, float time);
+
+	/**
+	 * @brief 记录高度场冲击
+	 * @param x X坐标
+	 * @param y Y坐标
+	 * @param amplitude 振幅
+	 * @param radius 半径
+	 */
+	void recordImpulse(float x, float y, float amplitude, float radius);
+
+	/**
+	 * @brief 记录一帧
+	 * @param time 传给 renderEffect 的时间（秒）
+	 */
+	void recordFrame(float time);
+
+	/**
+	 * @brief 记录流水线模式的切换
+	 * @param enabled 是否启用
+	 * @details 流水线模式使画面晚一帧，重放时必须在同一位置切换才能得到相同的输出
+	 */
+	void recordPipelined(bool enabled);
+
+	/**
+	 * @brief 记录自适应网格参数的变化
+	 * @param params 自适应网格参数
+	 * @details 自适应网格改变顶点，重放时必须在同一位置切换才能得到相同的输出
+	 */
+	void recordQuadtree(const WaterQuadtreeMeshParams& params);
+
+	/**
+	 * @brief 获取轨迹数据
+	 * @return 二进制轨迹
+	 */
+	const std::vector<uint8_t>& getData() const;
+
+	/**
+	 * @brief 保存到文件
+	 * @param path 文件路径
+	 * @return 写入成功返回true
+	 */
+	bool save(const char* path) const;
+
+private:
+	std::vector<uint8_t> _data;
+};
+
+/**
+ * @class WaterTracePlayer
+ * @brief 读取 WaterTraceRecorder 生成的轨迹
+ */
+class WaterTracePlayer
+{
+public:
+
+	/**
+	 * @brief 从内存加载轨迹
+	 * @param data 二进制轨迹
+	 * @return 标识正确且版本不高于当前版本时返回true
+	 */
+	bool load(const std::vector<uint8_t>& data);
+
+	/**
+	 * @brief 从文件加载轨迹
+	 * @param path 文件路径
+	 * @return 读取成功、标识正确且版本不高于当前版本时返回true
+	 */
+	bool load(const char* path);
+
+	/**
+	 * @brief 回到第一条记录
+	 */
+	void rewind();
+
+	/**
+	 * @brief 读取下一条记录
+	 * @param record 输出
+	 * @return 没有更多记录或数据不完整时返回false
+	 */
+	bool next(WaterTraceRecord& record);
+
+	/**
+	 * @brief 把参数类和输入类记录应用到水波纹对象
+	 * @param field 水波纹对象
+	 * @param record 记录
+	 * @return 已应用返回true；InitGrid、Resize、Frame 和 Pipelined 需要由调用方按所用的渲染适配层处理，返回false
+	 */
+	static bool apply(WaterField& field, const WaterTraceRecord& record);
+
+private:
+	std::vector<uint8_t> _data;
+	size_t _position = 0;
+};
@@ -0,0 +1,382 @@
+﻿/**
+ * @file WaterTraceReplay.cpp
+ * @brief 无窗口重放 WaterTraceRecorder 录制的轨迹
+ * @details 使用 SDL 的 offscreen 视频驱动和软件渲染器（可用 --renderer 指定其他渲染器）创建隐藏窗口，
+ * 按轨迹中的参数变化、点击和帧时间驱动 WaterEffect，不等待垂直同步，尽快完成全部帧。
+ * 每帧计时 renderEffect（顶点更新和几何体提交），随后调用 SDL_RenderPresent 执行渲染命令（不计入耗时）。
+ * 每帧把顶点位置和颜色按字节计入 FNV-1a 校验和，用来确认优化没有改变输出：
+ * 同一指令集路径和精度下结果应逐位相同，不同的 Fast 路径之间允许存在 WaterKernel::kTolerance 以内的差异。
+ * 每次重复都创建新的 WaterEffect，结果以CSV输出到标准输出。
+ *
+ * 构建（Linux/macOS）：
+ *   g++ -O2 -std=c++17 -o WaterTraceReplay WaterTraceReplay.cpp WaterTrace.cpp WaterEffect.cpp WaterField.cpp WaterStats.cpp
+ *       WaterKernel.cpp WaterKernelPortable.cpp WaterKernelSSE2.cpp WaterKernelAVX2.cpp WaterThreadPool.cpp WaterQuadtreeMesh.cpp
+ *       $(pkg-config --cflags --libs sdl3)
+ *
+ * 用法：
+ *   WaterTraceReplay --trace trace.bin [--repeat 1] [--threads 1] [--isa scalar|sse2|avx2] [--precision precise|fast]
+ *                    [--pipelined off|on] [--quadtree off|on] [--renderer software] [--expect 0123456789abcdef]
+ *
+ * --pipelined on 启用 WaterEffect::setPipelined，点击晚一帧生效，校验和与关闭时不同；它只是初始设置，
+ * 轨迹中录制的 Pipelined 记录在对应位置切换流水线模式。
+ * --quadtree on 以默认参数启用自适应网格（WaterField::setQuadtreeMeshParams），顶点不同，校验和与关闭时不同；
+ * 它同样只是初始设置，轨迹中录制的 Quadtree 记录在对应位置替换自适应网格参数。
+ * 指定 --expect 时，任何一次重复的校验和与之不同返回1；多次重复之间的校验和不同同样返回1
+ */
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <SDL3/SDL.h>
+#include "WaterEffect.h"
+#include "WaterTrace.h"
+
+namespace
+{
+	constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+	constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+	/**
+	 * @struct Options
+	 * @brief 命令行参数
+	 */
+	struct Options
+	{
+		const char* trace = nullptr;
+		const char* renderer = SDL_SOFTWARE_RENDERER;
+		int repeat = 1;
+		int threads = 1;
+		bool pipelined = false;
+		bool quadtree = false;
+		WaterKernel::Isa isa = WaterKernel::detectIsa();
+		bool precisionSet = false;
+		WaterKernel::Precision precision = WaterKernel::Precision::Fast;
+		bool expectSet = false;
+		uint64_t expect = 0;
+	};
+
+	/**
+	 * @struct Result
+	 * @brief 一次重放的结果
+	 */
+	struct Result
+	{
+		size_t frames = 0;
+		double totalMs = 0.0;
+		double meanMs = 0.0;
+		double medianMs = 0.0;
+		double p99Ms = 0.0;
+		double maxMs = 0.0;
+		uint64_t checksum = kFnvOffset;
+	};
+
+	/**
+	 * @brief 把一段内存计入 FNV-1a 校验和
+	 * @param hash 当前校验和
+	 * @param data 数据
+	 * @param bytes 字节数
+	 * @return 新的校验和
+	 */
+	uint64_t checksum(uint64_t hash, const void* data, size_t bytes)
+	{
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < bytes; i++)
+		{
+			hash = (hash ^ p[i]) * kFnvPrime;
+		}
+		return hash;
+	}
+
+	/**
+	 * @brief 解析正整数
+	 * @param text 输入文本
+	 * @param value 输出
+	 * @return 格式正确返回true
+	 */
+	bool parsePositive(const char* text, int& value)
+	{
+		char* end = nullptr;
+		long parsed = std::strtol(text, &end, 10);
+		if (*text == '\0' || *end != '\0' || parsed <= 0)
+		{
+			return false;
+		}
+		value = static_cast<int>(parsed);
+		return true;
+	}
+
+	/**
+	 * @brief 解析命令行参数
+	 * @param argc 参数数量
+	 * @param argv 参数数组
+	 * @param options 输出
+	 * @return 参数正确返回true
+	 */
+	bool parseOptions(int argc, char* argv[], Options& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const char* arg = argv[i];
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+			if (value == nullptr)
+			{
+				return false;
+			}
+			i++;
+			if (std::strcmp(arg, "--trace") == 0)
+			{
+				options.trace = value;
+			}
+			else if (std::strcmp(arg, "--renderer") == 0)
+			{
+				options.renderer = value;
+			}
+			else if (std::strcmp(arg, "--repeat") == 0)
+			{
+				if (!parsePositive(value, options.repeat))
+				{
+					return false;
+				}
+			}
+			else if (std::strcmp(arg, "--threads") == 0)
+			{
+				if (!parsePositive(value, options.threads))
+				{
+					return false;
+				}
+			}
+			else if (std::strcmp(arg, "--pipelined") == 0)
+			{
+				if (std::strcmp(value, "on") != 0 && std::strcmp(value, "off") != 0)
+				{
+					return false;
+				}
+				options.pipelined = std::strcmp(value, "on") == 0;
+			}
+			else if (std::strcmp(arg, "--quadtree") == 0)
+			{
+				if (std::strcmp(value, "on") != 0 && std::strcmp(value, "off") != 0)
+				{
+					return false;
+				}
+				options.quadtree = std::strcmp(value, "on") == 0;
+			}
+			else if (std::strcmp(arg, "--isa") == 0)
+			{
+				bool found = false;
+				for (WaterKernel::Isa isa : { WaterKernel::Isa::Scalar, WaterKernel::Isa::SSE2, WaterKernel::Isa::AVX2 })
+				{
+					if (std::strcmp(value, WaterKernel::isaName(isa)) == 0)
+					{
+						options.isa = isa;
+						found = true;
+					}
+				}
+				if (!found)
+				{
+					return false;
+				}
+				if (!WaterKernel::isIsaSupported(options.isa))
+				{
+					std::fprintf(stderr, "%s is not supported by this CPU\n", value);
+					return false;
+				}
+			}
+			else if (std::strcmp(arg, "--precision") == 0)
+			{
+				if (std::strcmp(value, "precise") != 0 && std::strcmp(value, "fast") != 0)
+				{
+					return false;
+				}
+				options.precisionSet = true;
+				options.precision = std::strcmp(value, "precise") == 0 ? WaterKernel::Precision::Precise : WaterKernel::Precision::Fast;
+			}
+			else if (std::strcmp(arg, "--expect") == 0)
+			{
+				char* end = nullptr;
+				options.expect = std::strtoull(value, &end, 16);
+				if (*value == '\0' || *end != '\0')
+				{
+					return false;
+				}
+				options.expectSet = true;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return options.trace != nullptr;
+	}
+
+	/**
+	 * @brief 重放一次轨迹
+	 * @param player 已加载的轨迹
+	 * @param options 命令行参数
+	 * @param window 隐藏窗口
+	 * @param renderer 渲染器
+	 * @param result 输出
+	 */
+	void replay(WaterTracePlayer& player, const Options& options, SDL_Window* window, SDL_Renderer* renderer, Result& result)
+	{
+		WaterEffect effect(window, renderer);
+		effect.setKernelIsa(options.isa);
+		effect.setThreadCount(options.threads);
+		effect.setPipelined(options.pipelined);
+		if (options.quadtree)
+		{
+			WaterQuadtreeMeshParams quadtree;
+			quadtree.enabled = true;
+			effect.setQuadtreeMeshParams(quadtree);
+		}
+		if (options.precisionSet)
+		{
+			effect.setPrecision(options.precision);
+		}
+
+		std::vector<double> frameMs;
+		player.rewind();
+		WaterTraceRecord record;
+		while (player.next(record))
+		{
+			if (WaterTracePlayer::apply(effect, record))
+			{
+				// 命令行指定的精度优先于轨迹中的设置
+				if (record.event == WaterTraceEvent::Settings && options.precisionSet)
+				{
+					effect.setPrecision(options.precision);
+				}
+				continue;
+			}
+			if (record.event == WaterTraceEvent::InitGrid)
+			{
+				effect.initGrid(record.gridSize, static_cast<int>(record.width), static_cast<int>(record.height));
+			}
+			else if (record.event == WaterTraceEvent::Resize)
+			{
+				effect.resize(static_cast<int>(record.width), static_cast<int>(record.height));
+			}
+			else if (record.event == WaterTraceEvent::Pipelined)
+			{
+				effect.setPipelined(record.pipelined);
+			}
+			else if (record.event == WaterTraceEvent::Frame)
+			{
+				effect.setupEffectCanvas();
+				auto start = std::chrono::steady_clock::now();
+				effect.renderEffect(record.time);
+				frameMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+				SDL_RenderPresent(renderer);
+
+				const std::vector<SDL_FPoint>& positions = effect.getMeshPositions();
+				const std::vector<SDL_FColor>& colors = effect.getMeshColors();
+				result.checksum = checksum(result.checksum, positions.data(), positions.size() * sizeof(SDL_FPoint));
+				result.checksum = checksum(result.checksum, colors.data(), colors.size() * sizeof(SDL_FColor));
+			}
+		}
+
+		result.frames = frameMs.size();
+		if (frameMs.empty())
+		{
+			return;
+		}
+		for (double ms : frameMs)
+		{
+			result.totalMs += ms;
+		}
+		result.meanMs = result.totalMs / frameMs.size();
+		std::sort(frameMs.begin(), frameMs.end());
+		result.medianMs = frameMs[frameMs.size() / 2];
+		result.p99Ms = frameMs[(frameMs.size() * 99 + 99) / 100 - 1];
+		result.maxMs = frameMs.back();
+	}
+
+	/**
+	 * @brief 输出用法说明
+	 */
+	void printUsage()
+	{
+		std::fprintf(stderr,
+			"usage: WaterTraceReplay --trace trace.bin [--repeat 1] [--threads 1] [--isa scalar|sse2|avx2] [--precision precise|fast]\n"
+			"                        [--pipelined off|on] [--quadtree off|on] [--renderer software] [--expect 0123456789abcdef]\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printUsage();
+		return 1;
+	}
+	WaterTracePlayer player;
+	if (!player.load(options.trace))
+	{
+		std::fprintf(stderr, "cannot load trace %s\n", options.trace);
+		return 1;
+	}
+
+	// 画布尺寸取第一条 InitGrid 记录，窗口只用来创建渲染器
+	int width = 1600;
+	int height = 900;
+	WaterTraceRecord record;
+	while (player.next(record))
+	{
+		if (record.event == WaterTraceEvent::InitGrid)
+		{
+			width = static_cast<int>(record.width);
+			height = static_cast<int>(record.height);
+			break;
+		}
+	}
+
+	SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+	if (!SDL_Init(SDL_INIT_VIDEO))
+	{
+		std::fprintf(stderr, "SDL initialization failed: %s\n", SDL_GetError());
+		return 1;
+	}
+	SDL_Window* window = SDL_CreateWindow("WaterTraceReplay", width, height, SDL_WINDOW_HIDDEN);
+	SDL_Renderer* renderer = window != nullptr ? SDL_CreateRenderer(window, options.renderer) : nullptr;
+	if (renderer == nullptr)
+	{
+		std::fprintf(stderr, "SDL window and renderer creation failed: %s\n", SDL_GetError());
+		SDL_Quit();
+		return 1;
+	}
+
+	std::printf("repeat,isa,threads,frames,total_ms,mean_ms,median_ms,p99_ms,max_ms,checksum\n");
+	bool passed = true;
+	uint64_t firstChecksum = 0;
+	for (int i = 0; i < options.repeat; i++)
+	{
+		Result result;
+		replay(player, options, window, renderer, result);
+		std::printf("%d,%s,%d,%zu,%.3f,%.4f,%.4f,%.4f,%.4f,%016" PRIx64 "\n",
+			i, WaterKernel::isaName(options.isa), options.threads, result.frames, result.totalMs, result.meanMs, result.medianMs, result.p99Ms, result.maxMs, result.checksum);
+		std::fflush(stdout);
+		if (i == 0)
+		{
+			firstChecksum = result.checksum;
+		}
+		else if (result.checksum != firstChecksum)
+		{
+			std::fprintf(stderr, "repeat %d checksum differs from repeat 0\n", i);
+			passed = false;
+		}
+		if (options.expectSet && result.checksum != options.expect)
+		{
+			std::fprintf(stderr, "repeat %d checksum %016" PRIx64 " does not match expected %016" PRIx64 "\n", i, result.checksum, options.expect);
+			passed = false;
+		}
+	}
+
+	SDL_DestroyRenderer(renderer);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	return passed ? 0 : 1;
+}